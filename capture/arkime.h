@@ -55,7 +55,7 @@
 #endif
 #define ARKIME_CACHE_ALIGN __attribute__((aligned(ARKIME_CACHE_LINE_SIZE)))
 
-#define ARKIME_API_VERSION 607
+#define ARKIME_API_VERSION 608
 
 #define ARKIME_SESSIONID_LEN  40
 #define ARKIME_SESSIONID6_LEN 40
@@ -228,6 +228,12 @@ typedef struct arkime_field_info {
     int16_t                   dbGroupNum;
     char                     *dbGroup;
     int16_t                   dbGroupLen;
+    char                     *jsonKey;         /* "dbField": precomputed for db.c */
+    char                     *jsonCntKey;      /* "dbFieldCnt": */
+    char                     *jsonGroup;       /* "dbGroup":{ or NULL */
+    int16_t                   jsonKeyLen;
+    int16_t                   jsonCntKeyLen;
+    int16_t                   jsonGroupLen;
     char                     *group;
     char                     *kind;
     char                     *category;
@@ -325,7 +331,7 @@ typedef struct {
  * Instead, use jemalloc and increase the number of threads used for reading packets.
  * https://arkime.com/faq#why-am-i-dropping-packets
  */
-#define ARKIME_MAX_PACKET_THREADS 24
+#define ARKIME_MAX_PACKET_THREADS 256
 
 #define MAX_INTERFACES 32
 #define MAX_THREADS_PER_INTERFACE 12
@@ -595,10 +601,21 @@ struct arkime_pcap_sf_pkthdr {
 
 #define ARKIME_PACKET_LEN_FILE_DONE     1
 
+/* A reader buffer that packets point into without being copied, such as a
+ * tpacketv3 block.  Each packet holds a reference and release is called once
+ * the last packet using the block is freed or copied.
+ */
+typedef struct arkimepacketblock_t {
+    int            refs;
+    void         (*release)(struct arkimepacketblock_t *block);
+    void          *uw;
+} ArkimePacketBlock_t;
+
 typedef struct arkimepacket_t {
     struct arkimepacket_t   *packet_next, *packet_prev;
     struct timeval ts;                  // timestamp
     uint8_t       *pkt;                 // full packet
+    ArkimePacketBlock_t *block;         // reader block pkt points into, if not copied
     uint64_t       writerFilePos;       // where in output file
     uint64_t       readerFilePos;       // where in input file
     uint32_t       writerFileNum;       // file number in db
@@ -622,7 +639,9 @@ typedef struct arkimepacket_t {
     uint32_t       tunnelDepth: 4;      // nesting depth for tunnel dispatch (see ARKIME_PACKET_MAX_TUNNEL_DEPTH)
     uint32_t       ipOffset: 11;        // offset to ip header from start
     uint32_t       outerIpOffset: 11;   // offset to outer ip header from start
+    uint32_t       haveSessionId: 1;    // sessionId was filled in by the reader
     uint32_t       vni: 24;             // vxlan id
+    uint8_t        sessionId[ARKIME_SESSIONID_LEN]; // tcp/udp session id from ip decode, only valid if haveSessionId
 } ArkimePacket_t;
 
 // Maximum tunnel/encapsulation nesting depth across IP-in-IP, GRE, ERSPAN,
@@ -651,7 +670,7 @@ typedef enum {
 } ArkimePacketRC;
 
 typedef struct {
-    ArkimePacketHead_t    packetQ[ARKIME_MAX_PACKET_THREADS];
+    ArkimePacketHead_t   *packetQ; // config.packetThreads entries
     uint32_t              packetStats[ARKIME_PACKET_MAX];
     uint64_t              totalBytes;
     uint32_t              totalPackets;
@@ -704,19 +723,23 @@ typedef enum {
     ARKIME_TCPFLAG_MAX
 } ArkimeSesTcpFlags;
 /******************************************************************************/
+// Payload waiting for reassembly, the packet itself is freed once copied
 typedef struct arkime_tcp_data {
     struct arkime_tcp_data *td_next, *td_prev;
 
-    ArkimePacket_t *packet;
+    uint8_t        *data;
     uint32_t        seq;
     uint32_t        ack;
     uint16_t        len;
-    uint16_t        dataOffset;
+    uint16_t        size;           // Bytes allocated for data
+    uint16_t        packets;        // Packets appended into this segment
+    uint8_t         which;
 } ArkimeTcpData_t;
 
 typedef struct {
     struct arkime_tcp_data *td_next, *td_prev;
     int                     td_count;
+    uint32_t                tdPackets;      // Packets waiting in the td list, appended ones included
     uint32_t                synTime;
     uint32_t                ackTime;
     uint32_t                synSeq[2];
@@ -763,10 +786,25 @@ typedef struct arkime_sctp {
 #define ARKIME_SESSION_HASH_SLL 1
 // Doubly linked list - Original Arkime way
 #define ARKIME_SESSION_HASH_DLL 2
-// Open address with ctrl array and probe
+// Open address with ctrl array and SSE2 group probing (Swiss table)
 #define ARKIME_SESSION_HASH_CTRL_PROBE 3
 
+// Select at build time with make EXTRA_CFLAGS=-DARKIME_SESSION_HASH=ARKIME_SESSION_HASH_CTRL_PROBE
+#ifndef ARKIME_SESSION_HASH
 #define ARKIME_SESSION_HASH ARKIME_SESSION_HASH_SLL
+#endif
+
+/* Packet positions and lengths, stored as zigzag varint deltas from the previous
+ * value so a few packet session only uses a few dozen bytes.  Read them back in
+ * order with arkime_varint_next.
+ */
+typedef struct {
+    uint8_t               *buf;
+    uint32_t               len;
+    uint32_t               size;
+    uint32_t               cnt;
+    int64_t                last;
+} ArkimeVarintArray_t;
 
 typedef struct arkime_session {
     struct arkime_session *tcp_next, *tcp_prev;
@@ -781,7 +819,11 @@ typedef struct arkime_session {
 
     uint8_t                sessionId[ARKIME_SESSIONID_LEN];
 
-    ArkimeField_t        **fields;
+    // Only the fields that are set, sorted by pos, not indexed by pos.
+    // Use arkime_field_get, not these directly.
+    ArkimeField_t        **fieldsSparse;
+    uint16_t              *fieldsPos;
+    struct arkime_field_arena *fieldArena;
 
     void                  **pluginData;
 
@@ -792,8 +834,8 @@ typedef struct arkime_session {
         ArkimeSCTP_t           sctpData;
     };
 
-    GArray                *filePosArray;
-    GArray                *fileLenArray;
+    ArkimeVarintArray_t    filePosArray;
+    ArkimeVarintArray_t    fileLenArray;
     GArray                *fileNumArray;
     char                  *rootId;
     GHashTable            *pythonAttrs;
@@ -810,6 +852,7 @@ typedef struct arkime_session {
 
     uint32_t               ses_hash;
     uint32_t               lastFileNum;
+    uint32_t               pendingFilePos;  // Packets the writer hasn't added to filePosArray yet
     uint32_t               saveTime;
     uint32_t               packets[2];
 
@@ -822,7 +865,8 @@ typedef struct arkime_session {
         uint8_t                tcpFlagAckCnt[2];
         uint8_t                icmpInfo[2];
     };
-    uint16_t               maxFields;
+    uint16_t               fieldsCnt;
+    uint16_t               fieldsSize;
     uint16_t               ethertype;
 
     uint8_t                consumed[2];
@@ -874,6 +918,47 @@ typedef struct arkime_session_head {
     int                    ses_count;
 } ArkimeSessionHead_t;
 
+/******************************************************************************/
+/* Decode the next value after *off, *value must hold the previous value (start
+ * both at 0).  Returns FALSE at the end.
+ */
+static inline gboolean arkime_varint_next(const ArkimeVarintArray_t *va, uint32_t *off, int64_t *value)
+{
+    if (*off >= va->len)
+        return FALSE;
+
+    uint64_t zz = 0;
+    int      shift = 0;
+    uint8_t  b;
+    do {
+        b = va->buf[(*off)++];
+        zz |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    *value = (int64_t)((uint64_t)*value + ((zz >> 1) ^ -(zz & 1)));
+    return TRUE;
+}
+
+/******************************************************************************/
+/* Sessions usually only have a few dozen of the maxDbField fields set, so only
+ * those are stored, sorted by pos.  Returns NULL if pos isn't set.
+ */
+static inline ArkimeField_t *arkime_field_get(const ArkimeSession_t *session, int pos)
+{
+    int lo = 0, hi = session->fieldsCnt;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (session->fieldsPos[mid] < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < session->fieldsCnt && session->fieldsPos[lo] == pos)
+        return session->fieldsSparse[lo];
+    return NULL;
+}
+
 typedef struct {
     char                  *id;
     char                  *key;
@@ -1003,7 +1088,7 @@ typedef struct {
     time_t                       lastPacketSecs;
     ArkimeSessionHead_t          tcpWriteQ;
 } ARKIME_CACHE_ALIGN ArkimeThreadData_t;
-extern ArkimeThreadData_t arkimeThreadData[ARKIME_MAX_PACKET_THREADS];
+extern ArkimeThreadData_t *arkimeThreadData;
 
 // Return 0 if ready to quit
 typedef int (* ArkimeCanQuitFunc)();
@@ -1040,6 +1125,9 @@ void arkime_quit();
 
 uint32_t arkime_get_next_prime(uint32_t v);
 uint32_t arkime_get_next_powerof2(uint32_t v);
+void arkime_varint_append(ArkimeVarintArray_t *va, int64_t value);
+void arkime_varint_clear(ArkimeVarintArray_t *va);
+void arkime_varint_free(ArkimeVarintArray_t *va);
 void arkime_check_file_permissions(const char *filename);
 FILE *arkime_state_file_open(const char *name, const char *mode);
 
@@ -1357,6 +1445,7 @@ uint32_t arkime_session_hash(const void *key);
 
 ArkimeSession_t *arkime_session_find(int ses, const uint8_t *sessionId);
 ArkimeSession_t *arkime_session_find_or_create(int mProtocol, uint32_t hash, const uint8_t *sessionId, int *isNew);
+void     arkime_session_prefetch(int mProtocol, uint32_t hash, int stage);
 
 void     arkime_session_init();
 void     arkime_session_exit();
@@ -1422,10 +1511,12 @@ uint64_t arkime_packet_stats(int stat);
 void     arkime_packet_thread_wake(int thread);
 void     arkime_packet_flush();
 void     arkime_packet_process_data(ArkimeSession_t *session, const uint8_t *data, int len, int which);
+void     arkime_packet_add_file_pos(ArkimeSession_t *session, uint32_t fileNum, uint64_t filePos, uint16_t len);
 void     arkime_packet_add_packet_ip(char *ipstr, int mode);
 void     arkime_packet_install_packet_ip();
 
 void     arkime_packet_batch_init(ArkimePacketBatch_t *batch);
+void     arkime_packet_batch_free(ArkimePacketBatch_t *batch);
 void     arkime_packet_batch_flush(ArkimePacketBatch_t *batch);
 void     arkime_packet_batch(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet);
 void     arkime_packet_batch_process(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, int thread);
@@ -1449,6 +1540,8 @@ void     arkime_packet_set_udpport_enqueue_cb2(uint16_t port, ArkimePacketEnqueu
 
 ArkimePacket_t *arkime_packet_alloc();
 void arkime_packet_free(ArkimePacket_t *packet);
+void arkime_packet_copy(ArkimePacket_t *packet);
+void arkime_packet_block_unref(ArkimePacketBlock_t *block);
 
 /******************************************************************************/
 typedef void (*ArkimeProtocolCreateSessionId_cb)(uint8_t *sessionId, ArkimePacket_t *const packet);
@@ -1634,10 +1727,12 @@ gboolean arkime_field_float_add(int pos, ArkimeSession_t *session, float f);
 void arkime_field_macoui_add(ArkimeSession_t *session, int macField, int ouiField, const uint8_t *mac);
 
 int  arkime_field_count(int pos, ArkimeSession_t *session);
+void arkime_field_set(ArkimeSession_t *session, int pos, ArkimeField_t *field);
 void arkime_field_certsinfo_update_extra(void *cert, char *key, char *value);
 GPtrArray *arkime_field_certsinfo_get_extra(const ArkimeSession_t *session, const char *key);
 void arkime_field_free(ArkimeSession_t *session);
 void arkime_field_free_one(ArkimeSession_t *session, int pos);
+void arkime_field_string_free(ArkimeSession_t *session, char *str);
 void arkime_field_exit();
 
 int arkime_field_by_exp_add_internal(const char *exp, ArkimeFieldType type, ArkimeFieldGetFunc getCb, ArkimeFieldSetFunc setCb);
@@ -1667,11 +1762,16 @@ typedef uint32_t (*ArkimeWriterQueueLength)();
 typedef void (*ArkimeWriterWrite)(const ArkimeSession_t *const session, ArkimePacket_t *const packet);
 typedef void (*ArkimeWriterExit)();
 typedef void (*ArkimeWriterIndex)(ArkimeSession_t *session);
+typedef void (*ArkimeWriterFlush)(ArkimeSession_t *session);
+
+// writerFilePos when the writer will add the position to the session later
+#define ARKIME_WRITER_FILE_POS_PENDING UINT64_MAX
 
 extern ArkimeWriterQueueLength arkime_writer_queue_length;
 extern ArkimeWriterWrite arkime_writer_write;
 extern ArkimeWriterExit arkime_writer_exit;
 extern ArkimeWriterIndex arkime_writer_index;
+extern ArkimeWriterFlush arkime_writer_flush;
 
 
 void arkime_writers_init();
@@ -1767,6 +1867,34 @@ void arkime_rules_run_before_save(ArkimeSession_t *session, int final);
 void arkime_rules_stats();
 void arkime_rules_exit();
 
+/******************************************************************************/
+/*
+ * pool.c
+ */
+typedef struct arkimepool ArkimePool_t;
+
+typedef struct {
+    uint64_t allocs;
+    uint64_t inUse;
+    uint64_t cached;            // Free items in thread caches
+    uint64_t depot;             // Free items waiting in the shared depot
+    uint64_t bytes;             // Total memory allocated for items
+} ArkimePoolInfo_t;
+
+ArkimePool_t *arkime_pool_create(const char *name, uint32_t size);
+void *arkime_pool_alloc(ArkimePool_t *pool);
+void *arkime_pool_alloc0(ArkimePool_t *pool);
+void arkime_pool_free(ArkimePool_t *pool, void *mem);
+void arkime_pool_stats(ArkimePoolInfo_t *total);
+void arkime_pool_init();
+
+/******************************************************************************/
+/*
+ * numa.c
+ */
+void *arkime_numa_alloc0(const char *name, size_t size, int cnt);
+void arkime_numa_init();
+
 /******************************************************************************/
 /*
  * pq.c
@@ -212,6 +212,30 @@ do {                                              \
     }                                             \
 } while (0)
 
+/* Decimal numbers without going through snprintf */
+#define BSB_EXPORT_u64_dec(b, x)                  \
+do {                                              \
+    char     _bsb_dec[20];                        \
+    uint64_t _bsb_v = (x);                        \
+    int      _bsb_i = sizeof(_bsb_dec);           \
+    do {                                          \
+        _bsb_dec[--_bsb_i] = '0' + _bsb_v % 10;   \
+        _bsb_v /= 10;                             \
+    } while (_bsb_v);                             \
+    BSB_EXPORT_ptr(b, _bsb_dec + _bsb_i, (int)sizeof(_bsb_dec) - _bsb_i); \
+} while (0)
+
+#define BSB_EXPORT_i64_dec(b, x)                  \
+do {                                              \
+    int64_t _bsb_s = (x);                         \
+    if (_bsb_s < 0) {                             \
+        BSB_EXPORT_u08(b, '-');                   \
+        BSB_EXPORT_u64_dec(b, -(uint64_t)_bsb_s); \
+    } else {                                      \
+        BSB_EXPORT_u64_dec(b, (uint64_t)_bsb_s);  \
+    }                                             \
+} while (0)
+
 #define BSB_IMPORT_u08(b, x)                      \
 do {                                              \
     if ((b).ptr && (b).ptr + 1 <= (b).end) {      \
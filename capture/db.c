@@ -19,9 +19,15 @@
 #include <fcntl.h>
 #include <arpa/inet.h>
 #include <dirent.h>
+#include <sys/uio.h>
 #include "patricia.h"
 
 #include "maxminddb.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 LOCAL MMDB_s           *geoCountry;
 LOCAL int               geoCountryIsCity;
@@ -154,77 +160,60 @@ LOCAL ArkimeIpInfo_t *arkime_db_get_override_ip6(ArkimeSession_t *session, struc
     return ii;
 }
 
+/******************************************************************************/
+/* Bit i set if byte i needs a closer look: a control character, a high byte
+ * (signed less than 0x20 catches both), a quote or a backslash.
+ */
+#ifdef __AVX2__
+LOCAL inline uint32_t arkime_db_js0n_special32(const uint8_t *in)
+{
+    const __m256i v = _mm256_loadu_si256((const __m256i *)in);
+    const __m256i special = _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+    return _mm256_movemask_epi8(special);
+}
+#endif
+#ifdef __SSE2__
+LOCAL inline uint32_t arkime_db_js0n_special16(const uint8_t *in)
+{
+    const __m128i v = _mm_loadu_si128((const __m128i *)in);
+    const __m128i special = _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+    return _mm_movemask_epi8(special);
+}
+#endif
+/******************************************************************************/
+/* Skip whole blocks of bytes that pass through unchanged, returns the first
+ * byte that needs a closer look or where fewer than a block of bytes are left.
+ */
+LOCAL inline uint8_t *arkime_db_js0n_skip(uint8_t *in, const uint8_t *end)
+{
+#ifdef __AVX2__
+    while (in + 32 <= end) {
+        const uint32_t mask = arkime_db_js0n_special32(in);
+        if (mask)
+            return in + __builtin_ctz(mask);
+        in += 32;
+    }
+#endif
+#ifdef __SSE2__
+    while (in + 16 <= end) {
+        const uint32_t mask = arkime_db_js0n_special16(in);
+        if (mask)
+            return in + __builtin_ctz(mask);
+        in += 16;
+    }
+#endif
+    (void)end;
+    return in;
+}
 /******************************************************************************/
 void arkime_db_js0n_str(BSB *bsb, uint8_t *in, gboolean utf8)
 {
     BSB_EXPORT_u08(*bsb, '"');
-    while (*in) {
-        // batch a run of bytes that pass through unchanged
-        const uint8_t *start = in;
-        while (*in) {
-            if (*in >= 0x20 && *in < 0x80 && *in != '"' && *in != '\\') {
-                in++;
-                continue;
-            }
-            if (utf8) {
-                // valid continuation bytes and not overlong/surrogate/>U+10FFFF
-                if ((*in & 0xf8) == 0xf0 && (in[1] & 0xc0) == 0x80 && (in[2] & 0xc0) == 0x80 && (in[3] & 0xc0) == 0x80 &&
-                    *in <= 0xf4 && !(*in == 0xf0 && in[1] < 0x90) && !(*in == 0xf4 && in[1] > 0x8f)) {
-                    in += 4;
-                    continue;
-                }
-                if ((*in & 0xf0) == 0xe0 && (in[1] & 0xc0) == 0x80 && (in[2] & 0xc0) == 0x80 &&
-                    !(*in == 0xe0 && in[1] < 0xa0) && !(*in == 0xed && in[1] > 0x9f)) {
-                    in += 3;
-                    continue;
-                }
-                if ((*in & 0xe0) == 0xc0 && *in >= 0xc2 && (in[1] & 0xc0) == 0x80) {
-                    in += 2;
-                    continue;
-                }
-            }
-            break;
-        }
-        if (in > start)
-            BSB_EXPORT_ptr(*bsb, start, in - start);
-        if (!*in)
-            break;
-
-        switch (*in) {
-        case '\b':
-            BSB_EXPORT_cstr(*bsb, "\\b");
-            break;
-        case '\n':
-            BSB_EXPORT_cstr(*bsb, "\\n");
-            break;
-        case '\r':
-            BSB_EXPORT_cstr(*bsb, "\\r");
-            break;
-        case '\f':
-            BSB_EXPORT_cstr(*bsb, "\\f");
-            break;
-        case '\t':
-            BSB_EXPORT_cstr(*bsb, "\\t");
-            break;
-        case '"':
-            BSB_EXPORT_cstr(*bsb, "\\\"");
-            break;
-        case '\\':
-            BSB_EXPORT_cstr(*bsb, "\\\\");
-            break;
-        default:
-            if (*in < 32) {
-                BSB_EXPORT_sprintf(*bsb, "\\u%04x", *in);
-            } else {
-                // invalid or non-utf8 high byte: latin1 -> utf8
-                BSB_EXPORT_u08(*bsb, (0xc0 | (*in >> 6)));
-                BSB_EXPORT_u08(*bsb, (0x80 | (*in & 0x3f)));
-            }
-            break;
-        }
-        in++;
-    }
-
+    arkime_db_js0n_str_unquoted(bsb, in, -1, utf8);
     BSB_EXPORT_u08(*bsb, '"');
 }
 
@@ -241,6 +230,9 @@ void arkime_db_js0n_str_unquoted(BSB *bsb, uint8_t *in, int len, gboolean utf8)
         // batch a run of bytes that pass through unchanged
         const uint8_t *start = in;
         while (in < end) {
+            in = arkime_db_js0n_skip(in, end);
+            if (in >= end)
+                break;
             if (*in >= 0x20 && *in < 0x80 && *in != '"' && *in != '\\') {
                 in++;
                 continue;
@@ -293,7 +285,8 @@ void arkime_db_js0n_str_unquoted(BSB *bsb, uint8_t *in, int len, gboolean utf8)
             break;
         default:
             if (*in < 32) {
-                BSB_EXPORT_sprintf(*bsb, "\\u%04x", *in);
+                BSB_EXPORT_cstr(*bsb, "\\u00");
+                BSB_EXPORT_ptr(*bsb, arkime_char_to_hexstr[*in], 2);
             } else {
                 // invalid or non-utf8 high byte: latin1 -> utf8
                 BSB_EXPORT_u08(*bsb, (0xc0 | (*in >> 6)));
@@ -305,6 +298,163 @@ void arkime_db_js0n_str_unquoted(BSB *bsb, uint8_t *in, int len, gboolean utf8)
     }
 }
 
+/******************************************************************************/
+/* MaxMind lookups are cached per packet thread since a few thousand IPs are
+ * most of the traffic.  An address hashes to a set of ARKIME_DB_GEO_WAYS
+ * entries and the least recently used one is replaced on a miss.  Loading a
+ * new geo file bumps geoGeneration so all the older entries miss.
+ */
+#define ARKIME_DB_GEO_WAYS 4
+
+typedef struct {
+    struct in6_addr addr;
+    char           *country;
+    char           *region;
+    char           *city;
+    char           *asn;
+    uint32_t        asNum;
+    uint32_t        generation;     // 0 is unused
+    uint32_t        lastUsed;
+    uint8_t         countryLen;
+    uint8_t         regionLen;
+    uint8_t         cityLen;
+    uint8_t         asnLen;
+} ArkimeDbGeoEntry_t;
+
+typedef struct {
+    ArkimeDbGeoEntry_t *entries;
+    uint64_t            hits;
+    uint64_t            misses;
+    uint32_t            clock;
+} ARKIME_CACHE_ALIGN ArkimeDbGeoCache_t;
+
+LOCAL ArkimeDbGeoCache_t *geoCaches;
+LOCAL uint32_t            geoCacheSets;    // Power of 2, 0 if the cache is off
+LOCAL uint32_t            geoGeneration = 1;
+LOCAL __thread gboolean   geoCacheOff;     // db-save-bench runs off the packet threads, it mustn't share their caches
+
+/******************************************************************************/
+LOCAL void arkime_db_geo_mmdb(const struct sockaddr *sa, ArkimeDbGeoEntry_t *entry)
+{
+    int error = 0;
+    if (geoCountry) {
+        MMDB_lookup_result_s result = MMDB_lookup_sockaddr(geoCountry, sa, &error);
+        if (error == MMDB_SUCCESS && result.found_entry) {
+            MMDB_entry_data_s entry_data;
+
+            static const char *countryPath[] = {"country", "iso_code", NULL};
+            int status = MMDB_aget_value(&result.entry, &entry_data, countryPath);
+            if (status == MMDB_SUCCESS) {
+                entry->country = (char *)entry_data.utf8_string;
+                entry->countryLen = entry_data.data_size;
+            }
+
+            if (geoCountryIsCity) {
+                static const char *regionPath[] = {"subdivisions", "0", "iso_code", NULL};
+                status = MMDB_aget_value(&result.entry, &entry_data, regionPath);
+                if (status == MMDB_SUCCESS) {
+                    entry->region = (char *)entry_data.utf8_string;
+                    entry->regionLen = entry_data.data_size;
+                }
+
+                static const char *cityPath[] = {"city", "names", "en", NULL};
+                status = MMDB_aget_value(&result.entry, &entry_data, cityPath);
+                if (status == MMDB_SUCCESS) {
+                    entry->city = (char *)entry_data.utf8_string;
+                    entry->cityLen = entry_data.data_size;
+                }
+            }
+        }
+    }
+
+    if (geoASN) {
+        MMDB_lookup_result_s result = MMDB_lookup_sockaddr(geoASN, sa, &error);
+        if (error == MMDB_SUCCESS && result.found_entry) {
+            MMDB_entry_data_s org;
+            MMDB_entry_data_s num;
+
+            static const char *asoPath[]     = {"autonomous_system_organization", NULL};
+            int status = MMDB_aget_value(&result.entry, &org, asoPath);
+
+            static const char *asnPath[]     = {"autonomous_system_number", NULL};
+            status += MMDB_aget_value(&result.entry, &num, asnPath);
+
+            if (status == MMDB_SUCCESS) {
+                entry->asNum = num.uint32;
+                entry->asn = (char *)org.utf8_string;
+                entry->asnLen = org.data_size;
+            }
+        }
+    }
+}
+/******************************************************************************/
+LOCAL const ArkimeDbGeoEntry_t *arkime_db_geo_cache(int thread, const struct in6_addr *addr, const struct sockaddr *sa, ArkimeDbGeoEntry_t *tmp)
+{
+    if (!geoCacheSets || geoCacheOff) {
+        memset(tmp, 0, sizeof(*tmp));
+        arkime_db_geo_mmdb(sa, tmp);
+        return tmp;
+    }
+
+    ArkimeDbGeoCache_t *cache = &geoCaches[thread];
+    if (unlikely(!cache->entries)) {
+        cache->entries = ARKIME_SIZE_ALLOC0("geo cache", sizeof(ArkimeDbGeoEntry_t) * geoCacheSets * ARKIME_DB_GEO_WAYS);
+    }
+
+    // Acquire so geoCountry and geoASN are at least as new as the generation
+    const uint32_t generation = ARKIME_THREAD_ATOMIC_LOAD(geoGeneration);
+
+    uint32_t w[4];
+    memcpy(w, addr->s6_addr, sizeof(w));
+    uint32_t h = w[0] ^ w[1] ^ w[2] ^ w[3];
+    // IPv4 mapped addresses only vary in the top bytes of w[3], fold them down before mixing
+    h ^= h >> 16;
+    h *= 0x9e3779b1;
+    h ^= h >> 16;
+    ArkimeDbGeoEntry_t *set = &cache->entries[(h & (geoCacheSets - 1)) * ARKIME_DB_GEO_WAYS];
+
+    const uint32_t clock = ++cache->clock;
+    ArkimeDbGeoEntry_t *victim = set;
+    for (int i = 0; i < ARKIME_DB_GEO_WAYS; i++) {
+        if (set[i].generation != generation) {
+            victim = &set[i];
+            continue;
+        }
+        if (memcmp(&set[i].addr, addr, sizeof(*addr)) == 0) {
+            set[i].lastUsed = clock;
+            cache->hits++;
+            return &set[i];
+        }
+        if (victim->generation == generation && clock - set[i].lastUsed > clock - victim->lastUsed) {
+            victim = &set[i];
+        }
+    }
+
+    cache->misses++;
+    memset(victim, 0, sizeof(*victim));
+    victim->addr = *addr;
+    arkime_db_geo_mmdb(sa, victim);
+    victim->generation = generation;
+    victim->lastUsed = clock;
+    return victim;
+}
+/******************************************************************************/
+LOCAL void arkime_db_geo_cmd_stats(int UNUSED(argc), char **UNUSED(argv), gpointer cc)
+{
+    BSB bsb;
+    char *output = g_malloc(200 + config.packetThreads * 80);
+    BSB_INIT(bsb, output, 200 + config.packetThreads * 80);
+
+    BSB_EXPORT_sprintf(bsb, "%-6s %14s %14s %7s  (%u entries per thread)\n", "Thread", "Hits", "Misses", "Hit%", geoCacheSets * ARKIME_DB_GEO_WAYS);
+    for (int t = 0; t < config.packetThreads; t++) {
+        const uint64_t hits = geoCaches[t].hits;
+        const uint64_t misses = geoCaches[t].misses;
+        BSB_EXPORT_sprintf(bsb, "%-6d %14" PRIu64 " %14" PRIu64 " %6.2f%%\n", t, hits, misses, hits + misses ? hits * 100.0 / (hits + misses) : 0.0);
+    }
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+    g_free(output);
+}
 /******************************************************************************/
 void arkime_db_geo_lookup6(ArkimeSession_t *session, struct in6_addr addr, ArkimeGeoInfo_t *geo)
 {
@@ -346,62 +496,33 @@ void arkime_db_geo_lookup6(ArkimeSession_t *session, struct in6_addr addr, Arkim
         sa = (struct sockaddr *)&sin6;
     }
 
-    int error = 0;
-    if ((!geo->country || (geoCountryIsCity && (!geo->city || !geo->region))) && geoCountry) {
-        MMDB_lookup_result_s result = MMDB_lookup_sockaddr(geoCountry, sa, &error);
-        if (error == MMDB_SUCCESS && result.found_entry) {
-            MMDB_entry_data_s entry_data;
-
-            if (!geo->country) {
-                static const char *countryPath[] = {"country", "iso_code", NULL};
-
-                int status = MMDB_aget_value(&result.entry, &entry_data, countryPath);
-                if (status == MMDB_SUCCESS) {
-                    geo->country = (char *)entry_data.utf8_string;
-                    geo->countryLen = entry_data.data_size;
-                }
-            }
-
-            if (geoCountryIsCity && !geo->region) {
-                static const char *countryPath[] = {"subdivisions", "0", "iso_code", NULL};
-
-                int status = MMDB_aget_value(&result.entry, &entry_data, countryPath);
-                if (status == MMDB_SUCCESS) {
-                    geo->region = (char *)entry_data.utf8_string;
-                    geo->regionLen = entry_data.data_size;
-                }
-            }
+    const int needCountry = (!geo->country || (geoCountryIsCity && (!geo->city || !geo->region))) && geoCountry;
+    const int needASN = !geo->asn && geoASN;
+    if (!needCountry && !needASN)
+        return;
 
-            if (geoCountryIsCity && !geo->city) {
-                static const char *countryPath[] = {"city", "names", "en", NULL};
+    ArkimeDbGeoEntry_t tmp;
+    const ArkimeDbGeoEntry_t *entry = arkime_db_geo_cache(session->thread, &addr, sa, &tmp);
 
-                int status = MMDB_aget_value(&result.entry, &entry_data, countryPath);
-                if (status == MMDB_SUCCESS) {
-                    geo->city = (char *)entry_data.utf8_string;
-                    geo->cityLen = entry_data.data_size;
-                }
-            }
+    if (needCountry) {
+        if (!geo->country && entry->country) {
+            geo->country = entry->country;
+            geo->countryLen = entry->countryLen;
+        }
+        if (!geo->region && entry->region) {
+            geo->region = entry->region;
+            geo->regionLen = entry->regionLen;
+        }
+        if (!geo->city && entry->city) {
+            geo->city = entry->city;
+            geo->cityLen = entry->cityLen;
         }
     }
 
-    if (!geo->asn && geoASN) {
-        MMDB_lookup_result_s result = MMDB_lookup_sockaddr(geoASN, sa, &error);
-        if (error == MMDB_SUCCESS && result.found_entry) {
-            MMDB_entry_data_s org;
-            MMDB_entry_data_s num;
-
-            static const char *asoPath[]     = {"autonomous_system_organization", NULL};
-            int status = MMDB_aget_value(&result.entry, &org, asoPath);
-
-            static const char *asnPath[]     = {"autonomous_system_number", NULL};
-            status += MMDB_aget_value(&result.entry, &num, asnPath);
-
-            if (status == MMDB_SUCCESS) {
-                geo->asNum = num.uint32;
-                geo->asn = (char *)org.utf8_string;
-                geo->asnLen = org.data_size;
-            }
-        }
+    if (needASN && entry->asn) {
+        geo->asNum = entry->asNum;
+        geo->asn = entry->asn;
+        geo->asnLen = entry->asnLen;
     }
 }
 /******************************************************************************/
@@ -425,10 +546,248 @@ LOCAL void arkime_db_send_bulk_cb(int code, uint8_t *data, int data_len, gpointe
     }
 }
 /******************************************************************************/
+/* When esSpoolDir is set and OpenSearch/Elasticsearch falls behind, bulk
+ * requests are appended to segment files instead of being queued in memory
+ * and are replayed in order once the queue drains.  Once anything is spooled
+ * all new bulk requests are spooled too until it drains, so the order is kept.
+ * Segments left by a previous run are replayed at startup.
+ */
+#define ARKIME_DB_SPOOL_SEGMENT_SIZE (64 * 1024 * 1024)
+
+typedef struct {
+    uint32_t len;
+    uint32_t time;
+} ArkimeDbSpoolHdr_t;
+
+LOCAL char             *esSpoolDir;
+LOCAL uint32_t          esSpoolQueue;       // Spool once this many requests are outstanding
+LOCAL uint64_t          esSpoolMaxBytes;
+LOCAL int               spoolWriteFd = -1;
+LOCAL uint32_t          spoolWriteSeq;
+LOCAL uint64_t          spoolWriteOff;
+LOCAL int               spoolReadFd = -1;
+LOCAL uint32_t          spoolReadSeq;
+LOCAL uint64_t          spoolReadOff;
+LOCAL uint64_t          spoolReadEnd;       // Size of the segment being read if it isn't being written
+LOCAL uint64_t          spoolBytes;         // Spooled but not replayed yet
+LOCAL uint32_t          spoolTime;          // When the last replayed request was spooled
+LOCAL uint64_t          spoolSpooled;
+LOCAL uint64_t          spoolReplayed;
+LOCAL ARKIME_LOCK_DEFINE(spool);
+
+/******************************************************************************/
+LOCAL void arkime_db_spool_path(char *path, int len, uint32_t seq)
+{
+    snprintf(path, len, "%s/%s-%08u.spool", esSpoolDir, config.nodeName, seq);
+}
+/******************************************************************************/
+LOCAL gboolean arkime_db_spool_add(const char *json, int len)
+{
+    char path[PATH_MAX];
+
+    ARKIME_LOCK(spool);
+    if (spoolBytes == 0 && (uint32_t)arkime_http_queue_length(esServer) < esSpoolQueue) {
+        ARKIME_UNLOCK(spool);
+        return FALSE;
+    }
+
+    if (spoolBytes + len > esSpoolMaxBytes) {
+        ARKIME_UNLOCK(spool);
+        LOG_RATE(60, "WARNING - esSpoolDir %s has reached esSpoolMaxG, queueing bulk requests in memory", esSpoolDir);
+        return FALSE;
+    }
+
+    if (spoolWriteFd == -1 || spoolWriteOff >= ARKIME_DB_SPOOL_SEGMENT_SIZE) {
+        if (spoolWriteFd != -1) {
+            close(spoolWriteFd);
+        }
+        // The segment being read is now complete
+        if (spoolReadSeq == spoolWriteSeq) {
+            spoolReadEnd = spoolWriteOff;
+        }
+        spoolWriteSeq++;
+        spoolWriteOff = 0;
+        arkime_db_spool_path(path, sizeof(path), spoolWriteSeq);
+        spoolWriteFd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (spoolWriteFd < 0) {
+            ARKIME_UNLOCK(spool);
+            LOG_RATE(60, "ERROR - Couldn't create spool file %s: %s", path, strerror(errno));
+            return FALSE;
+        }
+    }
+
+    ArkimeDbSpoolHdr_t hdr;
+    hdr.len = len;
+    hdr.time = time(NULL);
+
+    struct iovec iov[2];
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = (char *)json;
+    iov[1].iov_len = len;
+
+    const ssize_t total = sizeof(hdr) + len;
+    if (pwritev(spoolWriteFd, iov, 2, spoolWriteOff) != total) {
+        ARKIME_UNLOCK(spool);
+        LOG_RATE(60, "ERROR - Couldn't write to spool dir %s: %s", esSpoolDir, strerror(errno));
+        return FALSE;
+    }
+
+    if (spoolBytes == 0)
+        spoolTime = hdr.time;
+    spoolWriteOff += total;
+    spoolBytes += total;
+    spoolSpooled++;
+    ARKIME_UNLOCK(spool);
+    return TRUE;
+}
+/******************************************************************************/
+/* Main thread, send spooled requests while the queue is less than half of
+ * esSpoolQueue so new requests don't start spooling again right away.
+ */
+LOCAL gboolean arkime_db_spool_replay(gpointer UNUSED(user_data))
+{
+    char path[PATH_MAX];
+    int  sent = 0;
+
+    ARKIME_LOCK(spool);
+    while (spoolBytes > 0 && sent < 100 && (uint32_t)arkime_http_queue_length(esServer) < esSpoolQueue / 2) {
+        if (spoolReadFd == -1) {
+            arkime_db_spool_path(path, sizeof(path), spoolReadSeq);
+            spoolReadFd = open(path, O_RDONLY);
+            if (spoolReadFd < 0) {
+                if (spoolReadSeq == spoolWriteSeq) {
+                    LOG("ERROR - Couldn't open spool file %s, dropping %" PRIu64 " spooled bytes: %s", path, spoolBytes, strerror(errno));
+                    spoolBytes = 0;
+                    break;
+                }
+                spoolReadSeq++;
+                continue;
+            }
+            struct stat sb;
+            spoolReadEnd = fstat(spoolReadFd, &sb) == 0 ? (uint64_t)sb.st_size : 0;
+            spoolReadOff = 0;
+        }
+
+        const uint64_t end = spoolReadSeq == spoolWriteSeq ? spoolWriteOff : spoolReadEnd;
+
+        if (spoolReadOff >= end) {
+            if (spoolReadSeq == spoolWriteSeq)
+                break;
+            close(spoolReadFd);
+            spoolReadFd = -1;
+            arkime_db_spool_path(path, sizeof(path), spoolReadSeq);
+            unlink(path);
+            spoolReadSeq++;
+            continue;
+        }
+
+        ArkimeDbSpoolHdr_t hdr;
+        if (pread(spoolReadFd, &hdr, sizeof(hdr), spoolReadOff) != sizeof(hdr) || spoolReadOff + sizeof(hdr) + hdr.len > end) {
+            // Partial write from a crash, skip the rest of the segment
+            LOG("WARNING - Skipping %" PRIu64 " bytes of truncated spool segment %u", end - spoolReadOff, spoolReadSeq);
+            spoolBytes -= MIN(spoolBytes, end - spoolReadOff);
+            spoolReadOff = end;
+            continue;
+        }
+
+        char *json = arkime_http_get_buffer(hdr.len);
+        if (pread(spoolReadFd, json, hdr.len, spoolReadOff + sizeof(hdr)) != (ssize_t)hdr.len) {
+            LOG("ERROR - Couldn't read spool segment %u: %s", spoolReadSeq, strerror(errno));
+            arkime_http_free_buffer(json);
+            break;
+        }
+
+        spoolReadOff += sizeof(hdr) + hdr.len;
+        spoolBytes -= MIN(spoolBytes, sizeof(hdr) + hdr.len);
+        spoolTime = hdr.time;
+        spoolReplayed++;
+        sent++;
+        arkime_http_schedule(esServer, "POST", esBulkQuery, esBulkQueryLen, json, hdr.len, NULL, ARKIME_HTTP_PRIORITY_NORMAL, arkime_db_send_bulk_cb, NULL);
+    }
+
+    // Drained, remove the last segment and start over with a new one
+    if (spoolBytes == 0 && (spoolWriteFd != -1 || spoolReadFd != -1)) {
+        if (spoolReadFd != -1) {
+            close(spoolReadFd);
+            spoolReadFd = -1;
+        }
+        if (spoolWriteFd != -1) {
+            close(spoolWriteFd);
+            spoolWriteFd = -1;
+        }
+        arkime_db_spool_path(path, sizeof(path), spoolWriteSeq);
+        unlink(path);
+        spoolReadSeq = spoolWriteSeq + 1;
+        LOG("Finished replaying spooled bulk requests");
+    }
+    ARKIME_UNLOCK(spool);
+    return G_SOURCE_CONTINUE;
+}
+/******************************************************************************/
+/* Pick up any segments left by a previous run */
+LOCAL void arkime_db_spool_init()
+{
+    esSpoolQueue = arkime_config_int(NULL, "esSpoolQueue", config.maxESRequests, 1, 0xffff);
+    esSpoolMaxBytes = (uint64_t)arkime_config_int(NULL, "esSpoolMaxG", 10, 1, 100000) * 1024LL * 1024LL * 1024LL;
+
+    if (g_mkdir_with_parents(esSpoolDir, 0700) != 0) {
+        CONFIGEXIT("Couldn't create esSpoolDir %s: %s", esSpoolDir, strerror(errno));
+    }
+
+    DIR *dir = opendir(esSpoolDir);
+    if (!dir) {
+        CONFIGEXIT("Couldn't open esSpoolDir %s: %s", esSpoolDir, strerror(errno));
+    }
+
+    char prefix[300];
+    const int prefixLen = snprintf(prefix, sizeof(prefix), "%s-", config.nodeName);
+    uint32_t first = 0xffffffff, last = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (strncmp(entry->d_name, prefix, prefixLen) != 0 || !g_str_has_suffix(entry->d_name, ".spool"))
+            continue;
+
+        char *end;
+        uint32_t seq = strtoul(entry->d_name + prefixLen, &end, 10);
+        if (strcmp(end, ".spool") != 0)
+            continue;
+
+        char path[PATH_MAX];
+        struct stat sb;
+        arkime_db_spool_path(path, sizeof(path), seq);
+        if (stat(path, &sb) != 0)
+            continue;
+
+        first = MIN(first, seq);
+        last = MAX(last, seq);
+        spoolBytes += sb.st_size;
+        if (seq == last)
+            spoolWriteOff = sb.st_size;
+    }
+    closedir(dir);
+
+    if (spoolBytes > 0) {
+        // The newest segment is finished, new requests go to the one after it
+        spoolReadSeq = first;
+        spoolWriteSeq = last;
+        spoolTime = time(NULL);
+        LOG("Replaying %" PRIu64 " bytes of spooled bulk requests from %s", spoolBytes, esSpoolDir);
+    } else {
+        spoolReadSeq = 1;
+    }
+
+    g_timeout_add(100, arkime_db_spool_replay, 0);
+}
+/******************************************************************************/
 LOCAL void arkime_db_send_bulk(char *json, int len)
 {
     if (config.debug > 4)
         LOG("Sending Bulk:>%.*s<", len, json);
+    if (esSpoolDir && arkime_db_spool_add(json, len)) {
+        arkime_http_free_buffer(json);
+        return;
+    }
     arkime_http_schedule(esServer, "POST", esBulkQuery, esBulkQueryLen, json, len, NULL, ARKIME_HTTP_PRIORITY_NORMAL, arkime_db_send_bulk_cb, NULL);
 }
 /******************************************************************************/
@@ -587,29 +946,53 @@ typedef struct {
     char     prefix[100];
     time_t   prefixTime;
     short    sortedFieldsIndex[ARKIME_FIELDS_MAX];
+    short    sortedFieldsRank[ARKIME_FIELDS_MAX];
     uint16_t sortedFieldsIndexCnt;
     uint16_t cnt;
     ARKIME_LOCK_EXTERN(lock);
 } ARKIME_CACHE_ALIGN DbInfo_t;
-LOCAL DbInfo_t dbInfo[ARKIME_MAX_PACKET_THREADS];
+LOCAL DbInfo_t *dbInfo;
 
 #define MAX_IPS 2000
 
 LOCAL ARKIME_LOCK_DEFINE(outputted);
 
-#define SAVE_FIELD_STR_HASH(POS, FLAGS) \
+/* The keys are built once per field by arkime_field_json_keys */
+#define SAVE_FIELD_KEY(INFO) BSB_EXPORT_ptr(jbsb, (INFO)->jsonKey, (INFO)->jsonKeyLen)
+
+#define SAVE_FIELD_CNT(INFO, CNT) \
 do { \
-    if (config.fields[POS]->type != ARKIME_FIELD_TYPE_STR_HASH) \
+    BSB_EXPORT_ptr(jbsb, (INFO)->jsonCntKey, (INFO)->jsonCntKeyLen); \
+    BSB_EXPORT_u64_dec(jbsb, CNT); \
+    BSB_EXPORT_u08(jbsb, ','); \
+} while (0)
+
+/* "srcGEO": style keys for ip fields, dbField without the trailing Ip */
+#define SAVE_FIELD_IP_KEY(INFO, SUFFIX) \
+do { \
+    BSB_EXPORT_u08(jbsb, '"'); \
+    BSB_EXPORT_ptr(jbsb, (INFO)->dbField, MAX((INFO)->dbFieldLen - 2, 0)); \
+    BSB_EXPORT_cstr(jbsb, SUFFIX "\":"); \
+} while (0)
+
+#define SAVE_FIELD_STR_HASH(POS, FLAGS) \
+do { \
+    if (config.fields[POS]->type != ARKIME_FIELD_TYPE_STR_HASH) \
         break; \
-    ArkimeStringHashStd_t *shash = session->fields[POS]->shash; \
+    ArkimeStringHashStd_t *shash = arkime_field_get(session, POS)->shash; \
     ArkimeString_t        *hstring; \
     if (FLAGS & ARKIME_FIELD_FLAG_CNT) { \
-        BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%d,", config.fields[POS]->dbField, HASH_COUNT(s_, *shash)); \
+        SAVE_FIELD_CNT(config.fields[POS], HASH_COUNT(s_, *shash)); \
     } \
     if (FLAGS & ARKIME_FIELD_FLAG_ECS_CNT) { \
-        BSB_EXPORT_sprintf(jbsb, "\"%s-cnt\":%d,", config.fields[POS]->dbField, HASH_COUNT(s_, *shash)); \
+        BSB_EXPORT_u08(jbsb, '"'); \
+        BSB_EXPORT_ptr(jbsb, config.fields[POS]->dbField, config.fields[POS]->dbFieldLen); \
+        BSB_EXPORT_cstr(jbsb, "-cnt\":"); \
+        BSB_EXPORT_u64_dec(jbsb, HASH_COUNT(s_, *shash)); \
+        BSB_EXPORT_u08(jbsb, ','); \
     } \
-    BSB_EXPORT_sprintf(jbsb, "\"%s\":[", config.fields[POS]->dbField); \
+    SAVE_FIELD_KEY(config.fields[POS]); \
+    BSB_EXPORT_u08(jbsb, '['); \
     HASH_FORALL2(s_, *shash, hstring) { \
         arkime_db_js0n_str(&jbsb, (uint8_t *)hstring->str, hstring->utf8 || FLAGS & ARKIME_FIELD_FLAG_FORCE_UTF8); \
         BSB_EXPORT_u08(jbsb, ','); \
@@ -618,156 +1001,573 @@ do { \
     BSB_EXPORT_cstr(jbsb, "],"); \
 } while (0)
 
-LOCAL int arkime_db_field_sort(const void *a, const void *b)
+/******************************************************************************/
+/* Insert the fields from cnt on into the dbFieldFull order so groups stay
+ * together, fields already in the order never move relative to each other so
+ * only the new ones need a strcmp.
+ */
+LOCAL void arkime_db_fields_rank(short *index, short *rank, int cnt, int maxDbField)
+{
+    for (int f = cnt; f < maxDbField; f++) {
+        const char *name = config.fields[f]->dbFieldFull;
+        int lo = 0, hi = f;
+        while (lo < hi) {
+            const int mid = (lo + hi) / 2;
+            if (strcmp(config.fields[index[mid]]->dbFieldFull, name) <= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        memmove(index + lo + 1, index + lo, (f - lo) * sizeof(index[0]));
+        index[lo] = f;
+    }
+
+    for (int f = 0; f < maxDbField; f++) {
+        rank[index[f]] = f;
+    }
+}
+/******************************************************************************/
+/* Insertion sort the set fields by rank into fieldsOrder */
+LOCAL void arkime_db_fields_order(const ArkimeSession_t *session, const short *rank, uint16_t *fieldsOrder)
+{
+    for (int i = 0; i < session->fieldsCnt; i++) {
+        const short r = rank[session->fieldsPos[i]];
+        int j = i;
+        while (j > 0 && rank[session->fieldsPos[fieldsOrder[j - 1]]] > r) {
+            fieldsOrder[j] = fieldsOrder[j - 1];
+            j--;
+        }
+        fieldsOrder[j] = i;
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_db_export_ip(BSB *bsb, const struct in6_addr *ip)
 {
-    return strcmp(config.fields[*(short *)a]->dbFieldFull, config.fields[*(short *)b]->dbFieldFull);
+    char ipstr[INET6_ADDRSTRLEN];
+    int  len;
+
+    if (IN6_IS_ADDR_V4MAPPED(ip)) {
+        len = arkime_ip4tostr(ARKIME_V6_TO_V4(*ip), ipstr, sizeof(ipstr)) - ipstr;
+    } else {
+        inet_ntop(AF_INET6, ip, ipstr, sizeof(ipstr));
+        len = strlen(ipstr);
+    }
+    BSB_EXPORT_u08(*bsb, '"');
+    BSB_EXPORT_ptr(*bsb, ipstr, len);
+    BSB_EXPORT_u08(*bsb, '"');
 }
 
 /******************************************************************************/
-/* State for autoGenerateId=sequential. uuid_generate is locked, so calling it
- * per session serializes the packet threads; instead each thread draws one
- * random uuid at startup and increments it per session. The high bytes, which
- * the counter never reaches, are overwritten with the node name hash and the
- * packet thread so two captures (even a fleet booting together with a cold RNG)
- * and two threads on one capture cannot collide without relying on the random
- * bits; the low bytes stay random + counter for uniqueness across restarts.
+/* Write the set fields in rank order, each one is freed unless it is a linked
+ * session field being saved before the session is final.
  */
-LOCAL __thread uuid_t   idCur;
-LOCAL __thread gboolean idInit;
-/******************************************************************************/
-void arkime_db_save_session(ArkimeSession_t *session, int final)
+LOCAL void arkime_db_save_fields(BSB *bsb, ArkimeSession_t *session, const short *rank, int final)
 {
-    char                   id[120];
-    uint32_t               id_len;
+    BSB                    jbsb = *bsb;
+    uint16_t               fieldsOrder[ARKIME_FIELDS_MAX];
     ArkimeInt_t           *hint;
     ArkimeIntHashStd_t    *ihash;
     GHashTable            *ghash;
     GHashTableIter         iter;
-    const uint8_t         *startPtr;
-    const uint8_t         *dataPtr;
-    uint32_t               jsonSize;
     gpointer               ikey;
-    char                   ipsrc[INET6_ADDRSTRLEN];
-    char                   ipdst[INET6_ADDRSTRLEN];
-
-    /* Let the plugins finish */
-    if (pluginsCbs & ARKIME_PLUGIN_SAVE)
-        arkime_plugins_cb_save(session, final);
-
-    arkime_parsers_call_named_func(arkime_session_save_func, session, NULL, final, NULL);
-
-    /* Don't save spi data for session */
-    if (session->stopSPI)
-        return;
-
-    /* No Packets */
-    if (!config.dryRun && !session->filePosArray->len)
-        return;
-
-    /* Not enough packets */
-    if (session->packets[0] + session->packets[1] < session->minSaving) {
-        return;
-    }
 
-    if (arkime_writer_index) {
-        arkime_writer_index(session);
-    }
+    arkime_db_fields_order(session, rank, fieldsOrder);
 
-    /* jsonSize is an estimate of how much space it will take to encode the session */
-    jsonSize = 1300 + session->filePosArray->len * 17 + 11 * session->fileNumArray->len;
-    if (config.enablePacketLen) {
-        jsonSize += 10 * session->fileLenArray->len;
-    }
+    const int fieldsCnt = session->fieldsCnt;
+    int inGroupNum = 0;
+    for (int f = 0; f < fieldsCnt; f++) {
+        const int pos = session->fieldsPos[fieldsOrder[f]];
+        ArkimeField_t *field = session->fieldsSparse[fieldsOrder[f]];
 
-    for (int pos = 0; pos < session->maxFields; pos++) {
-        if (session->fields[pos]) {
-            jsonSize += session->fields[pos]->jsonSize;
-        }
-    }
+        const ArkimeFieldInfo_t *fieldInfo = config.fields[pos];
+        const int flags = fieldInfo->flags;
+        if (flags & (ARKIME_FIELD_FLAG_DISABLED | ARKIME_FIELD_FLAG_NOSAVE))
+            continue;
 
-    ARKIME_THREAD_INCR(arkimeCounters.totalSessions);
-    session->segments++;
+        const int freeField = final || ((flags & ARKIME_FIELD_FLAG_LINKED_SESSIONS) == 0);
 
-    const int thread = session->thread;
+        if (inGroupNum != fieldInfo->dbGroupNum) {
+            if (inGroupNum != 0) {
+                BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+                BSB_EXPORT_cstr(jbsb, "},");
+            }
+            inGroupNum = fieldInfo->dbGroupNum;
 
-    /* Rebuild field order, we keep a sort list of fields per thread */
-    if (session->maxFields > dbInfo[thread].sortedFieldsIndexCnt) {
-        for (int f = 0; f < session->maxFields; f++) {
-            dbInfo[thread].sortedFieldsIndex[f] = f;
+            if (inGroupNum) {
+                BSB_EXPORT_ptr(jbsb, fieldInfo->jsonGroup, fieldInfo->jsonGroupLen);
+            }
         }
-        qsort(&dbInfo[thread].sortedFieldsIndex, session->maxFields, sizeof(dbInfo[thread].sortedFieldsIndex[0]), arkime_db_field_sort);
-        dbInfo[thread].sortedFieldsIndexCnt = session->maxFields;
-    }
-
-    /* figure out ES index name per thread, can change every second */
-    if (dbInfo[thread].prefixTime != session->lastPacket.tv_sec) {
-        dbInfo[thread].prefixTime = session->lastPacket.tv_sec;
 
-        struct tm tmp;
-        gmtime_r(&dbInfo[thread].prefixTime, &tmp);
-
-        switch (config.rotate) {
-        case ARKIME_ROTATE_HOURLY:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, tmp.tm_hour);
+        switch (fieldInfo->type) {
+        case ARKIME_FIELD_TYPE_INT:
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_i64_dec(jbsb, field->i);
+            BSB_EXPORT_u08(jbsb, ',');
             break;
-        case ARKIME_ROTATE_HOURLY2:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 2) * 2);
+        case ARKIME_FIELD_TYPE_STR:
+            SAVE_FIELD_KEY(fieldInfo);
+            arkime_db_js0n_str(&jbsb,
+                               (uint8_t *)field->str,
+                               flags & ARKIME_FIELD_FLAG_FORCE_UTF8);
+            BSB_EXPORT_u08(jbsb, ',');
+            if (freeField) {
+                g_free(field->str);
+            }
             break;
-        case ARKIME_ROTATE_HOURLY3:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 3) * 3);
+        case ARKIME_FIELD_TYPE_FLOAT:
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_sprintf(jbsb, "%f", field->f);
+            BSB_EXPORT_u08(jbsb, ',');
             break;
-        case ARKIME_ROTATE_HOURLY4:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 4) * 4);
+        case ARKIME_FIELD_TYPE_INT_ARRAY:
+        case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, field->iarray->len);
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            for (uint32_t i = 0; i < field->iarray->len; i++) {
+                BSB_EXPORT_u64_dec(jbsb, g_array_index(field->iarray, uint32_t, i));
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+            if (freeField) {
+                g_array_free(field->iarray, TRUE);
+            }
             break;
-        case ARKIME_ROTATE_HOURLY6:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 6) * 6);
+        case ARKIME_FIELD_TYPE_STR_ARRAY:
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, field->sarray->len);
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            for (uint32_t i = 0; i < field->sarray->len; i++) {
+                arkime_db_js0n_str(&jbsb,
+                                   g_ptr_array_index(field->sarray, i),
+                                   flags & ARKIME_FIELD_FLAG_FORCE_UTF8);
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+            if (freeField) {
+                g_ptr_array_free(field->sarray, TRUE);
+            }
             break;
-        case ARKIME_ROTATE_HOURLY8:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 8) * 8);
+        case ARKIME_FIELD_TYPE_STR_HASH:
+            SAVE_FIELD_STR_HASH(pos, flags);
+            if (freeField) {
+                ArkimeStringHashStd_t *shash = field->shash;
+                ArkimeString_t        *hstring;
+                HASH_FORALL_POP_HEAD2(s_, *shash, hstring) {
+                    arkime_field_string_free(session, hstring->str);
+                    ARKIME_TYPE_FREE(ArkimeString_t, hstring);
+                }
+                ARKIME_TYPE_FREE(ArkimeStringHashStd_t, shash);
+            }
             break;
-        case ARKIME_ROTATE_HOURLY12:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 12) * 12);
+        case ARKIME_FIELD_TYPE_STR_GHASH:
+            ghash = field->ghash;
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, g_hash_table_size(ghash));
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            g_hash_table_iter_init(&iter, ghash);
+            while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
+                arkime_db_js0n_str(&jbsb, ikey, flags & ARKIME_FIELD_FLAG_FORCE_UTF8);
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+
+            if (freeField) {
+                g_hash_table_destroy(ghash);
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
             break;
-        case ARKIME_ROTATE_DAILY:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday);
+        case ARKIME_FIELD_TYPE_INT_HASH:
+            ihash = field->ihash;
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, HASH_COUNT(i_, *ihash));
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            HASH_FORALL2(i_, *ihash, hint) {
+                BSB_EXPORT_u64_dec(jbsb, (uint32_t)hint->i_hash);
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+            if (freeField) {
+                HASH_FORALL_POP_HEAD2(i_, *ihash, hint) {
+                    ARKIME_TYPE_FREE(ArkimeInt_t, hint);
+                }
+                ARKIME_TYPE_FREE(ArkimeIntHashStd_t, ihash);
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
             break;
-        case ARKIME_ROTATE_WEEKLY:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02dw%02d", tmp.tm_year % 100, tmp.tm_yday / 7);
+        case ARKIME_FIELD_TYPE_INT_GHASH:
+            ghash = field->ghash;
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, g_hash_table_size(ghash));
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            g_hash_table_iter_init(&iter, ghash);
+            while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
+                BSB_EXPORT_u64_dec(jbsb, (unsigned int)(long)ikey);
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+
+            if (freeField) {
+                g_hash_table_destroy(ghash);
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
             break;
-        case ARKIME_ROTATE_MONTHLY:
-            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02dm%02d", tmp.tm_year % 100, tmp.tm_mon + 1);
+        case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, field->farray->len);
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            for (uint32_t i = 0; i < field->farray->len; i++) {
+                BSB_EXPORT_sprintf(jbsb, "%f", g_array_index(field->farray, float, i));
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+            if (freeField) {
+                g_array_free(field->farray, TRUE);
+            }
             break;
-        }
-    }
-
-    // May be left empty when autoGenerateId==1; keep it a valid string for the %s warning path below
-    id[0] = 0;
-    if (config.autoGenerateId == 2 && session->filePosArray->len > 1) {
-        snprintf(id, sizeof(id), "%s-%s-%u-%" PRId64, dbInfo[thread].prefix, config.nodeName, (uint32_t)g_array_index(session->fileNumArray, uint32_t, 0), (int64_t)g_array_index(session->filePosArray, int64_t, 1));
+        case ARKIME_FIELD_TYPE_FLOAT_GHASH:
+            ghash = field->ghash;
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, g_hash_table_size(ghash));
+            }
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            g_hash_table_iter_init(&iter, ghash);
+            while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
+                BSB_EXPORT_sprintf(jbsb, "%f", POINTER_TO_FLOAT(ikey));
+                BSB_EXPORT_u08(jbsb, ',');
+            }
 
-        if (session->rootId == GINT_TO_POINTER(1))
-            session->rootId = g_strdup(id);
-    } else if (config.autoGenerateId != 1 || session->rootId == GINT_TO_POINTER(1)) {
-        uuid_t uuid;
-        const uint8_t *idBytes;
+            if (freeField) {
+                g_hash_table_destroy(ghash);
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+            break;
+        case ARKIME_FIELD_TYPE_IP: {
+            ArkimeGeoInfo_t       geo;
 
-        if (config.autoGenerateId == 3) {
-            // sequential: per thread, lock free -- see idCur comment above
-            if (unlikely(!idInit)) {
-                uuid_generate(idCur);
-                uint32_t nodeHash = arkime_string_hash(config.nodeName);
-                memcpy(idCur, &nodeHash, 4);  // high bytes: node identity ...
-                idCur[4] = (uint8_t)thread;   // ... then packet thread
-                idInit = TRUE;
-            } else {
-                for (int i = 15; i >= 0 && ++idCur[i] == 0; i--) // increment, carry toward high bytes
-                    ;
+            ikey = field->ip;
+            arkime_db_geo_lookup6(session, *(struct in6_addr *)ikey, &geo);
+            if (geo.country) {
+                SAVE_FIELD_IP_KEY(fieldInfo, "GEO");
+                BSB_EXPORT_u08(jbsb, '"');
+                BSB_EXPORT_ptr(jbsb, geo.country, geo.countryLen);
+                BSB_EXPORT_cstr(jbsb, "\",");
             }
-            idBytes = idCur;
-        } else {
-            uuid_generate(uuid); // a fresh random uuid per session
-            idBytes = uuid;
-        }
+
+            if (geo.asn) {
+                SAVE_FIELD_IP_KEY(fieldInfo, "ASN");
+                BSB_EXPORT_cstr(jbsb, "\"AS");
+                BSB_EXPORT_u64_dec(jbsb, geo.asNum);
+                BSB_EXPORT_u08(jbsb, ' ');
+                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo.asn, geo.asnLen, TRUE);
+                BSB_EXPORT_cstr(jbsb, "\",");
+            }
+
+            /*if (asStr) {
+                BSB_EXPORT_sprintf(jbsb, "\"as\":{\"number\":%u,\"full\":\"AS%u ", asNum, asNum);
+                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)asStr, asLen, TRUE);
+                BSB_EXPORT_cstr(jbsb, "\",\"organization\":{\"name\":\"");
+                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)asStr, asLen, TRUE);
+                BSB_EXPORT_cstr(jbsb, "\"}},");
+            }*/
+
+            if (geo.rir) {
+                SAVE_FIELD_IP_KEY(fieldInfo, "RIR");
+                BSB_EXPORT_u08(jbsb, '"');
+                BSB_EXPORT_ptr(jbsb, geo.rir, strlen(geo.rir));
+                BSB_EXPORT_cstr(jbsb, "\",");
+            }
+
+            SAVE_FIELD_KEY(fieldInfo);
+            arkime_db_export_ip(&jbsb, ikey);
+            BSB_EXPORT_u08(jbsb, ',');
+
+            if (freeField) {
+                g_free(field->ip);
+            }
+            break;
+        }
+        case ARKIME_FIELD_TYPE_IP_GHASH: {
+            ghash = field->ghash;
+            if (flags & ARKIME_FIELD_FLAG_CNT) {
+                SAVE_FIELD_CNT(fieldInfo, g_hash_table_size(ghash));
+            }
+
+            ArkimeGeoInfo_t       geos[MAX_IPS];
+            uint32_t              cnt = 0;
+
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+            g_hash_table_iter_init(&iter, ghash);
+            while (cnt < MAX_IPS && g_hash_table_iter_next(&iter, &ikey, NULL)) {
+                arkime_db_geo_lookup6(session, *(struct in6_addr *)ikey, &geos[cnt]);
+                arkime_db_export_ip(&jbsb, ikey);
+                BSB_EXPORT_u08(jbsb, ',');
+                cnt++;
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+
+            SAVE_FIELD_IP_KEY(fieldInfo, "GEO");
+            BSB_EXPORT_u08(jbsb, '[');
+            for (uint32_t i = 0; i < cnt; i++) {
+                if (geos[i].country) {
+                    BSB_EXPORT_u08(jbsb, '"');
+                    BSB_EXPORT_ptr(jbsb, geos[i].country, geos[i].countryLen);
+                    BSB_EXPORT_cstr(jbsb, "\",");
+                } else {
+                    BSB_EXPORT_cstr(jbsb, "\"---\",");
+                }
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+
+            SAVE_FIELD_IP_KEY(fieldInfo, "ASN");
+            BSB_EXPORT_u08(jbsb, '[');
+            for (uint32_t i = 0; i < cnt; i++) {
+                if (geos[i].asn) {
+                    BSB_EXPORT_cstr(jbsb, "\"AS");
+                    BSB_EXPORT_u64_dec(jbsb, geos[i].asNum);
+                    BSB_EXPORT_u08(jbsb, ' ');
+                    arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geos[i].asn, geos[i].asnLen, TRUE);
+                    BSB_EXPORT_cstr(jbsb, "\",");
+
+                } else {
+                    BSB_EXPORT_cstr(jbsb, "\"---\",");
+                }
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+
+            SAVE_FIELD_IP_KEY(fieldInfo, "RIR");
+            BSB_EXPORT_u08(jbsb, '[');
+            for (uint32_t i = 0; i < cnt; i++) {
+                if (geos[i].rir) {
+                    BSB_EXPORT_u08(jbsb, '"');
+                    BSB_EXPORT_ptr(jbsb, geos[i].rir, strlen(geos[i].rir));
+                    BSB_EXPORT_cstr(jbsb, "\",");
+                } else {
+                    BSB_EXPORT_cstr(jbsb, "\"\",");
+                }
+            }
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+
+            if (freeField) {
+                g_hash_table_destroy(ghash);
+            }
+
+            break;
+        }
+        case ARKIME_FIELD_TYPE_OBJECT: {
+            ArkimeFieldObjectHashStd_t *ohash = field->ohash;
+            ArkimeFieldObjectSaveFunc saveCB = fieldInfo->object_save;
+            ArkimeFieldObjectFreeFunc freeCB = fieldInfo->object_free;
+
+            SAVE_FIELD_CNT(fieldInfo, HASH_COUNT(o_, *ohash));
+            SAVE_FIELD_KEY(fieldInfo);
+            BSB_EXPORT_u08(jbsb, '[');
+
+            ArkimeFieldObject_t *object;
+
+            HASH_FORALL_POP_HEAD2(o_, *ohash, object) {
+                saveCB(&jbsb, object, session);
+                freeCB(object);
+                BSB_EXPORT_u08(jbsb, ',');
+            }
+            ARKIME_TYPE_FREE(ArkimeFieldObjectHashStd_t, ohash);
+
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "],");
+        }
+        break;
+        } /* switch */
+        if (freeField) {
+            ARKIME_TYPE_FREE(ArkimeField_t, field);
+            session->fieldsSparse[fieldsOrder[f]] = 0;
+        }
+    }
+
+    // Drop the freed fields, linked session fields are kept for the next save
+    int cnt = 0;
+    for (int i = 0; i < fieldsCnt; i++) {
+        if (session->fieldsSparse[i]) {
+            session->fieldsSparse[cnt] = session->fieldsSparse[i];
+            session->fieldsPos[cnt] = session->fieldsPos[i];
+            cnt++;
+        }
+    }
+    session->fieldsCnt = cnt;
+
+    if (inGroupNum) {
+        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+        BSB_EXPORT_cstr(jbsb, "},");
+    }
+
+    *bsb = jbsb;
+}
+/******************************************************************************/
+/* State for autoGenerateId=sequential. uuid_generate is locked, so calling it
+ * per session serializes the packet threads; instead each thread draws one
+ * random uuid at startup and increments it per session. The high bytes, which
+ * the counter never reaches, are overwritten with the node name hash and the
+ * packet thread so two captures (even a fleet booting together with a cold RNG)
+ * and two threads on one capture cannot collide without relying on the random
+ * bits; the low bytes stay random + counter for uniqueness across restarts.
+ */
+LOCAL __thread uuid_t   idCur;
+LOCAL __thread gboolean idInit;
+/******************************************************************************/
+void arkime_db_save_session(ArkimeSession_t *session, int final)
+{
+    char                   id[120];
+    uint32_t               id_len;
+    const uint8_t         *startPtr;
+    const uint8_t         *dataPtr;
+    uint32_t               jsonSize;
+    char                   ipsrc[INET6_ADDRSTRLEN];
+    char                   ipdst[INET6_ADDRSTRLEN];
+
+    /* Wait for the writer to know where all the packets are */
+    if (session->pendingFilePos && arkime_writer_flush)
+        arkime_writer_flush(session);
+
+    /* Let the plugins finish */
+    if (pluginsCbs & ARKIME_PLUGIN_SAVE)
+        arkime_plugins_cb_save(session, final);
+
+    arkime_parsers_call_named_func(arkime_session_save_func, session, NULL, final, NULL);
+
+    /* Don't save spi data for session */
+    if (session->stopSPI)
+        return;
+
+    /* No Packets */
+    if (!config.dryRun && !session->filePosArray.cnt)
+        return;
+
+    /* Not enough packets */
+    if (session->packets[0] + session->packets[1] < session->minSaving) {
+        return;
+    }
+
+    if (arkime_writer_index) {
+        arkime_writer_index(session);
+    }
+
+    ARKIME_THREAD_INCR(arkimeCounters.totalSessions);
+    session->segments++;
+
+    const int thread = session->thread;
+
+    /* Add any new fields to the field order, we keep a sort list of fields per thread */
+    const int maxDbField = config.maxDbField;
+    if (maxDbField > dbInfo[thread].sortedFieldsIndexCnt) {
+        arkime_db_fields_rank(dbInfo[thread].sortedFieldsIndex, dbInfo[thread].sortedFieldsRank, dbInfo[thread].sortedFieldsIndexCnt, maxDbField);
+        dbInfo[thread].sortedFieldsIndexCnt = maxDbField;
+    }
+
+    /* jsonSize is an estimate of how much space it will take to encode the session */
+    jsonSize = 1300 + session->filePosArray.cnt * 17 + 11 * session->fileNumArray->len;
+    if (config.enablePacketLen) {
+        jsonSize += 10 * session->fileLenArray.cnt;
+    }
+
+    for (int i = 0; i < session->fieldsCnt; i++) {
+        jsonSize += session->fieldsSparse[i]->jsonSize;
+    }
+
+    /* figure out ES index name per thread, can change every second */
+    if (dbInfo[thread].prefixTime != session->lastPacket.tv_sec) {
+        dbInfo[thread].prefixTime = session->lastPacket.tv_sec;
+
+        struct tm tmp;
+        gmtime_r(&dbInfo[thread].prefixTime, &tmp);
+
+        switch (config.rotate) {
+        case ARKIME_ROTATE_HOURLY:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, tmp.tm_hour);
+            break;
+        case ARKIME_ROTATE_HOURLY2:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 2) * 2);
+            break;
+        case ARKIME_ROTATE_HOURLY3:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 3) * 3);
+            break;
+        case ARKIME_ROTATE_HOURLY4:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 4) * 4);
+            break;
+        case ARKIME_ROTATE_HOURLY6:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 6) * 6);
+            break;
+        case ARKIME_ROTATE_HOURLY8:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 8) * 8);
+            break;
+        case ARKIME_ROTATE_HOURLY12:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02dh%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday, (tmp.tm_hour / 12) * 12);
+            break;
+        case ARKIME_ROTATE_DAILY:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02d%02d%02d", tmp.tm_year % 100, tmp.tm_mon + 1, tmp.tm_mday);
+            break;
+        case ARKIME_ROTATE_WEEKLY:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02dw%02d", tmp.tm_year % 100, tmp.tm_yday / 7);
+            break;
+        case ARKIME_ROTATE_MONTHLY:
+            snprintf(dbInfo[thread].prefix, sizeof(dbInfo[thread].prefix), "%02dm%02d", tmp.tm_year % 100, tmp.tm_mon + 1);
+            break;
+        }
+    }
+
+    // May be left empty when autoGenerateId==1; keep it a valid string for the %s warning path below
+    id[0] = 0;
+    if (config.autoGenerateId == 2 && session->filePosArray.cnt > 1) {
+        // The second entry is the first packet's position
+        uint32_t off = 0;
+        int64_t  fpos = 0;
+        arkime_varint_next(&session->filePosArray, &off, &fpos);
+        arkime_varint_next(&session->filePosArray, &off, &fpos);
+        snprintf(id, sizeof(id), "%s-%s-%u-%" PRId64, dbInfo[thread].prefix, config.nodeName, (uint32_t)g_array_index(session->fileNumArray, uint32_t, 0), fpos);
+
+        if (session->rootId == GINT_TO_POINTER(1))
+            session->rootId = g_strdup(id);
+    } else if (config.autoGenerateId != 1 || session->rootId == GINT_TO_POINTER(1)) {
+        uuid_t uuid;
+        const uint8_t *idBytes;
+
+        if (config.autoGenerateId == 3) {
+            // sequential: per thread, lock free -- see idCur comment above
+            if (unlikely(!idInit)) {
+                uuid_generate(idCur);
+                uint32_t nodeHash = arkime_string_hash(config.nodeName);
+                memcpy(idCur, &nodeHash, 4);  // high bytes: node identity ...
+                idCur[4] = (uint8_t)thread;   // ... then packet thread
+                idInit = TRUE;
+            } else {
+                for (int i = 15; i >= 0 && ++idCur[i] == 0; i--) // increment, carry toward high bytes
+                    ;
+            }
+            idBytes = idCur;
+        } else {
+            uuid_generate(uuid); // a fresh random uuid per session
+            idBytes = uuid;
+        }
 
         id_len = arkime_snprintf_len(id, sizeof(id), "%s-", dbInfo[thread].prefix);
         gint state = 0, save = 0;
@@ -992,519 +1792,210 @@ void arkime_db_save_session(ArkimeSession_t *session, int final)
             BSB_EXPORT_cstr(jbsb, "\"}},");
         }
 
-        if (session->fields[mac1Field]) {
+        if (arkime_field_get(session, mac1Field)) {
             SAVE_FIELD_STR_HASH(mac1Field, ARKIME_FIELD_FLAG_ECS_CNT);
         }
 
         BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
         BSB_EXPORT_cstr(jbsb, "},"); // Close source
 
-        BSB_EXPORT_sprintf(jbsb,
-                           "\"destination\":{\"ip\":\"%s\","
-                           "\"port\":%d,"
-                           "\"bytes\":%" PRIu64 ","
-                           "\"packets\":%u,",
-                           ipdst,
-                           session->port2,
-                           session->bytes[1],
-                           session->packets[1]);
-
-        if (geo2.country || geo2.region || geo2.city) {
-            BSB_EXPORT_cstr(jbsb, "\"geo\":{");
-            if (geo2.country)
-                BSB_EXPORT_sprintf(jbsb, "\"country_iso_code\":\"%.*s\",", geo2.countryLen, geo2.country);
-
-            if (geo2.region) {
-                BSB_EXPORT_sprintf(jbsb, "\"region_iso_code\":\"%.*s\",", geo2.regionLen, geo2.region);
-            }
-            if (geo2.city) {
-                BSB_EXPORT_cstr(jbsb, "\"city_name\":\"");
-                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo2.city, geo2.cityLen, TRUE);
-                BSB_EXPORT_cstr(jbsb, "\",");
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "},");
-        }
-
-        if (geo2.asn) {
-            BSB_EXPORT_sprintf(jbsb, "\"as\":{\"number\":%u,\"full\":\"AS%u ", geo2.asNum, geo2.asNum);
-            arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo2.asn, geo2.asnLen, TRUE);
-            BSB_EXPORT_cstr(jbsb, "\",\"organization\":{\"name\":\"");
-            arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo2.asn, geo2.asnLen, TRUE);
-            BSB_EXPORT_cstr(jbsb, "\"}},");
-        }
-
-        if (session->fields[mac2Field]) {
-            SAVE_FIELD_STR_HASH(mac2Field, ARKIME_FIELD_FLAG_ECS_CNT);
-        }
-
-        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-        BSB_EXPORT_cstr(jbsb, "},"); // Close destination
-
-        if (geo1.rir)
-            BSB_EXPORT_sprintf(jbsb, "\"srcRIR\":\"%s\",", geo1.rir);
-
-        if (geo2.rir)
-            BSB_EXPORT_sprintf(jbsb, "\"dstRIR\":\"%s\",", geo2.rir);
-    } else {/* ipProtocol */
-        BSB_EXPORT_sprintf(jbsb,
-                           "\"source\":{"
-                           "\"bytes\":%" PRIu64 ","
-                           "\"packets\":%u,",
-                           session->bytes[0],
-                           session->packets[0]);
-
-        if (session->fields[mac1Field]) {
-            SAVE_FIELD_STR_HASH(mac1Field, ARKIME_FIELD_FLAG_ECS_CNT);
-        }
-
-        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-        BSB_EXPORT_cstr(jbsb, "},"); // Close source
-
-        BSB_EXPORT_sprintf(jbsb,
-                           "\"destination\":{"
-                           "\"bytes\":%" PRIu64 ","
-                           "\"packets\":%u,",
-                           session->bytes[1],
-                           session->packets[1]);
-
-        if (session->fields[mac2Field]) {
-            SAVE_FIELD_STR_HASH(mac2Field, ARKIME_FIELD_FLAG_ECS_CNT);
-        }
-
-        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-        BSB_EXPORT_cstr(jbsb, "},"); // Close destination
-    }
-
-    BSB_EXPORT_sprintf(jbsb,
-                       "\"network\":{\"packets\":%u,"
-                       "\"bytes\":%" PRIu64,
-                       session->packets[0] + session->packets[1],
-                       session->bytes[0] + session->bytes[1]);
-
-    // Currently don't do communityId for ICMP because it requires magic
-    if (session->ses == SESSION_ICMP) {
-        char *communityId = arkime_db_community_id_icmp(session);
-        BSB_EXPORT_sprintf(jbsb, ",\"community_id\":\"1:%s\"", communityId);
-        g_free(communityId);
-    } else if (session->ses != SESSION_OTHER) {
-        char *communityId = arkime_db_community_id(session);
-        BSB_EXPORT_sprintf(jbsb, ",\"community_id\":\"1:%s\"", communityId);
-        g_free(communityId);
-    }
-
-    if (session->fields[vlanField] && config.fields[vlanField]->type == ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE) {
-        BSB_EXPORT_cstr(jbsb, ",\"vlan\":{");
-        BSB_EXPORT_sprintf(jbsb, "\"id-cnt\":%u,", session->fields[vlanField]->iarray->len);
-        BSB_EXPORT_sprintf(jbsb, "\"id\":[");
-        for (uint32_t i = 0; i < session->fields[vlanField]->iarray->len; i++) {
-            BSB_EXPORT_sprintf(jbsb, "%u", g_array_index(session->fields[vlanField]->iarray, uint32_t, i));
-            BSB_EXPORT_u08(jbsb, ',');
-        }
-        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-        BSB_EXPORT_cstr(jbsb, "]");
-        BSB_EXPORT_cstr(jbsb, "}"); /* vlan */
-    }
-    BSB_EXPORT_cstr(jbsb, "},"); /* network */
-
-
-    BSB_EXPORT_sprintf(jbsb, "\"client\":{\"bytes\":%" PRIu64 "},",
-                       session->databytes[0]);
-    BSB_EXPORT_sprintf(jbsb, "\"server\":{\"bytes\":%" PRIu64 "},",
-                       session->databytes[1]);
-
-    BSB_EXPORT_sprintf(jbsb,
-                       "\"totDataBytes\":%" PRIu64 ","
-                       "\"segmentCnt\":%u,"
-                       "\"node\":\"%s\",",
-                       session->databytes[0] + session->databytes[1],
-                       session->segments,
-                       config.nodeName);
-
-    if (session->rootId) {
-        BSB_EXPORT_sprintf(jbsb, "\"rootId\":\"%s\",", session->rootId);
-    }
-    BSB_EXPORT_cstr(jbsb, "\"packetPos\":[");
-    if (config.gapPacketPos) {
-        /* Very simple gap encoding, with a gap the same as previous gap represented as 0.
-         * Negative numbers, and numbers after the negative number are not encoded.
-         * This should reduce the saved size by over 50%.
-         * Future work of switching to binary varint with base64 might help more.
-         */
-        int64_t last = 0;
-        int64_t lastgap = 0;
-        for (uint32_t i = 0; i < session->filePosArray->len; i++) {
-            if (i != 0)
-                BSB_EXPORT_u08(jbsb, ',');
-            int64_t fpos = (int64_t)g_array_index(session->filePosArray, int64_t, i);
-            if (fpos < 0) {
-                last = 0;
-                lastgap = 0;
-                BSB_EXPORT_sprintf(jbsb, "%" PRId64, fpos);
-            } else {
-                if (fpos - last == lastgap) {
-                    BSB_EXPORT_u08(jbsb, '0');
-                } else {
-                    lastgap = fpos - last;
-                    BSB_EXPORT_sprintf(jbsb, "%" PRId64, lastgap);
-                }
-                last = fpos;
-            }
-        }
-    } else {
-        // Do NOT remove this, S3 and others use this
-        for (uint32_t i = 0; i < session->filePosArray->len; i++) {
-            if (i != 0)
-                BSB_EXPORT_u08(jbsb, ',');
-            BSB_EXPORT_sprintf(jbsb, "%" PRId64, (int64_t)g_array_index(session->filePosArray, int64_t, i));
-        }
-    }
-    BSB_EXPORT_cstr(jbsb, "],");
-
-    if (config.enablePacketLen) {
-        BSB_EXPORT_cstr(jbsb, "\"packetLen\":[");
-        for (uint32_t i = 0; i < session->fileLenArray->len; i++) {
-            if (i != 0)
-                BSB_EXPORT_u08(jbsb, ',');
-            BSB_EXPORT_sprintf(jbsb, "%u", (uint16_t)g_array_index(session->fileLenArray, uint16_t, i));
-        }
-        BSB_EXPORT_cstr(jbsb, "],");
-    }
-
-    BSB_EXPORT_cstr(jbsb, "\"fileId\":[");
-    for (uint32_t i = 0; i < session->fileNumArray->len; i++) {
-        if (i == 0)
-            BSB_EXPORT_sprintf(jbsb, "%u", (uint32_t)g_array_index(session->fileNumArray, uint32_t, i));
-        else
-            BSB_EXPORT_sprintf(jbsb, ",%u", (uint32_t)g_array_index(session->fileNumArray, uint32_t, i));
-    }
-    BSB_EXPORT_cstr(jbsb, "],");
-
-    if (ecsEventProvider && ecsEventDataset) {
-        BSB_EXPORT_sprintf(jbsb, "\"event\":{\"provider\":\"%s\", \"dataset\":\"%s\"},", ecsEventProvider, ecsEventDataset);
-    } else if (ecsEventProvider) {
-        BSB_EXPORT_sprintf(jbsb, "\"event\":{\"provider\":\"%s\"},", ecsEventProvider);
-    } else if (ecsEventDataset) {
-        BSB_EXPORT_sprintf(jbsb, "\"event\":{\"dataset\":\"%s\"},", ecsEventDataset);
-    }
-
-    int inGroupNum = 0;
-    for (int sortedFieldsIndexPos = 0; sortedFieldsIndexPos < dbInfo[thread].sortedFieldsIndexCnt; sortedFieldsIndexPos++) {
-        const int pos = dbInfo[thread].sortedFieldsIndex[sortedFieldsIndexPos];
-        if (pos >= session->maxFields || !session->fields[pos])
-            continue;
-
-        const ArkimeFieldInfo_t *fieldInfo = config.fields[pos];
-        const int flags = fieldInfo->flags;
-        if (flags & (ARKIME_FIELD_FLAG_DISABLED | ARKIME_FIELD_FLAG_NOSAVE))
-            continue;
-
-        const int freeField = final || ((flags & ARKIME_FIELD_FLAG_LINKED_SESSIONS) == 0);
-
-        if (inGroupNum != fieldInfo->dbGroupNum) {
-            if (inGroupNum != 0) {
-                BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-                BSB_EXPORT_cstr(jbsb, "},");
-            }
-            inGroupNum = fieldInfo->dbGroupNum;
-
-            if (inGroupNum) {
-                BSB_EXPORT_sprintf(jbsb, "\"%.*s\":{", fieldInfo->dbGroupLen, fieldInfo->dbGroup);
-            }
-        }
-
-        switch (fieldInfo->type) {
-        case ARKIME_FIELD_TYPE_INT:
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":%d", fieldInfo->dbField, session->fields[pos]->i);
-            BSB_EXPORT_u08(jbsb, ',');
-            break;
-        case ARKIME_FIELD_TYPE_STR:
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":", fieldInfo->dbField);
-            arkime_db_js0n_str(&jbsb,
-                               (uint8_t *)session->fields[pos]->str,
-                               flags & ARKIME_FIELD_FLAG_FORCE_UTF8);
-            BSB_EXPORT_u08(jbsb, ',');
-            if (freeField) {
-                g_free(session->fields[pos]->str);
-            }
-            break;
-        case ARKIME_FIELD_TYPE_FLOAT:
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":%f", fieldInfo->dbField, session->fields[pos]->f);
-            BSB_EXPORT_u08(jbsb, ',');
-            break;
-        case ARKIME_FIELD_TYPE_INT_ARRAY:
-        case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, session->fields[pos]->iarray->len);
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            for (uint32_t i = 0; i < session->fields[pos]->iarray->len; i++) {
-                BSB_EXPORT_sprintf(jbsb, "%u", g_array_index(session->fields[pos]->iarray, uint32_t, i));
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            if (freeField) {
-                g_array_free(session->fields[pos]->iarray, TRUE);
-            }
-            break;
-        case ARKIME_FIELD_TYPE_STR_ARRAY:
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, session->fields[pos]->sarray->len);
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            for (uint32_t i = 0; i < session->fields[pos]->sarray->len; i++) {
-                arkime_db_js0n_str(&jbsb,
-                                   g_ptr_array_index(session->fields[pos]->sarray, i),
-                                   flags & ARKIME_FIELD_FLAG_FORCE_UTF8);
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            if (freeField) {
-                g_ptr_array_free(session->fields[pos]->sarray, TRUE);
-            }
-            break;
-        case ARKIME_FIELD_TYPE_STR_HASH:
-            SAVE_FIELD_STR_HASH(pos, flags);
-            if (freeField) {
-                ArkimeStringHashStd_t *shash = session->fields[pos]->shash;
-                ArkimeString_t        *hstring;
-                HASH_FORALL_POP_HEAD2(s_, *shash, hstring) {
-                    g_free(hstring->str);
-                    ARKIME_TYPE_FREE(ArkimeString_t, hstring);
-                }
-                ARKIME_TYPE_FREE(ArkimeStringHashStd_t, shash);
-            }
-            break;
-        case ARKIME_FIELD_TYPE_STR_GHASH:
-            ghash = session->fields[pos]->ghash;
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, g_hash_table_size(ghash));
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            g_hash_table_iter_init(&iter, ghash);
-            while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
-                arkime_db_js0n_str(&jbsb, ikey, flags & ARKIME_FIELD_FLAG_FORCE_UTF8);
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-
-            if (freeField) {
-                g_hash_table_destroy(ghash);
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            break;
-        case ARKIME_FIELD_TYPE_INT_HASH:
-            ihash = session->fields[pos]->ihash;
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%d,", fieldInfo->dbField, HASH_COUNT(i_, *ihash));
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            HASH_FORALL2(i_, *ihash, hint) {
-                BSB_EXPORT_sprintf(jbsb, "%u", hint->i_hash);
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-            if (freeField) {
-                HASH_FORALL_POP_HEAD2(i_, *ihash, hint) {
-                    ARKIME_TYPE_FREE(ArkimeInt_t, hint);
-                }
-                ARKIME_TYPE_FREE(ArkimeIntHashStd_t, ihash);
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            break;
-        case ARKIME_FIELD_TYPE_INT_GHASH:
-            ghash = session->fields[pos]->ghash;
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, g_hash_table_size(ghash));
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            g_hash_table_iter_init(&iter, ghash);
-            while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
-                BSB_EXPORT_sprintf(jbsb, "%u", (unsigned int)(long)ikey);
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-
-            if (freeField) {
-                g_hash_table_destroy(ghash);
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            break;
-        case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, session->fields[pos]->farray->len);
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            for (uint32_t i = 0; i < session->fields[pos]->farray->len; i++) {
-                BSB_EXPORT_sprintf(jbsb, "%f", g_array_index(session->fields[pos]->farray, float, i));
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            if (freeField) {
-                g_array_free(session->fields[pos]->farray, TRUE);
-            }
-            break;
-        case ARKIME_FIELD_TYPE_FLOAT_GHASH:
-            ghash = session->fields[pos]->ghash;
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, g_hash_table_size(ghash));
-            }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            g_hash_table_iter_init(&iter, ghash);
-            while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
-                BSB_EXPORT_sprintf(jbsb, "%f", POINTER_TO_FLOAT(ikey));
-                BSB_EXPORT_u08(jbsb, ',');
-            }
-
-            if (freeField) {
-                g_hash_table_destroy(ghash);
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
-            break;
-        case ARKIME_FIELD_TYPE_IP: {
-            ArkimeGeoInfo_t       geo;
-
-            ikey = session->fields[pos]->ip;
-            arkime_db_geo_lookup6(session, *(struct in6_addr *)ikey, &geo);
-            if (geo.country) {
-                BSB_EXPORT_sprintf(jbsb, "\"%.*sGEO\":\"%.*s\",", fieldInfo->dbFieldLen - 2, fieldInfo->dbField, geo.countryLen, geo.country);
-            }
-
-            if (geo.asn) {
-                BSB_EXPORT_sprintf(jbsb, "\"%.*sASN\":\"AS%u ", fieldInfo->dbFieldLen - 2, fieldInfo->dbField, geo.asNum);
-                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo.asn, geo.asnLen, TRUE);
-                BSB_EXPORT_cstr(jbsb, "\",");
-            }
+        BSB_EXPORT_sprintf(jbsb,
+                           "\"destination\":{\"ip\":\"%s\","
+                           "\"port\":%d,"
+                           "\"bytes\":%" PRIu64 ","
+                           "\"packets\":%u,",
+                           ipdst,
+                           session->port2,
+                           session->bytes[1],
+                           session->packets[1]);
 
-            /*if (asStr) {
-                BSB_EXPORT_sprintf(jbsb, "\"as\":{\"number\":%u,\"full\":\"AS%u ", asNum, asNum);
-                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)asStr, asLen, TRUE);
-                BSB_EXPORT_cstr(jbsb, "\",\"organization\":{\"name\":\"");
-                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)asStr, asLen, TRUE);
-                BSB_EXPORT_cstr(jbsb, "\"}},");
-            }*/
+        if (geo2.country || geo2.region || geo2.city) {
+            BSB_EXPORT_cstr(jbsb, "\"geo\":{");
+            if (geo2.country)
+                BSB_EXPORT_sprintf(jbsb, "\"country_iso_code\":\"%.*s\",", geo2.countryLen, geo2.country);
 
-            if (geo.rir) {
-                BSB_EXPORT_sprintf(jbsb, "\"%.*sRIR\":\"%s\",", fieldInfo->dbFieldLen - 2, fieldInfo->dbField, geo.rir);
+            if (geo2.region) {
+                BSB_EXPORT_sprintf(jbsb, "\"region_iso_code\":\"%.*s\",", geo2.regionLen, geo2.region);
             }
-
-            if (IN6_IS_ADDR_V4MAPPED((struct in6_addr *)ikey)) {
-                arkime_ip4tostr(ARKIME_V6_TO_V4(*(struct in6_addr *)ikey), ipsrc, sizeof(ipsrc));
-            } else {
-                inet_ntop(AF_INET6, ikey, ipsrc, sizeof(ipsrc));
+            if (geo2.city) {
+                BSB_EXPORT_cstr(jbsb, "\"city_name\":\"");
+                arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo2.city, geo2.cityLen, TRUE);
+                BSB_EXPORT_cstr(jbsb, "\",");
             }
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":\"%s\",", fieldInfo->dbField, ipsrc);
+            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+            BSB_EXPORT_cstr(jbsb, "},");
+        }
 
-            if (freeField) {
-                g_free(session->fields[pos]->ip);
-            }
-            break;
+        if (geo2.asn) {
+            BSB_EXPORT_sprintf(jbsb, "\"as\":{\"number\":%u,\"full\":\"AS%u ", geo2.asNum, geo2.asNum);
+            arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo2.asn, geo2.asnLen, TRUE);
+            BSB_EXPORT_cstr(jbsb, "\",\"organization\":{\"name\":\"");
+            arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geo2.asn, geo2.asnLen, TRUE);
+            BSB_EXPORT_cstr(jbsb, "\"}},");
         }
-        case ARKIME_FIELD_TYPE_IP_GHASH: {
-            ghash = session->fields[pos]->ghash;
-            if (flags & ARKIME_FIELD_FLAG_CNT) {
-                BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%u,", fieldInfo->dbField, g_hash_table_size(ghash));
-            }
 
-            ArkimeGeoInfo_t       geos[MAX_IPS];
-            uint32_t              cnt = 0;
+        if (arkime_field_get(session, mac2Field)) {
+            SAVE_FIELD_STR_HASH(mac2Field, ARKIME_FIELD_FLAG_ECS_CNT);
+        }
 
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
-            g_hash_table_iter_init(&iter, ghash);
-            while (cnt < MAX_IPS && g_hash_table_iter_next(&iter, &ikey, NULL)) {
-                arkime_db_geo_lookup6(session, *(struct in6_addr *)ikey, &geos[cnt]);
+        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+        BSB_EXPORT_cstr(jbsb, "},"); // Close destination
 
-                if (IN6_IS_ADDR_V4MAPPED((struct in6_addr *)ikey)) {
-                    arkime_ip4tostr(ARKIME_V6_TO_V4(*(struct in6_addr *)ikey), ipsrc, sizeof(ipsrc));
-                } else {
-                    inet_ntop(AF_INET6, ikey, ipsrc, sizeof(ipsrc));
-                }
+        if (geo1.rir)
+            BSB_EXPORT_sprintf(jbsb, "\"srcRIR\":\"%s\",", geo1.rir);
 
-                BSB_EXPORT_sprintf(jbsb, "\"%s\",", ipsrc);
-                cnt++;
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
+        if (geo2.rir)
+            BSB_EXPORT_sprintf(jbsb, "\"dstRIR\":\"%s\",", geo2.rir);
+    } else {/* ipProtocol */
+        BSB_EXPORT_sprintf(jbsb,
+                           "\"source\":{"
+                           "\"bytes\":%" PRIu64 ","
+                           "\"packets\":%u,",
+                           session->bytes[0],
+                           session->packets[0]);
 
-            BSB_EXPORT_sprintf(jbsb, "\"%.*sGEO\":[", fieldInfo->dbFieldLen - 2, fieldInfo->dbField);
-            for (uint32_t i = 0; i < cnt; i++) {
-                if (geos[i].country) {
-                    BSB_EXPORT_sprintf(jbsb, "\"%.*s\",", geos[i].countryLen, geos[i].country);
-                } else {
-                    BSB_EXPORT_cstr(jbsb, "\"---\",");
-                }
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
+        if (arkime_field_get(session, mac1Field)) {
+            SAVE_FIELD_STR_HASH(mac1Field, ARKIME_FIELD_FLAG_ECS_CNT);
+        }
 
-            BSB_EXPORT_sprintf(jbsb, "\"%.*sASN\":[", fieldInfo->dbFieldLen - 2, fieldInfo->dbField);
-            for (uint32_t i = 0; i < cnt; i++) {
-                if (geos[i].asn) {
-                    BSB_EXPORT_sprintf(jbsb, "\"AS%u ", geos[i].asNum);
-                    arkime_db_js0n_str_unquoted(&jbsb, (uint8_t *)geos[i].asn, geos[i].asnLen, TRUE);
-                    BSB_EXPORT_cstr(jbsb, "\",");
+        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+        BSB_EXPORT_cstr(jbsb, "},"); // Close source
 
-                } else {
-                    BSB_EXPORT_cstr(jbsb, "\"---\",");
-                }
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
+        BSB_EXPORT_sprintf(jbsb,
+                           "\"destination\":{"
+                           "\"bytes\":%" PRIu64 ","
+                           "\"packets\":%u,",
+                           session->bytes[1],
+                           session->packets[1]);
 
-            BSB_EXPORT_sprintf(jbsb, "\"%.*sRIR\":[", fieldInfo->dbFieldLen - 2, fieldInfo->dbField);
-            for (uint32_t i = 0; i < cnt; i++) {
-                if (geos[i].rir) {
-                    BSB_EXPORT_sprintf(jbsb, "\"%s\",", geos[i].rir);
-                } else {
-                    BSB_EXPORT_cstr(jbsb, "\"\",");
-                }
-            }
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
+        if (arkime_field_get(session, mac2Field)) {
+            SAVE_FIELD_STR_HASH(mac2Field, ARKIME_FIELD_FLAG_ECS_CNT);
+        }
 
-            if (freeField) {
-                g_hash_table_destroy(ghash);
-            }
+        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+        BSB_EXPORT_cstr(jbsb, "},"); // Close destination
+    }
 
-            break;
+    BSB_EXPORT_sprintf(jbsb,
+                       "\"network\":{\"packets\":%u,"
+                       "\"bytes\":%" PRIu64,
+                       session->packets[0] + session->packets[1],
+                       session->bytes[0] + session->bytes[1]);
+
+    // Currently don't do communityId for ICMP because it requires magic
+    if (session->ses == SESSION_ICMP) {
+        char *communityId = arkime_db_community_id_icmp(session);
+        BSB_EXPORT_sprintf(jbsb, ",\"community_id\":\"1:%s\"", communityId);
+        g_free(communityId);
+    } else if (session->ses != SESSION_OTHER) {
+        char *communityId = arkime_db_community_id(session);
+        BSB_EXPORT_sprintf(jbsb, ",\"community_id\":\"1:%s\"", communityId);
+        g_free(communityId);
+    }
+
+    const ArkimeField_t *vlan = arkime_field_get(session, vlanField);
+    if (vlan && config.fields[vlanField]->type == ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE) {
+        BSB_EXPORT_cstr(jbsb, ",\"vlan\":{");
+        BSB_EXPORT_cstr(jbsb, "\"id-cnt\":");
+        BSB_EXPORT_u64_dec(jbsb, vlan->iarray->len);
+        BSB_EXPORT_cstr(jbsb, ",\"id\":[");
+        for (uint32_t i = 0; i < vlan->iarray->len; i++) {
+            BSB_EXPORT_u64_dec(jbsb, g_array_index(vlan->iarray, uint32_t, i));
+            BSB_EXPORT_u08(jbsb, ',');
         }
-        case ARKIME_FIELD_TYPE_OBJECT: {
-            ArkimeFieldObjectHashStd_t *ohash = session->fields[pos]->ohash;
-            ArkimeFieldObjectSaveFunc saveCB = fieldInfo->object_save;
-            ArkimeFieldObjectFreeFunc freeCB = fieldInfo->object_free;
+        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
+        BSB_EXPORT_cstr(jbsb, "]");
+        BSB_EXPORT_cstr(jbsb, "}"); /* vlan */
+    }
+    BSB_EXPORT_cstr(jbsb, "},"); /* network */
 
-            BSB_EXPORT_sprintf(jbsb, "\"%sCnt\":%d,", fieldInfo->dbField, HASH_COUNT(o_, *ohash));
-            BSB_EXPORT_sprintf(jbsb, "\"%s\":[", fieldInfo->dbField);
 
-            ArkimeFieldObject_t *object;
+    BSB_EXPORT_sprintf(jbsb, "\"client\":{\"bytes\":%" PRIu64 "},",
+                       session->databytes[0]);
+    BSB_EXPORT_sprintf(jbsb, "\"server\":{\"bytes\":%" PRIu64 "},",
+                       session->databytes[1]);
 
-            HASH_FORALL_POP_HEAD2(o_, *ohash, object) {
-                saveCB(&jbsb, object, session);
-                freeCB(object);
+    BSB_EXPORT_sprintf(jbsb,
+                       "\"totDataBytes\":%" PRIu64 ","
+                       "\"segmentCnt\":%u,"
+                       "\"node\":\"%s\",",
+                       session->databytes[0] + session->databytes[1],
+                       session->segments,
+                       config.nodeName);
+
+    if (session->rootId) {
+        BSB_EXPORT_sprintf(jbsb, "\"rootId\":\"%s\",", session->rootId);
+    }
+    BSB_EXPORT_cstr(jbsb, "\"packetPos\":[");
+    if (config.gapPacketPos) {
+        /* Very simple gap encoding, with a gap the same as previous gap represented as 0.
+         * Negative numbers, and numbers after the negative number are not encoded.
+         * This should reduce the saved size by over 50%.
+         * Future work of switching to binary varint with base64 might help more.
+         */
+        int64_t last = 0;
+        int64_t lastgap = 0;
+        uint32_t off = 0;
+        int64_t fpos = 0;
+        for (uint32_t i = 0; arkime_varint_next(&session->filePosArray, &off, &fpos); i++) {
+            if (i != 0)
                 BSB_EXPORT_u08(jbsb, ',');
+            if (fpos < 0) {
+                last = 0;
+                lastgap = 0;
+                BSB_EXPORT_i64_dec(jbsb, fpos);
+            } else {
+                if (fpos - last == lastgap) {
+                    BSB_EXPORT_u08(jbsb, '0');
+                } else {
+                    lastgap = fpos - last;
+                    BSB_EXPORT_i64_dec(jbsb, lastgap);
+                }
+                last = fpos;
             }
-            ARKIME_TYPE_FREE(ArkimeFieldObjectHashStd_t, ohash);
-
-            BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-            BSB_EXPORT_cstr(jbsb, "],");
         }
-        break;
-        } /* switch */
-        if (freeField) {
-            ARKIME_TYPE_FREE(ArkimeField_t, session->fields[pos]);
-            session->fields[pos] = 0;
+    } else {
+        // Do NOT remove this, S3 and others use this
+        uint32_t off = 0;
+        int64_t fpos = 0;
+        for (uint32_t i = 0; arkime_varint_next(&session->filePosArray, &off, &fpos); i++) {
+            if (i != 0)
+                BSB_EXPORT_u08(jbsb, ',');
+            BSB_EXPORT_i64_dec(jbsb, fpos);
         }
     }
+    BSB_EXPORT_cstr(jbsb, "],");
 
-    if (inGroupNum) {
-        BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
-        BSB_EXPORT_cstr(jbsb, "},");
+    if (config.enablePacketLen) {
+        BSB_EXPORT_cstr(jbsb, "\"packetLen\":[");
+        uint32_t off = 0;
+        int64_t len = 0;
+        for (uint32_t i = 0; arkime_varint_next(&session->fileLenArray, &off, &len); i++) {
+            if (i != 0)
+                BSB_EXPORT_u08(jbsb, ',');
+            BSB_EXPORT_u64_dec(jbsb, (uint16_t)len);
+        }
+        BSB_EXPORT_cstr(jbsb, "],");
+    }
+
+    BSB_EXPORT_cstr(jbsb, "\"fileId\":[");
+    for (uint32_t i = 0; i < session->fileNumArray->len; i++) {
+        if (i != 0)
+            BSB_EXPORT_u08(jbsb, ',');
+        BSB_EXPORT_u64_dec(jbsb, (uint32_t)g_array_index(session->fileNumArray, uint32_t, i));
+    }
+    BSB_EXPORT_cstr(jbsb, "],");
+
+    if (ecsEventProvider && ecsEventDataset) {
+        BSB_EXPORT_sprintf(jbsb, "\"event\":{\"provider\":\"%s\", \"dataset\":\"%s\"},", ecsEventProvider, ecsEventDataset);
+    } else if (ecsEventProvider) {
+        BSB_EXPORT_sprintf(jbsb, "\"event\":{\"provider\":\"%s\"},", ecsEventProvider);
+    } else if (ecsEventDataset) {
+        BSB_EXPORT_sprintf(jbsb, "\"event\":{\"dataset\":\"%s\"},", ecsEventDataset);
     }
 
+    arkime_db_save_fields(&jbsb, session, dbInfo[thread].sortedFieldsRank, final);
+
     BSB_EXPORT_rewind(jbsb, 1); // Remove last comma
     BSB_EXPORT_cstr(jbsb, "}\n");
 
@@ -1549,6 +2040,126 @@ cleanup:
     ARKIME_UNLOCK(dbInfo[thread].lock);
 }
 /******************************************************************************/
+/* Microbenchmark of the session field serialization.  A corpus of sessions is
+ * filled with random values for the fields that are defined and then saved
+ * with arkime_db_save_fields.  Runs on the main thread, the geo lookups use
+ * the extra geo cache after the packet threads.
+ */
+LOCAL void arkime_db_cmd_save_bench(int argc, char **argv, gpointer cc)
+{
+    char                  output[500];
+    char                  str[100];
+    BSB                   bsb;
+    struct timespec       start, stop;
+    uint64_t              bytes = 0;
+    uint32_t              errors = 0;
+    uint32_t              maxJsonSize = 0;
+
+    uint32_t num = 20000;
+    if (argc > 1) {
+        num = MIN(1000000, MAX(100, strtoul(argv[1], NULL, 10)));
+    }
+
+    BSB_INIT(bsb, output, sizeof(output));
+
+    // Only plain fields, setting ones with rules or callbacks would have side effects
+    const int maxDbField = config.maxDbField;
+    int *fields = ARKIME_SIZE_ALLOC("bench", sizeof(int) * maxDbField);
+    int  fieldsNum = 0;
+    for (int pos = 0; pos < maxDbField; pos++) {
+        const ArkimeFieldInfo_t *info = config.fields[pos];
+        if (!info || info->ruleEnabled || info->setCb || info->type == ARKIME_FIELD_TYPE_OBJECT ||
+            (info->flags & (ARKIME_FIELD_FLAG_DISABLED | ARKIME_FIELD_FLAG_NOSAVE)))
+            continue;
+        fields[fieldsNum++] = pos;
+    }
+
+    if (fieldsNum == 0) {
+        BSB_EXPORT_cstr(bsb, "No fields defined\n");
+        ARKIME_SIZE_FREE("bench", fields);
+        arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+        return;
+    }
+
+    short *index = ARKIME_SIZE_ALLOC("bench", sizeof(short) * maxDbField);
+    short *rank = ARKIME_SIZE_ALLOC("bench", sizeof(short) * maxDbField);
+    arkime_db_fields_rank(index, rank, 0, maxDbField);
+
+    // Roughly what a web or dns session has, 8 to 20 fields with 1 to 3 values each
+    ArkimeSession_t **sessions = ARKIME_SIZE_ALLOC("bench", sizeof(ArkimeSession_t *) * num);
+    for (uint32_t i = 0; i < num; i++) {
+        ArkimeSession_t *session = sessions[i] = ARKIME_TYPE_ALLOC0(ArkimeSession_t);
+
+        for (int n = 8 + random() % 13; n > 0; n--) {
+            const int pos = fields[random() % fieldsNum];
+            for (int v = 1 + random() % 3; v > 0; v--) {
+                switch (config.fields[pos]->type) {
+                case ARKIME_FIELD_TYPE_INT:
+                case ARKIME_FIELD_TYPE_INT_ARRAY:
+                case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
+                case ARKIME_FIELD_TYPE_INT_HASH:
+                case ARKIME_FIELD_TYPE_INT_GHASH:
+                    arkime_field_int_add(pos, session, random() % 100000);
+                    break;
+                case ARKIME_FIELD_TYPE_FLOAT:
+                case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
+                case ARKIME_FIELD_TYPE_FLOAT_GHASH:
+                    arkime_field_float_add(pos, session, (random() % 100000) / 100.0);
+                    break;
+                case ARKIME_FIELD_TYPE_IP:
+                case ARKIME_FIELD_TYPE_IP_GHASH:
+                    arkime_field_ip4_add(pos, session, htonl(0x0a000000 | (random() & 0xffffff)));
+                    break;
+                default: {
+                    const int len = snprintf(str, sizeof(str), "value-%ld.example.com", random() % 10000);
+                    arkime_field_string_add(pos, session, str, len, TRUE);
+                }
+                }
+            }
+        }
+
+        uint32_t jsonSize = 0;
+        for (int f = 0; f < session->fieldsCnt; f++) {
+            jsonSize += session->fieldsSparse[f]->jsonSize;
+        }
+        maxJsonSize = MAX(maxJsonSize, jsonSize);
+    }
+
+    // Same slack arkime_db_save_session gives the fields
+    const uint32_t bufSize = maxJsonSize + 1300;
+    char *buf = ARKIME_SIZE_ALLOC("bench", bufSize);
+
+    geoCacheOff = TRUE;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < num; i++) {
+        BSB jbsb;
+        BSB_INIT(jbsb, buf, bufSize);
+        arkime_db_save_fields(&jbsb, sessions[i], rank, TRUE);
+        bytes += BSB_LENGTH(jbsb);
+        errors += BSB_IS_ERROR(jbsb);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    geoCacheOff = FALSE;
+
+    const double ns = (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+    BSB_EXPORT_sprintf(bsb, "Session field serialization with %u sessions from %d fields\n", num, fieldsNum);
+    BSB_EXPORT_sprintf(bsb, "  %8.1f ns/session\n", ns / num);
+    BSB_EXPORT_sprintf(bsb, "  %8.1f bytes/session\n", (double)bytes / num);
+    BSB_EXPORT_sprintf(bsb, "  %8u overflows\n", errors);
+
+    for (uint32_t i = 0; i < num; i++) {
+        arkime_field_free(sessions[i]);
+        ARKIME_TYPE_FREE(ArkimeSession_t, sessions[i]);
+    }
+    ARKIME_SIZE_FREE("bench", sessions);
+    ARKIME_SIZE_FREE("bench", buf);
+    ARKIME_SIZE_FREE("bench", index);
+    ARKIME_SIZE_FREE("bench", rank);
+    ARKIME_SIZE_FREE("bench", fields);
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+}
+/******************************************************************************/
 LOCAL uint64_t zero_atoll(const char *v)
 {
     if (v)
@@ -1725,6 +2336,8 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
     static uint64_t       lastFragsDropped[NUMBER_OF_STATS];
     static uint64_t       lastOverloadDropped[NUMBER_OF_STATS];
     static uint64_t       lastESDropped[NUMBER_OF_STATS];
+    static uint64_t       lastESSpooled[NUMBER_OF_STATS];
+    static uint64_t       lastESSpoolReplayed[NUMBER_OF_STATS];
     static uint64_t       lastDupDropped[NUMBER_OF_STATS];
     static struct rusage  lastUsage[NUMBER_OF_STATS];
     static struct timeval lastTime[NUMBER_OF_STATS];
@@ -1755,6 +2368,16 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
     uint64_t writtenBytes    = arkime_packet_written_bytes();
     uint64_t unwrittenBytes  = arkime_packet_unwritten_bytes();
 
+    ARKIME_LOCK(spool);
+    uint64_t esSpoolBytes    = spoolBytes;
+    uint64_t esSpoolAge      = spoolBytes > 0 && (uint64_t)currentTime.tv_sec > spoolTime ? currentTime.tv_sec - spoolTime : 0;
+    uint64_t esSpooled       = spoolSpooled;
+    uint64_t esSpoolReplayed = spoolReplayed;
+    ARKIME_UNLOCK(spool);
+
+    ArkimePoolInfo_t poolInfo;
+    arkime_pool_stats(&poolInfo);
+
     // If totalDropped/overloadDropped/dupDropped wrapped we pretend no drops this time
     if (unlikely(totalDropped < lastDropped[n])) {
         lastDropped[n] = totalDropped;
@@ -1834,6 +2457,9 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
                                        "\"frags\": %u,"
                                        "\"needSave\": %u,"
                                        "\"closeQueue\": %u,"
+                                       "\"poolBytes\": %" PRIu64 ","
+                                       "\"poolInUse\": %" PRIu64 ","
+                                       "\"poolFree\": %" PRIu64 ","
                                        "\"totalPackets\": %" PRIu64 ","
                                        "\"totalK\": %" PRIu64 ","
                                        "\"totalSessions\": %" PRIu64 ","
@@ -1854,6 +2480,10 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
                                        "\"deltaFragsDropped\": %" PRIu64 ","
                                        "\"deltaOverloadDropped\": %" PRIu64 ","
                                        "\"deltaESDropped\": %" PRIu64 ","
+                                       "\"esSpoolBytes\": %" PRIu64 ","
+                                       "\"esSpoolAge\": %" PRIu64 ","
+                                       "\"deltaESSpooled\": %" PRIu64 ","
+                                       "\"deltaESSpoolReplayed\": %" PRIu64 ","
                                        "\"deltaDupDropped\": %" PRIu64 ","
                                        "\"esHealthMS\": %" PRIu64 ","
                                        "\"deltaMS\": %" PRIu64 ","
@@ -1878,6 +2508,9 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
                                        arkime_packet_frags_size(),
                                        arkime_session_need_save_outstanding(),
                                        arkime_session_close_outstanding(),
+                                       poolInfo.bytes,
+                                       poolInfo.inUse,
+                                       poolInfo.cached + poolInfo.depot,
                                        dbTotalPackets[n],
                                        dbTotalK[n],
                                        dbTotalSessions[n],
@@ -1898,6 +2531,10 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
                                        (fragsDropped - lastFragsDropped[n]),
                                        (overloadDropped - lastOverloadDropped[n]),
                                        (esDropped - lastESDropped[n]),
+                                       esSpoolBytes,
+                                       esSpoolAge,
+                                       (esSpooled - lastESSpooled[n]),
+                                       (esSpoolReplayed - lastESSpoolReplayed[n]),
                                        (dupDropped - lastDupDropped[n]),
                                        esHealthMS,
                                        diffms,
@@ -1914,6 +2551,8 @@ LOCAL void arkime_db_update_stats(int n, gboolean sync)
     lastFragsDropped[n]    = fragsDropped;
     lastOverloadDropped[n] = overloadDropped;
     lastESDropped[n]       = esDropped;
+    lastESSpooled[n]       = esSpooled;
+    lastESSpoolReplayed[n] = esSpoolReplayed;
     lastDupDropped[n]      = dupDropped;
     lastUsage[n]           = usage;
 
@@ -2438,6 +3077,7 @@ LOCAL void arkime_db_load_geo_country(const char *name)
     }
     geoCountryIsCity = strstr(country->metadata.database_type, "City") != 0;
     geoCountry = country;
+    ARKIME_THREAD_INCR(geoGeneration);
 }
 /******************************************************************************/
 LOCAL void arkime_db_load_geo_asn(const char *name)
@@ -2452,6 +3092,7 @@ LOCAL void arkime_db_load_geo_asn(const char *name)
         arkime_free_later(geoASN, (GDestroyNotify) arkime_db_free_mmdb);
     }
     geoASN = asn;
+    ARKIME_THREAD_INCR(geoGeneration);
 }
 /******************************************************************************/
 LOCAL void arkime_db_load_rir(const char *name)
@@ -2913,6 +3554,8 @@ LOCAL void *arkime_db_stats_thread(void *UNUSED(threadp))
 LOCAL  guint timers[10];
 void arkime_db_init()
 {
+    dbInfo = arkime_numa_alloc0("dbInfo", sizeof(DbInfo_t), config.packetThreads);
+
     if (config.tests) {
         ARKIME_LOCK(outputted);
         fprintf(stderr, "{\"sessions3\": [\n");
@@ -2956,6 +3599,15 @@ void arkime_db_init()
         esBulkQuery = arkime_config_str(NULL, "esBulkQuery", "/_bulk");
         esBulkQueryLen = strlen(esBulkQuery);
 
+        esSpoolDir = arkime_config_str(NULL, "esSpoolDir", NULL);
+        if (esSpoolDir && !esSpoolDir[0]) {
+            g_free(esSpoolDir);
+            esSpoolDir = NULL;
+        }
+        if (esSpoolDir) {
+            arkime_db_spool_init();
+        }
+
         arkime_db_health_check(GINT_TO_POINTER(1));
     }
     myPid = getpid() & 0xffff;
@@ -2972,6 +3624,16 @@ void arkime_db_init()
 
     arkime_add_can_quit(arkime_db_can_quit, "DB");
 
+    uint32_t geoCacheSize = arkime_config_int(NULL, "geoCacheSize", 4096, 0, 0x1000000);
+    if (geoCacheSize > 0) {
+        geoCacheSets = 1;
+        while (geoCacheSets * ARKIME_DB_GEO_WAYS < geoCacheSize)
+            geoCacheSets <<= 1;
+        geoCaches = arkime_numa_alloc0("geoCaches", sizeof(ArkimeDbGeoCache_t), config.packetThreads);
+        arkime_command_register("geo-stats", arkime_db_geo_cmd_stats, "Per packet thread geo lookup cache stats");
+    }
+    arkime_command_register("db-save-bench", arkime_db_cmd_save_bench, "Benchmark session field serialization - db-save-bench [<sessions>]");
+
     // Find the first geo file that exists in our list and use that one.
     // If none could be loaded, and setting not blank, print out warning
     struct stat     sb;
@@ -13,24 +13,36 @@
  * We size the hashtable assuming DEDUP_SLOT_FACTOR elements per
  * slot, but actually allow DEDUP_SIZE_FACTOR elements.
  *
- * Hash ip + tcp/udp hdr using either MD5 or XXH3_128bits.
+ * Hash ip + tcp/udp hdr into a 128 bit fingerprint using MD5, XXH3_128bits
+ * or, in builds with AES-NI, an AES CBC-MAC with keys picked at startup.
+ * dedupHash picks which one.
  *
  * When dedup is enabled, arkime_dedup_should_drop is one of the
  * top CPU consumers at high packet rates. The ctrl array acts as
  * a cheap filter to avoid touching the larger hashes array on
- * non-matches. MD5 is used over XXH3 to keep the function small
- * and reduce instruction cache pressure.
+ * non-matches. With SSE2 each slot's ctrl bytes are padded out so the
+ * whole row is checked with one or two compares instead of a byte at a time.
+ * MD5 is the default over XXH3 to keep the function small and reduce
+ * instruction cache pressure.
+ *
+ * dedup-bench replays a pcap through just this stage to compare them.
  */
 
 #include "arkime.h"
+#include "pcap.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef __AES__
+#include <wmmintrin.h>
+#endif
 
-// MD5 is ~4% faster than XXH3 in production due to smaller icache footprint
-#define DEDUP_USE_MD5
-
-#ifdef DEDUP_USE_MD5
 #define OPENSSL_SUPPRESS_DEPRECATED
 #include <openssl/md5.h>
-#else
+
 #define XXH_STATIC_LINKING_ONLY
 #define XXH_IMPLEMENTATION
 #if defined(__clang__)
@@ -40,7 +52,6 @@
 #else
 #include "xxhash.h"
 #endif
-#endif
 
 extern ArkimeConfig_t          config;
 extern GHashTable             *collapseTable;
@@ -48,8 +59,14 @@ extern ArkimeSessionIdTracking sessionIdTracking;
 
 // How many items in each hashtable we expect to be used, must be less than DEDUP_SIZE_FACTOR
 #define DEDUP_SLOT_FACTOR   15
-// How many items in each hashtable we actually allow, must be less than 256 and more than DEDUP_SLOT_FACTOR
+// How many items in each hashtable we actually allow, must be less than 32 and more than DEDUP_SLOT_FACTOR
 #define DEDUP_SIZE_FACTOR   20
+// Ctrl bytes per hashtable, padded so a vector load never crosses into the next one
+#ifdef __SSE2__
+#define DEDUP_CTRL_STRIDE   32
+#else
+#define DEDUP_CTRL_STRIDE   DEDUP_SIZE_FACTOR
+#endif
 
 LOCAL uint32_t              dedupSeconds;
 LOCAL uint32_t              dedupSlots;
@@ -60,6 +77,16 @@ LOCAL uint32_t              dedupSize;
 typedef enum { DEDUP_PLAIN, DEDUP_VLAN, DEDUP_VNI } DedupMode;
 LOCAL DedupMode             dedupMode;
 
+typedef enum { DEDUP_HASH_MD5, DEDUP_HASH_XXH3, DEDUP_HASH_AES, DEDUP_HASH_NUM } DedupHash;
+LOCAL const char           *dedupHashNames[DEDUP_HASH_NUM] = {"md5", "xxh3", "aes"};
+LOCAL DedupHash             dedupHash;
+LOCAL gboolean              dedupVector;
+#ifdef __AES__
+// AES-128 has 10 rounds, so 11 round keys
+#define DEDUP_AES_ROUNDS    10
+LOCAL __m128i               dedupAesKeys[DEDUP_AES_ROUNDS + 1];
+#endif
+
 typedef struct dedupsecond {
     uint8_t        *ctrl;
     uint8_t        *hashes;
@@ -73,21 +100,40 @@ LOCAL DedupSeconds_t *seconds;
 
 
 /******************************************************************************/
-int arkime_dedup_should_drop(const ArkimePacket_t *packet, int headerLen)
+#ifdef __AES__
+/* A full AES-128 encryption with independent random round keys */
+LOCAL inline __m128i arkime_dedup_aes_block(__m128i b)
 {
-    // Cap headerLen so the headerLen-derived copies below can't overflow the
-    // fixed-size md[]/buf[] stack buffers
-    if (headerLen <= 0 || headerLen > 256) {
-        return 0;
+    b = _mm_xor_si128(b, dedupAesKeys[0]);
+    for (int r = 1; r < DEDUP_AES_ROUNDS; r++) {
+        b = _mm_aesenc_si128(b, dedupAesKeys[r]);
     }
+    return _mm_aesenclast_si128(b, dedupAesKeys[DEDUP_AES_ROUNDS]);
+}
+/******************************************************************************/
+/* CBC-MAC with the length encrypted first so no message is a prefix of
+ * another.  The keys are picked at startup, so without them differing
+ * headers can't be made to collide.
+ */
+LOCAL void arkime_dedup_aes(const uint8_t *buf, int len, uint8_t *md)
+{
+    __m128i h = arkime_dedup_aes_block(_mm_set1_epi32(len));
+    int     i;
 
-    struct timespec currentTime;
-    clock_gettime(CLOCK_MONOTONIC_COARSE, &currentTime);
-
-    uint32_t secondSlot = currentTime.tv_sec % dedupSeconds;
-
-    // Create hash, headerLen should be length of ip & tcp/udp header
-    uint8_t md[16];
+    for (i = 0; i + 16 <= len; i += 16) {
+        h = arkime_dedup_aes_block(_mm_xor_si128(h, _mm_loadu_si128((const __m128i *)(buf + i))));
+    }
+    if (i < len) {
+        uint8_t last[16] = {0};
+        memcpy(last, buf + i, len - i);
+        h = arkime_dedup_aes_block(_mm_xor_si128(h, _mm_loadu_si128((const __m128i *)last)));
+    }
+    _mm_storeu_si128((__m128i *)md, h);
+}
+#endif
+/******************************************************************************/
+LOCAL void arkime_dedup_fingerprint(DedupHash hash, const ArkimePacket_t *packet, int headerLen, uint8_t *md)
+{
     const uint8_t *const ptr = packet->pkt + packet->ipOffset;
 
     uint8_t prefix[4];
@@ -121,27 +167,29 @@ int arkime_dedup_should_drop(const ArkimePacket_t *packet, int headerLen)
         break;
     }
 
-#ifdef DEDUP_USE_MD5
-    MD5_CTX ctx;
-    MD5_Init(&ctx);
-    if (prefix_len) {
-        MD5_Update(&ctx, prefix, prefix_len);
-    }
-    if ((ptr[0] & 0xf0) == 0x40) {
-        MD5_Update(&ctx, ptr, 8);
-        // Skip TTL (1 byte)
-        MD5_Update(&ctx, ptr + 9, 1);
-        // Skip Header checksum (2 bytes)
-        MD5_Update(&ctx, ptr + 12, headerLen - 12);
-    } else {
-        MD5_Update(&ctx, ptr, 7);
-        // Skip HOP
-        MD5_Update(&ctx, ptr + 8, headerLen - 8);
+    if (hash == DEDUP_HASH_MD5) {
+        MD5_CTX ctx;
+        MD5_Init(&ctx);
+        if (prefix_len) {
+            MD5_Update(&ctx, prefix, prefix_len);
+        }
+        if ((ptr[0] & 0xf0) == 0x40) {
+            MD5_Update(&ctx, ptr, 8);
+            // Skip TTL (1 byte)
+            MD5_Update(&ctx, ptr + 9, 1);
+            // Skip Header checksum (2 bytes)
+            MD5_Update(&ctx, ptr + 12, headerLen - 12);
+        } else {
+            MD5_Update(&ctx, ptr, 7);
+            // Skip HOP
+            MD5_Update(&ctx, ptr + 8, headerLen - 8);
+        }
+        MD5_Final(md, &ctx);
+        return;
     }
-    MD5_Final(md, &ctx);
-#else
+
     uint8_t buf[260];
-    XXH128_hash_t hash;
+    int     len;
     if (prefix_len) {
         memcpy(buf, prefix, prefix_len);
     }
@@ -149,59 +197,140 @@ int arkime_dedup_should_drop(const ArkimePacket_t *packet, int headerLen)
         memcpy(buf + prefix_len, ptr, 8);
         buf[prefix_len + 8] = ptr[9];  // protocol, skip TTL (1 byte)
         memcpy(buf + prefix_len + 9, ptr + 12, headerLen - 12); // skip checksum (2 bytes)
-        hash = XXH3_128bits(buf, prefix_len + 9 + (headerLen - 12));
+        len = prefix_len + 9 + (headerLen - 12);
     } else {
         memcpy(buf + prefix_len, ptr, 7);
         memcpy(buf + prefix_len + 7, ptr + 8, headerLen - 8); // skip HOP (1 byte)
-        hash = XXH3_128bits(buf, prefix_len + 7 + (headerLen - 8));
+        len = prefix_len + 7 + (headerLen - 8);
+    }
+
+#ifdef __AES__
+    if (hash == DEDUP_HASH_AES) {
+        arkime_dedup_aes(buf, len, md);
+        return;
     }
-    memcpy(md, &hash, 16);
 #endif
+    XXH128_hash_t xxh = XXH3_128bits(buf, len);
+    memcpy(md, &xxh, 16);
+}
+/******************************************************************************/
+LOCAL int arkime_dedup_find_scalar(const DedupSeconds_t *second, uint32_t h, int count, uint8_t tag, const uint8_t *md)
+{
+    const uint8_t *ctrl_base = second->ctrl + h * DEDUP_CTRL_STRIDE;
+    for (int c = 0; c < count; c++) {
+        if (tag == ctrl_base[c] && memcmp(md, second->hashes + 16 * (h * DEDUP_SIZE_FACTOR + c), 16) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+/******************************************************************************/
+#ifdef __SSE2__
+/* Bit c of the mask is set when ctrl byte c matches the tag, then only those
+ * entries have their fingerprint compared.
+ */
+LOCAL int arkime_dedup_find_vector(const DedupSeconds_t *second, uint32_t h, int count, uint8_t tag, const uint8_t *md)
+{
+    const uint8_t *ctrl_base = second->ctrl + h * DEDUP_CTRL_STRIDE;
+    uint32_t       mask;
+
+#ifdef __AVX2__
+    mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)ctrl_base), _mm256_set1_epi8((char)tag)));
+#else
+    const __m128i t = _mm_set1_epi8((char)tag);
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)ctrl_base), t));
+    if (count > 16) {
+        mask |= (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(ctrl_base + 16)), t)) << 16;
+    }
+#endif
+    mask &= (1U << count) - 1;
+
+    if (!mask)
+        return 0;
+
+    const __m128i want = _mm_loadu_si128((const __m128i *)md);
+    do {
+        const int c = __builtin_ctz(mask);
+        const __m128i have = _mm_loadu_si128((const __m128i *)(second->hashes + 16 * (h * DEDUP_SIZE_FACTOR + c)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(have, want)) == 0xffff)
+            return 1;
+        mask &= mask - 1;
+    } while (mask);
+
+    return 0;
+}
+#endif
+/******************************************************************************/
+LOCAL int arkime_dedup_check(DedupSeconds_t *secs, DedupHash hash, gboolean vector, const ArkimePacket_t *packet, int headerLen)
+{
+    // Cap headerLen so the headerLen-derived copies below can't overflow the
+    // fixed-size md[]/buf[] stack buffers
+    if (headerLen <= 0 || headerLen > 256) {
+        return 0;
+    }
+
+    struct timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &currentTime);
+
+    uint32_t secondSlot = currentTime.tv_sec % dedupSeconds;
+
+    // Create hash, headerLen should be length of ip & tcp/udp header
+    uint8_t md[16];
+    arkime_dedup_fingerprint(hash, packet, headerLen, md);
 
     const int h = ((uint32_t *)md)[0] & dedupSlotsMask;
     const uint8_t tag = md[3];
 
     // First see if we need to clean up old slot, and block all new folks while we do
     // In theory no one should be using this slot because we hadn't been searching it for a second.
-    if (ARKIME_THREAD_ATOMIC_LOAD(seconds[secondSlot].tv_sec) != currentTime.tv_sec) {
-        ARKIME_LOCK(seconds[secondSlot].lock);
-        if (seconds[secondSlot].tv_sec != currentTime.tv_sec) { // Check critical section again inside the lock
-            if (seconds[secondSlot].error) {
+    if (ARKIME_THREAD_ATOMIC_LOAD(secs[secondSlot].tv_sec) != currentTime.tv_sec) {
+        ARKIME_LOCK(secs[secondSlot].lock);
+        if (secs[secondSlot].tv_sec != currentTime.tv_sec) { // Check critical section again inside the lock
+            if (secs[secondSlot].error) {
                 uint32_t pcount = 0;
                 for (uint32_t i = 0; i < dedupSlots; i++)
-                    pcount += seconds[secondSlot].counts[i];
+                    pcount += secs[secondSlot].counts[i];
                 LOG("WARNING - Ran out of room, increase dedupPackets to %u or above. pcount: %u", (dedupSlots + 1) * DEDUP_SLOT_FACTOR, pcount);
-                seconds[secondSlot].error = 0;
+                secs[secondSlot].error = 0;
             }
             // Invalidate before wiping so the lock free searchers below skip
             // this slot until the wipe is done and published
-            ARKIME_THREAD_ATOMIC_STORE(seconds[secondSlot].tv_sec, 0);
-            memset(seconds[secondSlot].counts, 0, dedupSlots);
-            ARKIME_THREAD_ATOMIC_STORE(seconds[secondSlot].tv_sec, (uint32_t)currentTime.tv_sec);
+            ARKIME_THREAD_ATOMIC_STORE(secs[secondSlot].tv_sec, 0);
+            memset(secs[secondSlot].counts, 0, dedupSlots);
+            ARKIME_THREAD_ATOMIC_STORE(secs[secondSlot].tv_sec, (uint32_t)currentTime.tv_sec);
         }
-        ARKIME_UNLOCK(seconds[secondSlot].lock);
+        ARKIME_UNLOCK(secs[secondSlot].lock);
     }
 
     // Search all valid slots
     for (uint32_t s = 0; s < dedupSeconds; s++) {
 
         // If slot is too old, or mid wipe (tv_sec 0), just skip it
-        if (currentTime.tv_sec - dedupSeconds + 1 >= ARKIME_THREAD_ATOMIC_LOAD(seconds[s].tv_sec)) {
+        if (currentTime.tv_sec - dedupSeconds + 1 >= ARKIME_THREAD_ATOMIC_LOAD(secs[s].tv_sec)) {
             continue;
         }
 
-        int count = ARKIME_THREAD_ATOMIC_LOAD(seconds[s].counts[h]);
-        const uint8_t *ctrl_base = seconds[s].ctrl + h * DEDUP_SIZE_FACTOR;
-        for (int c = 0; c < count; c++) {
-            if (tag == ctrl_base[c] && memcmp(md, seconds[s].hashes + 16 * (h * DEDUP_SIZE_FACTOR + c), 16) == 0) {
+        // Racing writers can push the count past DEDUP_SIZE_FACTOR, see below
+        int count = ARKIME_THREAD_ATOMIC_LOAD(secs[s].counts[h]);
+        count = MIN(count, DEDUP_SIZE_FACTOR);
+        if (!count)
+            continue;
+
+#ifdef __SSE2__
+        if (vector) {
+            if (arkime_dedup_find_vector(&secs[s], h, count, tag, md))
                 return 1;
-            }
+            continue;
         }
+#endif
+        if (arkime_dedup_find_scalar(&secs[s], h, count, tag, md))
+            return 1;
     }
+    (void)vector;
 
     // Is there space to add
-    if (seconds[secondSlot].counts[h] >= DEDUP_SIZE_FACTOR) {
-        seconds[secondSlot].error = 1;
+    if (secs[secondSlot].counts[h] >= DEDUP_SIZE_FACTOR) {
+        secs[secondSlot].error = 1;
         return 0;
     }
 
@@ -210,38 +339,221 @@ int arkime_dedup_should_drop(const ArkimePacket_t *packet, int headerLen)
     // duplicate can slip through briefly (fail open). The entry may also still hold
     // the previous occupant from dedupSeconds ago, so a packet identical to one from
     // back then can very rarely be dropped as a duplicate.
-    int c = ARKIME_THREAD_INCROLD(seconds[secondSlot].counts[h]);
+    int c = ARKIME_THREAD_INCROLD(secs[secondSlot].counts[h]);
     if (c >= DEDUP_SIZE_FACTOR) {
-        seconds[secondSlot].error = 1;
+        secs[secondSlot].error = 1;
         return 0;
     }
-    seconds[secondSlot].ctrl[h * DEDUP_SIZE_FACTOR + c] = tag;
-    memcpy(seconds[secondSlot].hashes + 16 * (h * DEDUP_SIZE_FACTOR + c), md, 16);
+    secs[secondSlot].ctrl[h * DEDUP_CTRL_STRIDE + c] = tag;
+    memcpy(secs[secondSlot].hashes + 16 * (h * DEDUP_SIZE_FACTOR + c), md, 16);
 
     return 0;
 }
 /******************************************************************************/
-void arkime_dedup_init()
+int arkime_dedup_should_drop(const ArkimePacket_t *packet, int headerLen)
 {
-    if (!config.enablePacketDedup)
+    return arkime_dedup_check(seconds, dedupHash, dedupVector, packet, headerLen);
+}
+/******************************************************************************/
+LOCAL DedupSeconds_t *arkime_dedup_alloc_seconds()
+{
+    DedupSeconds_t *secs = ARKIME_SIZE_ALLOC0("dedup seconds", sizeof(DedupSeconds_t) * dedupSeconds);
+    for (uint32_t i = 0; i < dedupSeconds; i++) {
+        ARKIME_LOCK_INIT(secs[i].lock);
+        secs[i].counts = ARKIME_SIZE_ALLOC0("dedup counts", dedupSlots);
+        secs[i].ctrl = ARKIME_SIZE_ALLOC0("dedup ctrl", dedupSlots * DEDUP_CTRL_STRIDE);
+        secs[i].hashes = ARKIME_SIZE_ALLOC("dedup hashes", dedupSize * 16);
+    }
+    return secs;
+}
+/******************************************************************************/
+LOCAL void arkime_dedup_free_seconds(DedupSeconds_t *secs)
+{
+    for (uint32_t i = 0; i < dedupSeconds; i++) {
+        ARKIME_SIZE_FREE("dedup counts", secs[i].counts);
+        ARKIME_SIZE_FREE("dedup ctrl", secs[i].ctrl);
+        ARKIME_SIZE_FREE("dedup hashes", secs[i].hashes);
+    }
+    ARKIME_SIZE_FREE("dedup seconds", secs);
+}
+/******************************************************************************/
+/* Find the ip header and the same headerLen packet.c would pass for plain
+ * ethernet/vlan tcp and udp packets, others return 0 and aren't replayed.
+ */
+SUPPRESS_ALIGNMENT
+LOCAL int arkime_dedup_bench_decode(const uint8_t *pkt, int len, int dlt, int *ipOffset)
+{
+    int off = 0;
+    if (dlt == DLT_EN10MB) {
+        if (len < 14)
+            return 0;
+        uint16_t ethertype = (pkt[12] << 8) | pkt[13];
+        off = 14;
+        while ((ethertype == 0x8100 || ethertype == 0x88a8) && len >= off + 4) {
+            ethertype = (pkt[off + 2] << 8) | pkt[off + 3];
+            off += 4;
+        }
+        if (ethertype != 0x0800 && ethertype != 0x86dd)
+            return 0;
+    } else if (dlt != DLT_RAW) {
+        return 0;
+    }
+
+    const uint8_t *ip = pkt + off;
+    int ipProtocol, ipHdrLen, l4Len;
+    if (len >= off + 20 && (ip[0] & 0xf0) == 0x40) {
+        ipHdrLen = 4 * (ip[0] & 0x0f);
+        ipProtocol = ip[9];
+        l4Len = ((ip[2] << 8) | ip[3]) - ipHdrLen;
+        if ((((ip[6] << 8) | ip[7]) & 0x3fff) != 0) // fragments
+            return 0;
+    } else if (len >= off + 40 && (ip[0] & 0xf0) == 0x60) {
+        ipHdrLen = 40;
+        ipProtocol = ip[6];
+        l4Len = (ip[4] << 8) | ip[5];
+    } else {
+        return 0;
+    }
+
+    if (ipHdrLen < 20 || l4Len < 0 || off + ipHdrLen + MIN(l4Len, 20) > len)
+        return 0;
+
+    *ipOffset = off;
+    if (ipProtocol == IPPROTO_TCP && l4Len >= 20)
+        return ipHdrLen + 20;
+    if (ipProtocol == IPPROTO_UDP && l4Len >= 8)
+        return ipHdrLen + 8 + MIN(12, MIN(l4Len, len - off - ipHdrLen) - 8);
+    return 0;
+}
+/******************************************************************************/
+/* Replays the tcp and udp packets of a pcap through just the dedup check with
+ * each fingerprint and probe, using its own tables so a running capture isn't
+ * disturbed.  The packets are all loaded first so the file read isn't timed.
+ */
+LOCAL void arkime_dedup_cmd_bench(int argc, char **argv, gpointer cc)
+{
+    char                  output[1000];
+    char                  errbuf[PCAP_ERRBUF_SIZE];
+    BSB                   bsb;
+    struct timespec       start, stop;
+    struct pcap_pkthdr   *h;
+    const u_char         *data;
+
+    BSB_INIT(bsb, output, sizeof(output));
+
+    if (argc < 2) {
+        BSB_EXPORT_cstr(bsb, "Usage: dedup-bench <pcap file> [<max packets>]\n");
+        arkime_command_respond(cc, output, BSB_LENGTH(bsb));
         return;
+    }
+
+    uint32_t max = 1000000;
+    if (argc > 2) {
+        max = MIN(10000000, MAX(1000, strtoul(argv[2], NULL, 10)));
+    }
 
+    pcap_t *pcap = pcap_open_offline(argv[1], errbuf);
+    if (!pcap) {
+        BSB_EXPORT_sprintf(bsb, "Couldn't open %s: %s\n", argv[1], errbuf);
+        arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+        return;
+    }
+    const int dlt = pcap_datalink(pcap);
+
+    ArkimePacket_t *packets = ARKIME_SIZE_ALLOC0("bench", sizeof(ArkimePacket_t) * max);
+    int            *headerLens = ARKIME_SIZE_ALLOC("bench", sizeof(int) * max);
+    uint32_t        num = 0;
+    uint32_t        skipped = 0;
+
+    while (num < max && pcap_next_ex(pcap, &h, &data) == 1) {
+        int ipOffset;
+        const int headerLen = arkime_dedup_bench_decode(data, h->caplen, dlt, &ipOffset);
+        if (!headerLen) {
+            skipped++;
+            continue;
+        }
+        packets[num].pkt = g_memdup(data, h->caplen);
+        packets[num].pktlen = h->caplen;
+        packets[num].ipOffset = ipOffset;
+        headerLens[num] = headerLen;
+        num++;
+    }
+    pcap_close(pcap);
+
+    BSB_EXPORT_sprintf(bsb, "Dedup of %u packets from %s, %u skipped (ns/packet, dropped)\n", num, argv[1], skipped);
+
+    for (DedupHash hash = 0; hash < DEDUP_HASH_NUM && num > 0; hash++) {
+#ifndef __AES__
+        if (hash == DEDUP_HASH_AES)
+            continue;
+#endif
+        for (int vector = 0; vector < 2; vector++) {
+#ifndef __SSE2__
+            if (vector)
+                continue;
+#endif
+            DedupSeconds_t *secs = arkime_dedup_alloc_seconds();
+            uint32_t        dropped = 0;
+
+            // Fault the tables in so the first variant isn't charged for it
+            for (uint32_t s = 0; s < dedupSeconds; s++) {
+                memset(secs[s].counts, 0, dedupSlots);
+                memset(secs[s].ctrl, 0, dedupSlots * DEDUP_CTRL_STRIDE);
+                memset(secs[s].hashes, 0, dedupSize * 16);
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (uint32_t i = 0; i < num; i++) {
+                dropped += arkime_dedup_check(secs, hash, vector, &packets[i], headerLens[i]);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &stop);
+
+            const double ns = (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+            BSB_EXPORT_sprintf(bsb, "  %-4s %-6s %8.1f %10u\n", dedupHashNames[hash], vector ? "vector" : "scalar", ns / num, dropped);
+            arkime_dedup_free_seconds(secs);
+        }
+    }
+
+    for (uint32_t i = 0; i < num; i++) {
+        g_free(packets[i].pkt);
+    }
+    ARKIME_SIZE_FREE("bench", packets);
+    ARKIME_SIZE_FREE("bench", headerLens);
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+}
+/******************************************************************************/
+void arkime_dedup_init()
+{
     dedupSeconds   = arkime_config_int(NULL, "dedupSeconds", 2, 0, 30) + 1; // + 1 because a slot isn't active before being replaced
     dedupPackets   = arkime_config_int(NULL, "dedupPackets", 0xfffff, 0xffff, 0xffffff);
     dedupSlots     = arkime_get_next_powerof2(dedupPackets / DEDUP_SLOT_FACTOR);
     dedupSlotsMask = dedupSlots - 1;
     dedupSize      = dedupSlots * DEDUP_SIZE_FACTOR;
 
-    if (config.debug)
-        LOG("seconds = %u packets = %u slots = %u size = %u mem=%u", dedupSeconds, dedupPackets, dedupSlots, dedupSize, dedupSeconds * (dedupSlots + dedupSize + dedupSize * 16));
-
-    seconds = ARKIME_SIZE_ALLOC0("dedup seconds", sizeof(DedupSeconds_t) * dedupSeconds);
-    for (uint32_t i = 0; i < dedupSeconds; i++) {
-        ARKIME_LOCK_INIT(seconds[i].lock);
-        seconds[i].counts = ARKIME_SIZE_ALLOC0("dedup counts", dedupSlots);
-        seconds[i].ctrl = ARKIME_SIZE_ALLOC("dedup ctrl", dedupSize);
-        seconds[i].hashes = ARKIME_SIZE_ALLOC("dedup hashes", dedupSize * 16);
+    char *str = arkime_config_str(NULL, "dedupHash", "md5");
+    for (dedupHash = 0; dedupHash < DEDUP_HASH_NUM; dedupHash++) {
+        if (strcmp(str, dedupHashNames[dedupHash]) == 0)
+            break;
+    }
+    if (dedupHash == DEDUP_HASH_NUM) {
+        CONFIGEXIT("dedupHash must be md5, xxh3 or aes, not '%s'", str);
+    }
+#ifdef __AES__
+    for (int i = 0; i <= DEDUP_AES_ROUNDS; i++) {
+        dedupAesKeys[i] = _mm_set_epi32(g_random_int(), g_random_int(), g_random_int(), g_random_int());
+    }
+#else
+    if (dedupHash == DEDUP_HASH_AES) {
+        LOG("WARNING - dedupHash=aes needs a build with AES-NI (-maes), using md5");
+        dedupHash = DEDUP_HASH_MD5;
     }
+#endif
+    g_free(str);
+
+#ifdef __SSE2__
+    dedupVector = TRUE;
+#endif
 
     // When sessionIdTracking uses VLAN or VNI, include that in the dedup hash
     // so packets on different VLANs/VNIs are not treated as duplicates.
@@ -252,6 +564,16 @@ void arkime_dedup_init()
             dedupMode = DEDUP_VNI;
     }
 
+    arkime_command_register("dedup-bench", arkime_dedup_cmd_bench, "Benchmark the dedup hashes and probes on a pcap - dedup-bench <pcap file> [<max packets>]");
+
+    if (!config.enablePacketDedup)
+        return;
+
+    if (config.debug)
+        LOG("seconds = %u packets = %u slots = %u size = %u mem=%u hash = %s", dedupSeconds, dedupPackets, dedupSlots, dedupSize, dedupSeconds * (dedupSlots + dedupSlots * DEDUP_CTRL_STRIDE + dedupSize * 16), dedupHashNames[dedupHash]);
+
+    seconds = arkime_dedup_alloc_seconds();
+
     if (config.debug)
         LOG("Dedup mode: %s", dedupMode == DEDUP_VLAN ? "VLAN" : dedupMode == DEDUP_VNI ? "VNI" : "PLAIN");
 }
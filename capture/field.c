@@ -45,6 +45,83 @@ int16_t fieldOpsRemap[ARKIME_FIELDS_MAX][ARKIME_FIELDS_MAX];
             session->midSave = 1; \
     } while (0)
 
+/******************************************************************************/
+/* With fieldArenaSize set, copies of STR_HASH values are bumped out of per
+ * session chunks of that size, which arkime_field_free releases in one go.
+ * Values that are big or don't fit after ARKIME_FIELD_ARENA_MAX_CHUNKS still
+ * use g_strndup, so always free them with arkime_field_string_free.
+ */
+#define ARKIME_FIELD_ARENA_MAX_CHUNKS 8
+
+typedef struct arkime_field_arena {
+    struct arkime_field_arena *next;
+    uint32_t                   used;
+    uint32_t                   num;            // Chunks in the list including this one
+    char                       data[];
+} ArkimeFieldArena_t;
+
+LOCAL uint32_t fieldArenaSize;
+
+/******************************************************************************/
+LOCAL char *arkime_field_arena_strndup(ArkimeSession_t *session, const char *string, int len)
+{
+    ArkimeFieldArena_t *arena = session->fieldArena;
+
+    if ((uint32_t)len >= fieldArenaSize / 4)
+        return g_strndup(string, len);
+
+    if (!arena || arena->used + len + 1 > fieldArenaSize) {
+        if (arena && arena->num >= ARKIME_FIELD_ARENA_MAX_CHUNKS)
+            return g_strndup(string, len);
+
+        ArkimeFieldArena_t *chunk = ARKIME_SIZE_ALLOC("field arena", sizeof(ArkimeFieldArena_t) + fieldArenaSize);
+        chunk->next = arena;
+        chunk->used = 0;
+        chunk->num = arena ? arena->num + 1 : 1;
+        session->fieldArena = arena = chunk;
+    }
+
+    char *str = arena->data + arena->used;
+    memcpy(str, string, len);
+    str[len] = 0;
+    arena->used += len + 1;
+    return str;
+}
+/******************************************************************************/
+void arkime_field_string_free(ArkimeSession_t *session, char *str)
+{
+    for (const ArkimeFieldArena_t *arena = session->fieldArena; arena; arena = arena->next) {
+        if (str >= arena->data && str < arena->data + fieldArenaSize)
+            return;
+    }
+    g_free(str);
+}
+/******************************************************************************/
+LOCAL void arkime_field_arena_free(ArkimeSession_t *session)
+{
+    ArkimeFieldArena_t *arena = session->fieldArena;
+    while (arena) {
+        ArkimeFieldArena_t *next = arena->next;
+        ARKIME_SIZE_FREE("field arena", arena);
+        arena = next;
+    }
+    session->fieldArena = NULL;
+}
+/******************************************************************************/
+// Like HASH_FIND_HASH but the key is a length, it doesn't need to be terminated
+LOCAL ArkimeString_t *arkime_field_shash_find(const ArkimeStringHashStd_t *hash, uint32_t hhash, const char *string, int len)
+{
+    const int b = hhash % hash->size;
+    const void *end = (void *)&hash->buckets[b];
+
+    for (ArkimeString_t *hstring = hash->buckets[b].s_next; hstring != end; hstring = hstring->s_next) {
+        if (hhash == hstring->s_hash && hstring->len == len && memcmp(hstring->str, string, len) == 0)
+            return hstring;
+        if (hhash > hstring->s_hash)
+            break;
+    }
+    return NULL;
+}
 /******************************************************************************/
 void arkime_field_by_exp_add_special(const char *exp, int pos)
 {
@@ -99,9 +176,32 @@ LOCAL void arkime_field_free_info(ArkimeFieldInfo_t *info)
     g_free(info->transform);
     g_free(info->aliases);
     g_free(info->friendlyName);
+    g_free(info->jsonKey);
+    g_free(info->jsonCntKey);
+    g_free(info->jsonGroup);
     ARKIME_TYPE_FREE(ArkimeFieldInfo_t, info);
 }
 /******************************************************************************/
+/* Build the quoted keys db.c copies when saving a session, done once when the
+ * field gets a pos instead of formatting dbField for every session.
+ */
+LOCAL void arkime_field_json_keys(ArkimeFieldInfo_t *info)
+{
+    if (info->jsonKey)
+        return;
+
+    const char *dbField = info->dbField ? info->dbField : "";
+
+    info->jsonCntKey = g_strdup_printf("\"%sCnt\":", dbField);
+    info->jsonCntKeyLen = strlen(info->jsonCntKey);
+    if (info->dbGroupNum) {
+        info->jsonGroup = g_strdup_printf("\"%.*s\":{", info->dbGroupLen, info->dbGroup);
+        info->jsonGroupLen = strlen(info->jsonGroup);
+    }
+    info->jsonKey = g_strdup_printf("\"%s\":", dbField);
+    info->jsonKeyLen = strlen(info->jsonKey);
+}
+/******************************************************************************/
 void arkime_field_define_json(const uint8_t *expression, int expression_len, const uint8_t *data, int data_len)
 {
     ArkimeFieldInfo_t *info = ARKIME_TYPE_ALLOC0(ArkimeFieldInfo_t);
@@ -482,6 +582,7 @@ int arkime_field_define(const char *group, const char *kind, const char *express
             minfo->dbField += (firstdot - minfo->dbField) + 1;
             minfo->dbFieldLen = strlen(minfo->dbField);
         }
+        arkime_field_json_keys(minfo);
     }
 
     if (flags & ARKIME_FIELD_FLAG_NODB)
@@ -610,6 +711,7 @@ int arkime_field_by_exp(const char *exp)
         if (config.maxDbField >= config.minInternalField) {
             LOGEXIT("ERROR - Max Fields is too large %d", config.maxDbField);
         }
+        arkime_field_json_keys(info);
         config.fields[info->pos] = info;
         return info->pos;
     }
@@ -637,6 +739,7 @@ int arkime_field_by_exp_ignore_error(const char *exp)
         if (config.maxDbField >= config.minInternalField) {
             LOGEXIT("ERROR - Max Fields is too large %d", config.maxDbField);
         }
+        arkime_field_json_keys(info);
         config.fields[info->pos] = info;
         return info->pos;
     }
@@ -657,7 +760,7 @@ const char *arkime_field_string_add(int pos, ArkimeSession_t *session, const cha
     ArkimeStringHashStd_t            *hash;
     ArkimeString_t                   *hstring;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return NULL;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -665,9 +768,10 @@ const char *arkime_field_string_add(int pos, ArkimeSession_t *session, const cha
     if (info->flags & ARKIME_FIELD_FLAG_DISABLED)
         return NULL;
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         if (len < 0)
             len = strlen(string);
 
@@ -677,8 +781,12 @@ const char *arkime_field_string_add(int pos, ArkimeSession_t *session, const cha
         }
 
         field->jsonSize = info->dbFieldLen;
-        if (copy)
-            string = g_strndup(string, len);
+        if (copy) {
+            if (fieldArenaSize && info->type == ARKIME_FIELD_TYPE_STR_HASH)
+                string = arkime_field_arena_strndup(session, string, len);
+            else
+                string = g_strndup(string, len);
+        }
         switch (info->type) {
         case ARKIME_FIELD_TYPE_STR:
             field->str = (char *)string;
@@ -707,16 +815,18 @@ const char *arkime_field_string_add(int pos, ArkimeSession_t *session, const cha
         }
     }
 
+    // Values we don't own are only known to be terminated when we did the strlen
+    gboolean terminated = !copy || len < 0;
     if (len < 0)
         len = strlen(string);
 
     if (len > ARKIME_FIELD_MAX_ELEMENT_SIZE) {
         len = ARKIME_FIELD_MAX_ELEMENT_SIZE;
         arkime_field_truncated(session, info);
+        if (copy)
+            terminated = FALSE;
     }
 
-    field = session->fields[pos];
-
     switch (info->type) {
     case ARKIME_FIELD_TYPE_STR:
         if (copy)
@@ -736,16 +846,16 @@ const char *arkime_field_string_add(int pos, ArkimeSession_t *session, const cha
         g_ptr_array_add(field->sarray, (char *)string);
         goto added;
     case ARKIME_FIELD_TYPE_STR_HASH: {
-        if (copy)
-            string = g_strndup(string, len);
-
+        // Look up the callers string and only copy it when it is new
         uint32_t hhash = arkime_string_hash_len(string, len);
-        HASH_FIND_HASH(s_, *(field->shash), hhash, string, hstring);
-
-        if (hstring) {
-            if (copy)
-                g_free((gpointer)string);
+        if (arkime_field_shash_find(field->shash, hhash, string, len))
             return NULL;
+
+        if (copy) {
+            if (fieldArenaSize)
+                string = arkime_field_arena_strndup(session, string, len);
+            else
+                string = g_strndup(string, len);
         }
         hstring = ARKIME_TYPE_ALLOC(ArkimeString_t);
         hstring->str = (char *)string;
@@ -755,16 +865,33 @@ const char *arkime_field_string_add(int pos, ArkimeSession_t *session, const cha
         HASH_ADD_HASH(s_, *(field->shash), hhash, hstring->str, hstring);
         goto added;
     }
-    case ARKIME_FIELD_TYPE_STR_GHASH:
-        if (copy)
-            string = g_strndup(string, len);
-        if (g_hash_table_lookup(field->ghash, string)) {
-            if (copy)
+    case ARKIME_FIELD_TYPE_STR_GHASH: {
+        // g_str_hash needs a terminated key, short values are terminated on the stack
+        char        buf[256];
+        const char *key = string;
+        gboolean    copied = FALSE;
+        if (!terminated) {
+            if (len < (int)sizeof(buf)) {
+                memcpy(buf, string, len);
+                buf[len] = 0;
+                key = buf;
+            } else {
+                key = string = g_strndup(string, len);
+                copied = TRUE;
+                copy = FALSE;
+            }
+        }
+
+        if (g_hash_table_contains(field->ghash, key)) {
+            if (copied)
                 g_free((gpointer)string);
             return NULL;
         }
+        if (copy)
+            string = g_strndup(string, len);
         g_hash_table_add(field->ghash, (gpointer)string);
         goto added;
+    }
     default:
         LOGEXIT("ERROR - Not a string, expression: %s field: %s, tried to set '%.*s'", info->expression, info->dbFieldFull, len, string);
     }
@@ -779,7 +906,7 @@ added:
 /******************************************************************************/
 gboolean arkime_field_string_add_upper(int pos, ArkimeSession_t *session, const char *string, int len)
 {
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     if (len < 0)
@@ -800,7 +927,7 @@ gboolean arkime_field_string_add_upper(int pos, ArkimeSession_t *session, const
 /******************************************************************************/
 gboolean arkime_field_string_add_lower(int pos, ArkimeSession_t *session, const char *string, int len)
 {
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     if (len < 0)
@@ -823,7 +950,7 @@ gboolean arkime_field_string_add_host(int pos, ArkimeSession_t *session, char *s
 {
     char *host;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     if (len < 0) {
@@ -867,7 +994,7 @@ const char *arkime_field_string_uw_add(int pos, ArkimeSession_t *session, const
     ArkimeStringHashStd_t            *hash;
     ArkimeString_t                   *hstring;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return NULL;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -875,9 +1002,10 @@ const char *arkime_field_string_uw_add(int pos, ArkimeSession_t *session, const
     if (info->flags & ARKIME_FIELD_FLAG_DISABLED)
         return NULL;
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         if (len < 0)
             len = strlen(string);
         if (len > ARKIME_FIELD_MAX_ELEMENT_SIZE) {
@@ -885,8 +1013,12 @@ const char *arkime_field_string_uw_add(int pos, ArkimeSession_t *session, const
             arkime_field_truncated(session, info);
         }
         field->jsonSize = 6 + info->dbFieldLen + 2 * len;
-        if (copy)
-            string = g_strndup(string, len);
+        if (copy) {
+            if (fieldArenaSize)
+                string = arkime_field_arena_strndup(session, string, len);
+            else
+                string = g_strndup(string, len);
+        }
         switch (info->type) {
         case ARKIME_FIELD_TYPE_STR_HASH:
             hash = ARKIME_TYPE_ALLOC(ArkimeStringHashStd_t);
@@ -914,20 +1046,19 @@ const char *arkime_field_string_uw_add(int pos, ArkimeSession_t *session, const
         arkime_field_truncated(session, info);
     }
 
-    field = session->fields[pos];
-
     switch (info->type) {
     case ARKIME_FIELD_TYPE_STR_HASH: {
         uint32_t hhash = arkime_string_hash_len(string, len);
-        HASH_FIND_HASH(s_, *(field->shash), hhash, string, hstring);
-
-        if (hstring) {
+        if (arkime_field_shash_find(field->shash, hhash, string, len))
             return NULL;
-        }
 
         hstring = ARKIME_TYPE_ALLOC(ArkimeString_t);
-        if (copy)
-            string = g_strndup(string, len);
+        if (copy) {
+            if (fieldArenaSize)
+                string = arkime_field_arena_strndup(session, string, len);
+            else
+                string = g_strndup(string, len);
+        }
         hstring->str = (char *)string;
         hstring->len = len;
         hstring->utf8 = 0;
@@ -950,7 +1081,7 @@ gboolean arkime_field_int_add(int pos, ArkimeSession_t *session, int i)
     ArkimeIntHashStd_t               *hash;
     ArkimeInt_t                      *hint;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -958,9 +1089,10 @@ gboolean arkime_field_int_add(int pos, ArkimeSession_t *session, int i)
     if (info->flags & ARKIME_FIELD_FLAG_DISABLED)
         return FALSE;
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         field->jsonSize = info->dbFieldLen;
         switch (info->type) {
         case ARKIME_FIELD_TYPE_INT:
@@ -987,7 +1119,6 @@ gboolean arkime_field_int_add(int pos, ArkimeSession_t *session, int i)
         }
     }
 
-    field = session->fields[pos];
     switch (info->type) {
     case ARKIME_FIELD_TYPE_INT:
         field->i = i;
@@ -1032,7 +1163,7 @@ gboolean arkime_field_float_add(int pos, ArkimeSession_t *session, float f)
     ArkimeField_t                    *field;
     uint32_t                          fint;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -1040,9 +1171,10 @@ gboolean arkime_field_float_add(int pos, ArkimeSession_t *session, float f)
     if (info->flags & ARKIME_FIELD_FLAG_DISABLED)
         return FALSE;
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         field->jsonSize = info->dbFieldLen;
         switch (info->type) {
         case ARKIME_FIELD_TYPE_FLOAT:
@@ -1062,7 +1194,6 @@ gboolean arkime_field_float_add(int pos, ArkimeSession_t *session, float f)
         }
     }
 
-    field = session->fields[pos];
     switch (info->type) {
     case ARKIME_FIELD_TYPE_FLOAT:
         field->f = f;
@@ -1139,7 +1270,7 @@ gboolean arkime_field_ip_add_str(int pos, ArkimeSession_t *session, const char *
 {
     ArkimeField_t                    *field;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -1154,9 +1285,10 @@ gboolean arkime_field_ip_add_str(int pos, ArkimeSession_t *session, const char *
         return FALSE;
     }
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         field->jsonSize = info->dbFieldLen;
         switch (info->type) {
         case ARKIME_FIELD_TYPE_IP:
@@ -1171,7 +1303,6 @@ gboolean arkime_field_ip_add_str(int pos, ArkimeSession_t *session, const char *
         }
     }
 
-    field = session->fields[pos];
     switch (info->type) {
     case ARKIME_FIELD_TYPE_IP:
         g_free(field->ip);
@@ -1200,7 +1331,7 @@ gboolean arkime_field_ip4_add(int pos, ArkimeSession_t *session, uint32_t i)
     ArkimeField_t                    *field;
     char                              ipbuf[INET6_ADDRSTRLEN];
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -1214,9 +1345,10 @@ gboolean arkime_field_ip4_add(int pos, ArkimeSession_t *session, uint32_t i)
     ((uint32_t *)v->s6_addr)[2] = htonl(0xffff);
     ((uint32_t *)v->s6_addr)[3] = i;
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         field->jsonSize = info->dbFieldLen;
         switch (info->type) {
         case ARKIME_FIELD_TYPE_IP:
@@ -1232,7 +1364,6 @@ gboolean arkime_field_ip4_add(int pos, ArkimeSession_t *session, uint32_t i)
         }
     }
 
-    field = session->fields[pos];
     switch (info->type) {
     case ARKIME_FIELD_TYPE_IP:
         g_free(field->ip);
@@ -1262,7 +1393,7 @@ gboolean arkime_field_ip6_add(int pos, ArkimeSession_t *session, const uint8_t *
     ArkimeField_t                    *field;
     char                              ipbuf[INET6_ADDRSTRLEN];
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     const ArkimeFieldInfo_t          *info = config.fields[pos];
@@ -1272,9 +1403,10 @@ gboolean arkime_field_ip6_add(int pos, ArkimeSession_t *session, const uint8_t *
 
     struct in6_addr *v = g_memdup(val, sizeof(struct in6_addr));
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         field->jsonSize = info->dbFieldLen;
         switch (info->type) {
         case ARKIME_FIELD_TYPE_IP:
@@ -1290,7 +1422,6 @@ gboolean arkime_field_ip6_add(int pos, ArkimeSession_t *session, const uint8_t *
         }
     }
 
-    field = session->fields[pos];
     switch (info->type) {
     case ARKIME_FIELD_TYPE_IP:
         g_free(field->ip);
@@ -1341,11 +1472,9 @@ void arkime_field_free(ArkimeSession_t *session)
     ArkimeFieldObjectHashStd_t *ohash;
     ArkimeFieldObjectFreeFunc   freeCB;
 
-    for (int pos = 0; pos < session->maxFields; pos++) {
-        ArkimeField_t        *field;
-
-        if (!(field = session->fields[pos]))
-            continue;
+    for (int i = 0; i < session->fieldsCnt; i++) {
+        ArkimeField_t        *field = session->fieldsSparse[i];
+        int                   pos = session->fieldsPos[i];
 
         switch (config.fields[pos]->type) {
         case ARKIME_FIELD_TYPE_STR:
@@ -1355,9 +1484,9 @@ void arkime_field_free(ArkimeSession_t *session)
             g_ptr_array_free(field->sarray, TRUE);
             break;
         case ARKIME_FIELD_TYPE_STR_HASH:
-            shash = session->fields[pos]->shash;
+            shash = field->shash;
             HASH_FORALL_POP_HEAD2(s_, *shash, hstring) {
-                g_free(hstring->str);
+                arkime_field_string_free(session, hstring->str);
                 ARKIME_TYPE_FREE(ArkimeString_t, hstring);
             }
             ARKIME_TYPE_FREE(ArkimeStringHashStd_t, shash);
@@ -1369,7 +1498,7 @@ void arkime_field_free(ArkimeSession_t *session)
             g_array_free(field->iarray, TRUE);
             break;
         case ARKIME_FIELD_TYPE_INT_HASH:
-            ihash = session->fields[pos]->ihash;
+            ihash = field->ihash;
             HASH_FORALL_POP_HEAD2(i_, *ihash, hint) {
                 ARKIME_TYPE_FREE(ArkimeInt_t, hint);
             }
@@ -1381,17 +1510,17 @@ void arkime_field_free(ArkimeSession_t *session)
             g_array_free(field->farray, TRUE);
             break;
         case ARKIME_FIELD_TYPE_IP:
-            g_free(session->fields[pos]->ip);
+            g_free(field->ip);
             break;
         case ARKIME_FIELD_TYPE_IP_GHASH:
         case ARKIME_FIELD_TYPE_INT_GHASH:
         case ARKIME_FIELD_TYPE_STR_GHASH:
         case ARKIME_FIELD_TYPE_FLOAT_GHASH:
-            g_hash_table_destroy(session->fields[pos]->ghash);
+            g_hash_table_destroy(field->ghash);
             break;
         case ARKIME_FIELD_TYPE_OBJECT: {
             freeCB = config.fields[pos]->object_free;
-            ohash = session->fields[pos]->ohash;
+            ohash = field->ohash;
             HASH_FORALL_POP_HEAD2(o_, *ohash, ho) {
                 freeCB(ho);
             }
@@ -1399,10 +1528,14 @@ void arkime_field_free(ArkimeSession_t *session)
         }
         break;
         } // switch
-        ARKIME_TYPE_FREE(ArkimeField_t, session->fields[pos]);
+        ARKIME_TYPE_FREE(ArkimeField_t, field);
     }
-    ARKIME_SIZE_FREE("fields", session->fields);
-    session->fields = 0;
+    ARKIME_SIZE_FREE("fields", session->fieldsSparse);
+    ARKIME_SIZE_FREE("fieldsPos", session->fieldsPos);
+    arkime_field_arena_free(session);
+    session->fieldsSparse = 0;
+    session->fieldsPos = 0;
+    session->fieldsCnt = session->fieldsSize = 0;
 }
 /******************************************************************************/
 void arkime_field_free_one(ArkimeSession_t *session, int pos)
@@ -1416,9 +1549,9 @@ void arkime_field_free_one(ArkimeSession_t *session, int pos)
     ArkimeFieldObjectFreeFunc   freeCB;
     ArkimeField_t              *field;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return;
-    if (!(field = session->fields[pos]))
+    if (!(field = arkime_field_get(session, pos)))
         return;
 
     switch (config.fields[pos]->type) {
@@ -1431,7 +1564,7 @@ void arkime_field_free_one(ArkimeSession_t *session, int pos)
     case ARKIME_FIELD_TYPE_STR_HASH:
         shash = field->shash;
         HASH_FORALL_POP_HEAD2(s_, *shash, hstring) {
-            g_free(hstring->str);
+            arkime_field_string_free(session, hstring->str);
             ARKIME_TYPE_FREE(ArkimeString_t, hstring);
         }
         ARKIME_TYPE_FREE(ArkimeStringHashStd_t, shash);
@@ -1473,7 +1606,48 @@ void arkime_field_free_one(ArkimeSession_t *session, int pos)
         break;
     }
     ARKIME_TYPE_FREE(ArkimeField_t, field);
-    session->fields[pos] = NULL;
+    arkime_field_set(session, pos, NULL);
+}
+/******************************************************************************/
+/* Set, replace or with a NULL field remove pos from the session's sorted field
+ * list.  The caller owns the old ArkimeField_t.
+ */
+void arkime_field_set(ArkimeSession_t *session, int pos, ArkimeField_t *field)
+{
+    int lo = 0, hi = session->fieldsCnt;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (session->fieldsPos[mid] < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < session->fieldsCnt && session->fieldsPos[lo] == pos) {
+        if (field) {
+            session->fieldsSparse[lo] = field;
+            return;
+        }
+        session->fieldsCnt--;
+        memmove(session->fieldsSparse + lo, session->fieldsSparse + lo + 1, (session->fieldsCnt - lo) * sizeof(session->fieldsSparse[0]));
+        memmove(session->fieldsPos + lo, session->fieldsPos + lo + 1, (session->fieldsCnt - lo) * sizeof(session->fieldsPos[0]));
+        return;
+    }
+
+    if (!field)
+        return;
+
+    if (session->fieldsCnt == session->fieldsSize) {
+        session->fieldsSize = session->fieldsSize ? MIN(session->fieldsSize * 2, config.maxDbField) : 8;
+        ARKIME_SIZE_REALLOC("fields", session->fieldsSparse, session->fieldsSize * sizeof(session->fieldsSparse[0]));
+        ARKIME_SIZE_REALLOC("fieldsPos", session->fieldsPos, session->fieldsSize * sizeof(session->fieldsPos[0]));
+    }
+
+    memmove(session->fieldsSparse + lo + 1, session->fieldsSparse + lo, (session->fieldsCnt - lo) * sizeof(session->fieldsSparse[0]));
+    memmove(session->fieldsPos + lo + 1, session->fieldsPos + lo, (session->fieldsCnt - lo) * sizeof(session->fieldsPos[0]));
+    session->fieldsSparse[lo] = field;
+    session->fieldsPos[lo] = pos;
+    session->fieldsCnt++;
 }
 /******************************************************************************/
 int arkime_field_object_register(const char *name, const char *help, ArkimeFieldObjectSaveFunc save, ArkimeFieldObjectFreeFunc free, ArkimeFieldObjectHashFunc hash, ArkimeFieldObjectCmpFunc cmp)
@@ -1513,7 +1687,7 @@ gboolean arkime_field_object_add(int pos, ArkimeSession_t *session, ArkimeFieldO
     ArkimeFieldObjectHashStd_t  *hash;
     ArkimeFieldObject_t         *ho;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return FALSE;
 
     const ArkimeFieldInfo_t     *info = config.fields[pos];
@@ -1521,9 +1695,10 @@ gboolean arkime_field_object_add(int pos, ArkimeSession_t *session, ArkimeFieldO
     if (info->flags & ARKIME_FIELD_FLAG_DISABLED)
         return FALSE;
 
-    if (!session->fields[pos]) {
+    field = arkime_field_get(session, pos);
+    if (!field) {
         field = ARKIME_TYPE_ALLOC(ArkimeField_t);
-        session->fields[pos] = field;
+        arkime_field_set(session, pos, field);
         // 3 for the quotes and colon
         // length of the object name
         // 4 for the brackets and braces
@@ -1541,7 +1716,6 @@ gboolean arkime_field_object_add(int pos, ArkimeSession_t *session, ArkimeFieldO
         }
     }
 
-    field = session->fields[pos];
     switch (info->type) {
     case ARKIME_FIELD_TYPE_OBJECT:
         HASH_FIND(o_, *(field->ohash), object->object, ho);
@@ -1564,14 +1738,13 @@ int arkime_field_count(int pos, ArkimeSession_t *session)
 {
     ArkimeField_t         *field;
 
-    if (pos < 0 || pos >= session->maxFields)
+    if (pos < 0 || pos >= config.maxDbField)
         return 0;
 
-    if (!session->fields[pos])
+    field = arkime_field_get(session, pos);
+    if (!field)
         return 0;
 
-    field = session->fields[pos];
-
     switch (config.fields[pos]->type) {
     case ARKIME_FIELD_TYPE_INT:
     case ARKIME_FIELD_TYPE_STR:
@@ -1678,7 +1851,7 @@ void arkime_field_ops_run_match(ArkimeSession_t *session, ArkimeFieldOps_t *ops,
         switch (config.fields[fieldPos]->type) {
         case ARKIME_FIELD_TYPE_INT:
             if (arkime_field_count(fieldPos, session) == 0 ||
-                arkime_field_ops_should_run_int_op(op, session->fields[fieldPos]->i)) {
+                arkime_field_ops_should_run_int_op(op, arkime_field_get(session, fieldPos)->i)) {
 
                 arkime_field_int_add(fieldPos, session, op->strLenOrInt);
             }
@@ -2124,6 +2297,7 @@ void arkime_field_init()
     config.minInternalField = ARKIME_FIELDS_MAX;
     HASH_INIT(d_, fieldsByDb, arkime_string_hash, arkime_string_cmp);
     HASH_INIT(e_, fieldsByExp, arkime_string_hash, (HASH_CMP_FUNC)arkime_field_exp_cmp);
+    fieldArenaSize = arkime_config_int(NULL, "fieldArenaSize", 0, 0, 0x100000);
     groupName2Num = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 
     arkime_field_by_exp_add_special("dontSaveSPI", ARKIME_FIELD_SPECIAL_STOP_SPI);
@@ -39,7 +39,7 @@ char                   arkime_ip_byte_lookup[256][4];
 uint32_t               hashSalt;
 LOCAL pthread_t        mainThread;
 
-ArkimeThreadData_t     arkimeThreadData[ARKIME_MAX_PACKET_THREADS];
+ArkimeThreadData_t    *arkimeThreadData;
 
 extern ArkimeWriterQueueLength arkime_writer_queue_length;
 extern ArkimePcapFileHdr_t     pcapFileHeader;
@@ -562,6 +562,39 @@ uint32_t arkime_get_next_powerof2(uint32_t v)
     return v;
 }
 /******************************************************************************/
+void arkime_varint_append(ArkimeVarintArray_t *va, int64_t value)
+{
+    // A 64 bit varint is at most 10 bytes
+    if (va->size - va->len < 10) {
+        va->size = va->size ? va->size * 2 : 32;
+        ARKIME_SIZE_REALLOC("varint", va->buf, va->size);
+    }
+
+    uint64_t delta = (uint64_t)value - (uint64_t)va->last;
+    uint64_t zz = (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+    while (zz >= 0x80) {
+        va->buf[va->len++] = 0x80 | (zz & 0x7f);
+        zz >>= 7;
+    }
+    va->buf[va->len++] = zz;
+
+    va->last = value;
+    va->cnt++;
+}
+/******************************************************************************/
+void arkime_varint_clear(ArkimeVarintArray_t *va)
+{
+    va->len = 0;
+    va->cnt = 0;
+    va->last = 0;
+}
+/******************************************************************************/
+void arkime_varint_free(ArkimeVarintArray_t *va)
+{
+    ARKIME_SIZE_FREE("varint", va->buf);
+    memset(va, 0, sizeof(*va));
+}
+/******************************************************************************/
 const uint8_t *arkime_js0n_get(const uint8_t *data, uint32_t len, const char *key, uint32_t *olen)
 {
     uint32_t key_len = strlen(key);
@@ -1155,6 +1188,8 @@ LLVMFuzzerInitialize(int *UNUSED(argc), char ***UNUSED(argv))
     arkime_hex_init();
     arkime_http_init();
     arkime_config_init();
+    arkime_numa_init();
+    arkimeThreadData = arkime_numa_alloc0("threadData", sizeof(ArkimeThreadData_t), config.packetThreads);
     arkime_cloud_init();
     arkime_writers_init();
     arkime_writers_start("null");
@@ -1165,6 +1200,7 @@ LLVMFuzzerInitialize(int *UNUSED(argc), char ***UNUSED(argv))
     arkime_db_init();
     arkime_python_init();
     arkime_mprotocol_init();
+    arkime_pool_init();
     arkime_packet_init();
     arkime_config_load_packet_ips();
     arkime_yara_init();
@@ -1216,6 +1252,8 @@ LLVMFuzzerInitialize(int *UNUSED(argc), char ***UNUSED(argv))
     arkime_hex_init();
     arkime_http_init();
     arkime_config_init();
+    arkime_numa_init();
+    arkimeThreadData = arkime_numa_alloc0("threadData", sizeof(ArkimeThreadData_t), config.packetThreads);
     arkime_cloud_init();
     arkime_writers_init();
     arkime_writers_start("null");
@@ -1226,6 +1264,7 @@ LLVMFuzzerInitialize(int *UNUSED(argc), char ***UNUSED(argv))
     arkime_db_init();
     arkime_python_init();
     arkime_mprotocol_init();
+    arkime_pool_init();
     arkime_packet_init();
     arkime_config_load_packet_ips();
     arkime_yara_init();
@@ -1310,6 +1349,8 @@ int main(int argc, char **argv)
     arkime_http_init();
     arkime_command_init();
     arkime_config_init();
+    arkime_numa_init();
+    arkimeThreadData = arkime_numa_alloc0("threadData", sizeof(ArkimeThreadData_t), config.packetThreads);
     arkime_command_register("version", arkime_cmd_version, "Arkime Version");
     arkime_command_register("shutdown", arkime_cmd_shutdown, "Shutdown Arkime");
     arkime_cloud_init();
@@ -1336,6 +1377,7 @@ int main(int argc, char **argv)
     arkime_db_init();
     arkime_python_init();
     arkime_mprotocol_init();
+    arkime_pool_init();
     arkime_packet_init();
     arkime_config_load_packet_ips();
     arkime_yara_init();
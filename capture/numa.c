@@ -0,0 +1,229 @@
+/******************************************************************************/
+/* numa.c  -- NUMA placement of per thread state and thread pinning
+ *
+ * Copyright 2026 AOL Inc. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* numaNode is a ; separated list of nodes, or auto for the nodes of the
+ * capture interfaces.  The packet threads are split into contiguous blocks,
+ * one block per node, and each packet thread is pinned to the cpus of its
+ * node.  Per packet thread arrays are bound page by page to the node of the
+ * thread that owns the page, so each thread's state sits on its own socket.
+ * Reader threads are pinned to the cpus of all the listed nodes.  Only the
+ * sysfs files and the mbind/sched_setaffinity calls are used, libnuma isn't
+ * needed.
+ */
+
+#include "arkime.h"
+#ifdef __linux__
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+extern ArkimeConfig_t        config;
+
+#define ARKIME_NUMA_MAX_NODES    1024
+#define ARKIME_NUMA_MAX_USED     64
+// From linux/mempolicy.h
+#define ARKIME_MPOL_PREFERRED    1
+
+LOCAL int                    numaNodesCnt;
+LOCAL int                    numaNodes[ARKIME_NUMA_MAX_USED];
+#ifdef __linux__
+LOCAL cpu_set_t              numaNodeCpus[ARKIME_NUMA_MAX_USED];
+LOCAL cpu_set_t              numaAllCpus;
+#endif
+
+/******************************************************************************/
+// Index into numaNodes of the node a packet thread runs on
+LOCAL int arkime_numa_thread_pos(int thread)
+{
+    if (thread >= config.packetThreads)
+        thread = config.packetThreads - 1;
+    return ((int64_t)thread * numaNodesCnt) / config.packetThreads;
+}
+/******************************************************************************/
+/* Allocate cnt zeroed elements of size bytes, one per packet thread, any
+ * elements past packetThreads belong to the last thread.  Cache line aligned
+ * and never freed.  With nodes set the memory is mmapped and each run of pages
+ * is bound to the node of the thread owning the page before anything touches it.
+ */
+void *arkime_numa_alloc0(const char *name, size_t size, int cnt)
+{
+#ifdef __linux__
+    if (numaNodesCnt > 0) {
+        size_t total = size * cnt;
+        void *mem = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            LOGEXIT("ERROR - Couldn't allocate %zu bytes for %s: %s", total, name, strerror(errno));
+        }
+
+        const size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t start = 0;
+        while (start < total) {
+            int pos = arkime_numa_thread_pos(start / size);
+            size_t end = start + pageSize;
+            while (end < total && arkime_numa_thread_pos(end / size) == pos)
+                end += pageSize;
+            if (end > total)
+                end = total;
+
+            unsigned long mask[ARKIME_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+            memset(mask, 0, sizeof(mask));
+            mask[numaNodes[pos] / (8 * sizeof(unsigned long))] = 1UL << (numaNodes[pos] % (8 * sizeof(unsigned long)));
+            if (syscall(SYS_mbind, (char *)mem + start, end - start, ARKIME_MPOL_PREFERRED, mask, ARKIME_NUMA_MAX_NODES, 0) != 0 && config.debug) {
+                LOG("Couldn't bind %s to NUMA node %d: %s", name, numaNodes[pos], strerror(errno));
+            }
+            start = end;
+        }
+        return mem;
+    }
+#endif
+    (void)name;
+    return arkime_alloc0_aligned(size * cnt);
+}
+#ifdef __linux__
+/******************************************************************************/
+LOCAL int arkime_numa_read_file(const char *path, char *buf, int len)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return 0;
+
+    int rc = fgets(buf, len, fp) != NULL;
+    fclose(fp);
+    return rc;
+}
+/******************************************************************************/
+// Parse a sysfs cpulist like 0-31,64-95
+LOCAL int arkime_numa_parse_cpulist(const char *str, cpu_set_t *cpus)
+{
+    int cnt = 0;
+
+    CPU_ZERO(cpus);
+    while (*str && *str != '\n') {
+        char *end;
+        long first = strtol(str, &end, 10);
+        long last = first;
+        if (end == str)
+            return 0;
+        if (*end == '-') {
+            str = end + 1;
+            last = strtol(str, &end, 10);
+            if (end == str)
+                return 0;
+        }
+        for (long c = first; c <= last && c < CPU_SETSIZE; c++) {
+            CPU_SET(c, cpus);
+            cnt++;
+        }
+        str = end;
+        if (*str == ',')
+            str++;
+    }
+    return cnt;
+}
+/******************************************************************************/
+LOCAL uint32_t arkime_numa_reader_pin(int UNUSED(thread), void UNUSED(*uw), void UNUSED(*cbuw))
+{
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(numaAllCpus), &numaAllCpus);
+    if (rc != 0) {
+        LOG("WARNING - Couldn't pin reader thread to NUMA nodes: %s", strerror(rc));
+    }
+    return 0;
+}
+/******************************************************************************/
+LOCAL uint32_t arkime_numa_packet_pin(int thread, void UNUSED(*uw), void UNUSED(*cbuw))
+{
+    int pos = arkime_numa_thread_pos(thread);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(numaNodeCpus[pos]), &numaNodeCpus[pos]);
+    if (rc != 0) {
+        LOG("WARNING - Couldn't pin packet thread %d to NUMA node %d: %s", thread, numaNodes[pos], strerror(rc));
+    }
+    return 0;
+}
+/******************************************************************************/
+LOCAL void arkime_numa_add_node(int node)
+{
+    for (int i = 0; i < numaNodesCnt; i++) {
+        if (numaNodes[i] == node)
+            return;
+    }
+    if (numaNodesCnt == ARKIME_NUMA_MAX_USED) {
+        CONFIGEXIT("numaNode can list at most %d nodes", ARKIME_NUMA_MAX_USED);
+    }
+    numaNodes[numaNodesCnt++] = node;
+}
+#endif
+/******************************************************************************/
+void arkime_numa_init()
+{
+    char **strs = arkime_config_str_list(NULL, "numaNode", NULL);
+    if (!strs)
+        return;
+
+#ifdef __linux__
+    char path[300];
+    char buf[4096];
+
+    for (int i = 0; strs[i]; i++) {
+        if (strcmp(strs[i], "auto") == 0) {
+            if (!config.interface || !config.interface[0]) {
+                CONFIGEXIT("numaNode=auto requires an interface");
+            }
+            for (int j = 0; config.interface[j]; j++) {
+                snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", config.interface[j]);
+                if (!arkime_numa_read_file(path, buf, sizeof(buf)) || atoi(buf) < 0) {
+                    LOG("WARNING - Couldn't find the NUMA node for %s", config.interface[j]);
+                    continue;
+                }
+                arkime_numa_add_node(atoi(buf));
+            }
+        } else {
+            char *end;
+            long node = strtol(strs[i], &end, 10);
+            if (*end || end == strs[i] || node < 0 || node >= ARKIME_NUMA_MAX_NODES) {
+                CONFIGEXIT("numaNode must be auto or node numbers, not '%s'", strs[i]);
+            }
+            arkime_numa_add_node(node);
+        }
+    }
+    g_strfreev(strs);
+
+    if (numaNodesCnt == 0) {
+        LOG("WARNING - No NUMA nodes found, not pinning threads");
+        return;
+    }
+
+    if (numaNodesCnt > config.packetThreads) {
+        LOG("WARNING - Only using the first %d of %d NUMA nodes, increase packetThreads to use more", config.packetThreads, numaNodesCnt);
+        numaNodesCnt = config.packetThreads;
+    }
+
+    CPU_ZERO(&numaAllCpus);
+    for (int i = 0; i < numaNodesCnt; i++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numaNodes[i]);
+        if (!arkime_numa_read_file(path, buf, sizeof(buf)) || !arkime_numa_parse_cpulist(buf, &numaNodeCpus[i])) {
+            CONFIGEXIT("Couldn't read the cpus for NUMA node %d from %s", numaNodes[i], path);
+        }
+        CPU_OR(&numaAllCpus, &numaAllCpus, &numaNodeCpus[i]);
+
+        if (config.debug) {
+            g_strchomp(buf);
+            LOG("Using NUMA node %d cpus %s for packet threads %d-%d", numaNodes[i], buf,
+                (int)(((int64_t)i * config.packetThreads + numaNodesCnt - 1) / numaNodesCnt),
+                (int)(((int64_t)(i + 1) * config.packetThreads + numaNodesCnt - 1) / numaNodesCnt) - 1);
+        }
+    }
+
+    arkime_add_named_func("arkime_reader_thread_init", arkime_numa_reader_pin, NULL);
+    arkime_add_named_func("arkime_packet_thread_init", arkime_numa_packet_pin, NULL);
+#else
+    g_strfreev(strs);
+    LOG("WARNING - numaNode is only supported on Linux");
+#endif
+}
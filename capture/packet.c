@@ -50,6 +50,7 @@ LOCAL int                    ttlField[2];
 
 LOCAL uint64_t               droppedFrags;
 LOCAL gboolean               disableIp4Defrag;
+LOCAL gboolean               disableIp6Defrag;
 LOCAL gboolean               trimEthernetPadding;
 
 LOCAL patricia_tree_t       *ipTree4 = 0;
@@ -83,6 +84,28 @@ ARKIME_LOCK_DEFINE(offlineInfoLock);
 
 /******************************************************************************/
 
+/* When packetRingSize is set each thread that flushes batches gets its own
+ * single producer/single consumer ring per packet thread, so the reader and
+ * packet threads don't fight over the packetQ lock.  Producers past
+ * ARKIME_PACKET_RING_PRODUCERS and the end of file markers still use packetQ.
+ */
+#define ARKIME_PACKET_RING_PRODUCERS 64
+#define ARKIME_PACKET_RING_DRAIN     64
+
+/* When packetBatchSize is more than 1 packet threads take that many packets at
+ * a time and prefetch the session hash buckets and sessions for all of them
+ * before processing any, so the cache misses overlap instead of happening one
+ * packet at a time.
+ */
+#define ARKIME_PACKET_BATCH_MAX      256
+
+typedef struct {
+    ArkimePacket_t      **packets;
+    uint32_t              mask;
+    uint32_t              head ARKIME_CACHE_ALIGN;  // Only written by the packet thread
+    uint32_t              tail ARKIME_CACHE_ALIGN;  // Only written by the producer
+} ARKIME_CACHE_ALIGN ArkimePacketRing_t;
+
 typedef struct {
     ArkimePacketHead_t    packetQ;
     uint64_t              overloadDrops;
@@ -90,23 +113,44 @@ typedef struct {
     uint64_t              writtenBytes;
     uint64_t              unwrittenBytes;
     int                   inProgress;
+    int                   ringCount;
+    int                   sleeping;
+    uint64_t              batches;
+    uint64_t              batchPackets;
+    uint64_t              batchNs;
+    ArkimePacketRing_t   *rings[ARKIME_PACKET_RING_PRODUCERS];
 } ARKIME_CACHE_ALIGN PacketThreadData_t;
-LOCAL PacketThreadData_t packetThreadData[ARKIME_MAX_PACKET_THREADS];
+LOCAL PacketThreadData_t *packetThreadData;
+
+LOCAL ArkimePool_t          *packetPool;
 
-LOCAL  ARKIME_LOCK_DEFINE(frags);
+LOCAL uint32_t               packetRingSize;
+LOCAL int                    packetBatchSize;
+LOCAL int                    packetRingProducers;
+LOCAL __thread int           packetRingProducer = -1;
 
 LOCAL ArkimePacketRC arkime_packet_ip4(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, const uint8_t *data, int len);
 LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, const uint8_t *data, int len);
 LOCAL ArkimePacketRC arkime_packet_frame_relay(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, const uint8_t *data, int len);
 LOCAL ArkimePacketRC arkime_packet_ether(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, const uint8_t *data, int len);
 
+/* Fragments are split across shards by a hash of (src, dst, id).  Each shard
+ * has its own lock, hash and age list so reader threads only contend when
+ * they hit the same shard, and expiry only walks the shard being used.  The
+ * hash starts small and grows as the shard fills.  IPv4 keys only use the
+ * first 10 bytes, the rest stay zero.
+ */
+#define ARKIME_FRAGS_SHARDS      16
+#define ARKIME_FRAGS_KEY_LEN     36
+#define ARKIME_FRAGS_HASH_SIZE   61
+
 typedef struct arkimefrags_t {
     ArkimePacketHead_t     packets;
     struct arkimefrags_t  *fragh_next, *fragh_prev;
     struct arkimefrags_t  *fragl_next, *fragl_prev;
     uint32_t               fragh_bucket;
     uint32_t               fragh_hash;
-    char                   key[10];
+    uint8_t                key[ARKIME_FRAGS_KEY_LEN];
     uint32_t               secs;
     char                   haveNoFlags;
 } ArkimeFrags_t;
@@ -119,10 +163,21 @@ typedef struct {
     uint32_t               fragl_count;
 } ArkimeFragsHead_t;
 
-typedef HASH_VAR(h_, ArkimeFragsHash_t, ArkimeFragsHead_t, 10007);
+typedef HASHP_VAR(fragh_, ArkimeFragsHash_t, ArkimeFragsHead_t);
 
-LOCAL ArkimeFragsHash_t          fragsHash;
-LOCAL ArkimeFragsHead_t          fragsList;
+typedef struct {
+    ArkimeFragsHash_t      hash;
+    ArkimeFragsHead_t      list;
+    ARKIME_LOCK_EXTERN(lock);
+} ARKIME_CACHE_ALIGN ArkimeFragsShard_t;
+
+typedef struct {
+    ArkimeFragsShard_t     shards[ARKIME_FRAGS_SHARDS];
+    uint32_t               count;
+} ArkimeFragsTable_t;
+
+LOCAL ArkimeFragsTable_t         frags4;
+LOCAL ArkimeFragsTable_t         frags6;
 
 // These are in network byte order
 LOCAL ArkimeDropHashGroup_t      packetDrop4;
@@ -143,22 +198,51 @@ LOCAL int arkime_packet_thread_exit_func;
 /******************************************************************************/
 ArkimePacket_t *arkime_packet_alloc()
 {
-    return ARKIME_TYPE_ALLOC0(ArkimePacket_t);
+    return arkime_pool_alloc0(packetPool);
 }
 
 /******************************************************************************/
 LOCAL void arkime_packet_freelist_init()
 {
+    packetPool = arkime_pool_create("packet", sizeof(ArkimePacket_t));
 }
 
+/******************************************************************************/
+void arkime_packet_block_unref(ArkimePacketBlock_t *block)
+{
+    if (ARKIME_THREAD_DECR(block->refs) == 0) {
+        block->release(block);
+    }
+}
 /******************************************************************************/
 void arkime_packet_free(ArkimePacket_t *packet)
 {
     if (packet->copied) {
         free(packet->pkt);
+    } else if (packet->block) {
+        arkime_packet_block_unref(packet->block);
     }
 
-    ARKIME_TYPE_FREE(ArkimePacket_t, packet);
+    arkime_pool_free(packetPool, packet);
+}
+/******************************************************************************/
+/* Make the packet own its data, used when a packet is held past when the
+ * reader's buffer can be reused, like waiting for reassembly.
+ */
+void arkime_packet_copy(ArkimePacket_t *packet)
+{
+    if (packet->copied)
+        return;
+
+    uint8_t *pkt = malloc(packet->pktlen);
+    memcpy(pkt, packet->pkt, packet->pktlen);
+    packet->pkt = pkt;
+    packet->copied = 1;
+
+    if (packet->block) {
+        arkime_packet_block_unref(packet->block);
+        packet->block = NULL;
+    }
 }
 
 /******************************************************************************/
@@ -216,7 +300,7 @@ void arkime_packet_flush()
 
         for (int t = 0; t < config.packetThreads; t++) {
             ARKIME_LOCK(packetThreadData[t].packetQ.lock);
-            if (DLL_COUNT(packet_, &packetThreadData[t].packetQ) > 0) {
+            if (DLL_COUNT(packet_, &packetThreadData[t].packetQ) > 0 || ARKIME_THREAD_ATOMIC_LOAD_RELAXED(packetThreadData[t].ringCount) > 0) {
                 flushed = 0;
             }
             ARKIME_UNLOCK(packetThreadData[t].packetQ.lock);
@@ -229,6 +313,26 @@ void arkime_packet_flush()
     }
 }
 /******************************************************************************/
+/* Add where a packet was written to the session, fileNum is set when it is the
+ * first packet of the session in that file.
+ */
+void arkime_packet_add_file_pos(ArkimeSession_t *session, uint32_t fileNum, uint64_t filePos, uint16_t len)
+{
+    if (fileNum) {
+        arkime_varint_append(&session->filePosArray, -1LL * fileNum);
+
+        if (config.enablePacketLen) {
+            arkime_varint_append(&session->fileLenArray, 0);
+        }
+    }
+
+    arkime_varint_append(&session->filePosArray, filePos);
+
+    if (config.enablePacketLen) {
+        arkime_varint_append(&session->fileLenArray, len);
+    }
+}
+/******************************************************************************/
 SUPPRESS_ALIGNMENT
 LOCAL void arkime_packet_process(ArkimePacket_t *packet, int thread)
 {
@@ -243,13 +347,17 @@ LOCAL void arkime_packet_process(ArkimePacket_t *packet, int thread)
     ArkimeSession_t      *session;
     struct ip            *ip4 = (struct ip *)(packet->pkt + packet->ipOffset);
     const struct ip6_hdr *ip6 = (struct ip6_hdr *)(packet->pkt + packet->ipOffset);
-    uint8_t               sessionId[ARKIME_SESSIONID_LEN];
-
+    uint8_t               sessionIdBuf[ARKIME_SESSIONID_LEN];
+    const uint8_t        *sessionId = packet->sessionId;
 
-    mProtocols[packet->mProtocol].createSessionId(sessionId, packet);
+    // tcp and udp already had their id built by the reader thread
+    if (!packet->haveSessionId) {
+        sessionId = sessionIdBuf;
+        mProtocols[packet->mProtocol].createSessionId(sessionIdBuf, packet);
 
-    if ((sessionId[0] & 0x03) != 0 || sessionId[0] > ARKIME_SESSIONID_LEN) {
-        LOGEXIT("ERROR - Session ID must be aligned to 4 bytes and <= %d, protocol %s is not (%d)", ARKIME_SESSIONID_LEN, mProtocols[packet->mProtocol].name, sessionId[0]);
+        if ((sessionId[0] & 0x03) != 0 || sessionId[0] > ARKIME_SESSIONID_LEN) {
+            LOGEXIT("ERROR - Session ID must be aligned to 4 bytes and <= %d, protocol %s is not (%d)", ARKIME_SESSIONID_LEN, mProtocols[packet->mProtocol].name, sessionId[0]);
+        }
     }
 
     // Try at most 2 times
@@ -339,24 +447,16 @@ LOCAL void arkime_packet_process(ArkimePacket_t *packet, int thread)
             // If the last fileNum used in the session isn't the same as the
             // latest packets fileNum then we need to add to the filePos and
             // fileNum arrays.
-            uint16_t len;
+            uint32_t newFileNum = 0;
             if (session->lastFileNum != packet->writerFileNum) {
                 session->lastFileNum = packet->writerFileNum;
                 g_array_append_val(session->fileNumArray, packet->writerFileNum);
-                int64_t pos = -1LL * packet->writerFileNum;
-                g_array_append_val(session->filePosArray, pos);
-
-                if (config.enablePacketLen) {
-                    len = 0;
-                    g_array_append_val(session->fileLenArray, len);
-                }
+                newFileNum = packet->writerFileNum;
             }
 
-            g_array_append_val(session->filePosArray, packet->writerFilePos);
-
-            if (config.enablePacketLen) {
-                len = 16 + packet->pktlen;
-                g_array_append_val(session->fileLenArray, len);
+            // The writer adds pending positions itself once it knows them
+            if (packet->writerFilePos != ARKIME_WRITER_FILE_POS_PENDING) {
+                arkime_packet_add_file_pos(session, newFileNum, packet->writerFilePos, 16 + packet->pktlen);
             }
         }
 
@@ -516,6 +616,192 @@ LOCAL void arkime_packet_process(ArkimePacket_t *packet, int thread)
     }
 }
 /******************************************************************************/
+/* Packets that are queued for a packet thread, both on the locked packetQ and
+ * in the producer rings.
+ */
+LOCAL inline int arkime_packet_queued(int thread)
+{
+    return DLL_COUNT(packet_, &packetThreadData[thread].packetQ) + ARKIME_THREAD_ATOMIC_LOAD_RELAXED(packetThreadData[thread].ringCount);
+}
+/******************************************************************************/
+/* Find or assign the ring producer slot for the current thread, returns -1 if
+ * rings are disabled or all the slots have been used.
+ */
+LOCAL int arkime_packet_ring_producer()
+{
+    if (likely(packetRingProducer != -1))
+        return packetRingProducer;
+
+    if (!packetRingSize)
+        return -1;
+
+    const int producer = ARKIME_THREAD_INCROLD(packetRingProducers);
+    if (producer >= ARKIME_PACKET_RING_PRODUCERS) {
+        LOG("WARNING - More than %d threads are sending packets, extra threads will use the locked packet queue", ARKIME_PACKET_RING_PRODUCERS);
+        packetRingProducer = -2;
+        return -2;
+    }
+
+    for (int t = 0; t < config.packetThreads; t++) {
+        ArkimePacketRing_t *ring = ARKIME_TYPE_ALLOC0_ALIGNED(ArkimePacketRing_t);
+        ring->packets = ARKIME_SIZE_ALLOC0("packetRing", sizeof(ArkimePacket_t *) * packetRingSize);
+        ring->mask = packetRingSize - 1;
+        ARKIME_THREAD_ATOMIC_STORE(packetThreadData[t].rings[producer], ring);
+    }
+    packetRingProducer = producer;
+    return producer;
+}
+/******************************************************************************/
+/* Move a batch queue into this producer's ring for a packet thread, anything
+ * that doesn't fit is dropped the same as hitting maxPacketsInQueue.
+ */
+LOCAL void arkime_packet_ring_push(ArkimePacketBatch_t *batch, int thread, int producer)
+{
+    PacketThreadData_t *ptd = &packetThreadData[thread];
+    ArkimePacketRing_t *ring = ptd->rings[producer];
+    ArkimePacket_t     *packet;
+
+    const uint32_t head = ARKIME_THREAD_ATOMIC_LOAD(ring->head);
+    uint32_t tail = ring->tail;
+    uint32_t space = ring->mask + 1 - (tail - head);
+    int added = 0;
+
+    while (space > 0 && DLL_POP_HEAD(packet_, &batch->packetQ[thread], packet)) {
+        ring->packets[tail & ring->mask] = packet;
+        tail++;
+        space--;
+        added++;
+    }
+
+    if (added) {
+        // ringCount goes up before the packets are visible so it never goes negative
+        ARKIME_THREAD_INCR_NUM(ptd->ringCount, added);
+        ARKIME_THREAD_ATOMIC_STORE(ring->tail, tail);
+
+        // Pairs with the fence in arkime_packet_thread before it sleeps
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (ARKIME_THREAD_ATOMIC_LOAD_RELAXED(ptd->sleeping)) {
+            ARKIME_LOCK(ptd->packetQ.lock);
+            ARKIME_COND_SIGNAL(ptd->packetQ.lock);
+            ARKIME_UNLOCK(ptd->packetQ.lock);
+        }
+    }
+
+    if (likely(DLL_COUNT(packet_, &batch->packetQ[thread]) == 0))
+        return;
+
+    ARKIME_LOCK(ptd->packetQ.lock);
+    while (DLL_POP_HEAD(packet_, &batch->packetQ[thread], packet)) {
+        ptd->overloadDrops++;
+        if ((ptd->overloadDrops % 10000) == 1) {
+            LOG("WARNING - Packet ring %d is overflowing, total dropped so far %" PRIu64 ".  See https://arkime.com/faq#why-am-i-dropping-packets and modify %s", thread, ptd->overloadDrops, config.configFile);
+        }
+        batch->packetStats[ARKIME_PACKET_OVERLOAD_DROPPED]++;
+        arkime_packet_free(packet);
+    }
+    ARKIME_UNLOCK(ptd->packetQ.lock);
+}
+#ifndef FUZZLOCH
+/******************************************************************************/
+LOCAL void arkime_packet_process_batch(ArkimePacket_t **packets, int cnt, int thread)
+{
+    if (packetBatchSize == 1) {
+        for (int i = 0; i < cnt; i++) {
+            arkime_packet_process(packets[i], thread);
+        }
+        return;
+    }
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Each pass only touches memory the previous pass prefetched
+    for (int i = 0; i < cnt; i++) {
+        arkime_session_prefetch(packets[i]->mProtocol, packets[i]->hash, 0);
+        __builtin_prefetch(packets[i]->pkt + packets[i]->ipOffset);
+    }
+    for (int i = 0; i < cnt; i++) {
+        arkime_session_prefetch(packets[i]->mProtocol, packets[i]->hash, 1);
+    }
+    for (int i = 0; i < cnt; i++) {
+        arkime_packet_process(packets[i], thread);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    PacketThreadData_t *ptd = &packetThreadData[thread];
+    ptd->batches++;
+    ptd->batchPackets += cnt;
+    ptd->batchNs += (stop.tv_sec - start.tv_sec) * 1000000000LL + (stop.tv_nsec - start.tv_nsec);
+}
+/******************************************************************************/
+/* Process packets from all the producer rings for a packet thread.  Normally
+ * only ARKIME_PACKET_RING_DRAIN packets per ring are taken so commands still
+ * run, if all is set everything published so far is processed.
+ * Returns the number of packets processed.
+ */
+LOCAL int arkime_packet_ring_drain(int thread, gboolean all)
+{
+    PacketThreadData_t *ptd = &packetThreadData[thread];
+    ArkimePacket_t     *packets[ARKIME_PACKET_RING_DRAIN];
+    int                 total = 0;
+
+    const int producers = MIN(ARKIME_THREAD_ATOMIC_LOAD(packetRingProducers), ARKIME_PACKET_RING_PRODUCERS);
+    for (int p = 0; p < producers; p++) {
+        ArkimePacketRing_t *ring = ARKIME_THREAD_ATOMIC_LOAD(ptd->rings[p]);
+        if (!ring)
+            continue;
+
+        const uint32_t tail = ARKIME_THREAD_ATOMIC_LOAD(ring->tail);
+        uint32_t head = ring->head;
+        while (head != tail) {
+            const uint32_t cnt = MIN(tail - head, ARKIME_PACKET_RING_DRAIN);
+            for (uint32_t i = 0; i < cnt; i++) {
+                packets[i] = ring->packets[(head + i) & ring->mask];
+            }
+            head += cnt;
+
+            // Give the slots back before processing so the producer can refill
+            ARKIME_THREAD_ATOMIC_STORE(ring->head, head);
+            ARKIME_THREAD_DECR_NUM(ptd->ringCount, cnt);
+
+            for (uint32_t i = 0; i < cnt; i += packetBatchSize) {
+                arkime_packet_process_batch(packets + i, MIN((int)(cnt - i), packetBatchSize), thread);
+            }
+            total += cnt;
+
+            if (!all)
+                break;
+        }
+    }
+    return total;
+}
+/******************************************************************************/
+LOCAL void arkime_packet_file_done(ArkimePacket_t *packet)
+{
+    // Make sure no best http requests are in the queue, like the file create
+    while (arkime_http_queue_length_best(esServer) > 0) {
+        usleep(5000);
+    }
+
+    // Could do a lock per file pos but this shouldn't happen too often
+    ARKIME_LOCK(offlineInfoLock);
+    ArkimeOfflineInfo_t *oi = &offlineInfo[packet->readerPos];
+    ARKIME_THREAD_DECR(oi->finishWaiting);
+    if (oi->finishWaiting == 0) {
+        arkime_db_update_file(oi->outputId, oi->lastBytes, oi->lastBytes, oi->lastPackets, &oi->lastPacketTime, oi->sessionsStarted, oi->sessionsPresent);
+        if (oi->notifyClientRef) {
+            arkime_command_notify_file_done(oi->notifyClientRef, oi->notifyFilename, oi->lastBytes, oi->lastPackets);
+            arkime_command_client_decref(oi->notifyClientRef);
+            g_free(oi->notifyFilename);
+            oi->notifyClientRef = NULL;
+            oi->notifyFilename = NULL;
+        }
+    }
+    ARKIME_UNLOCK(offlineInfoLock);
+    arkime_packet_free(packet);
+}
+#endif
+/******************************************************************************/
 __thread int arkimePacketThread = -1;
 #ifndef FUZZLOCH
 LOCAL void *arkime_packet_thread(void *threadp)
@@ -528,63 +814,69 @@ LOCAL void *arkime_packet_thread(void *threadp)
     arkime_call_named_func(arkime_packet_thread_init_func, thread, NULL);
 
     // Continue while packet_exit hasn't been called and we still have outstanding packets
-    while (likely(runThreads || DLL_COUNT(packet_, &packetThreadData[thread].packetQ))) {
-        ArkimePacket_t  *packet;
-
-        ARKIME_LOCK(packetThreadData[thread].packetQ.lock);
-        ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].inProgress, 0);
-        if (DLL_COUNT(packet_, &packetThreadData[thread].packetQ) == 0) {
-            struct timespec ts;
-            clock_gettime(CLOCK_REALTIME_COARSE, &ts);
-            arkimeThreadData[thread].currentTime = ts.tv_sec;
-            ts.tv_sec++;
-            ARKIME_COND_TIMEDWAIT(packetThreadData[thread].packetQ.lock, ts);
-
-            /* If we are in live capture mode and we haven't received any packets for 10 seconds we set current time to 10
-             * seconds in the past so arkime_session_process_commands will clean things up.  10 seconds is arbitrary but
-             * we want to make sure we don't set the time ahead of any packets that are currently being read off the wire
-             */
-            if (!config.pcapReadOffline && DLL_COUNT(packet_, &packetThreadData[thread].packetQ) == 0 && ts.tv_sec - 10 > arkimeThreadData[thread].lastPacketSecs) {
-                arkimeThreadData[thread].lastPacketSecs = ts.tv_sec - 10;
+    while (likely(runThreads || arkime_packet_queued(thread))) {
+        ArkimePacket_t  *packets[ARKIME_PACKET_BATCH_MAX];
+        int              cnt = 0;
+
+        // When only the rings have packets they are drained below without taking the packetQ lock
+        if (packetRingSize && DLL_COUNT(packet_, &packetThreadData[thread].packetQ) == 0 &&
+            ARKIME_THREAD_ATOMIC_LOAD_RELAXED(packetThreadData[thread].ringCount) > 0) {
+            ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].inProgress, 1);
+        } else {
+            ARKIME_LOCK(packetThreadData[thread].packetQ.lock);
+            ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].inProgress, 0);
+            if (arkime_packet_queued(thread) == 0) {
+                struct timespec ts;
+                clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+                arkimeThreadData[thread].currentTime = ts.tv_sec;
+                ts.tv_sec++;
+
+                // Ring producers only signal if they see sleeping set, recheck after setting it
+                ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].sleeping, 1);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                if (ARKIME_THREAD_ATOMIC_LOAD_RELAXED(packetThreadData[thread].ringCount) == 0) {
+                    ARKIME_COND_TIMEDWAIT(packetThreadData[thread].packetQ.lock, ts);
+                }
+                ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].sleeping, 0);
+
+                /* If we are in live capture mode and we haven't received any packets for 10 seconds we set current time to 10
+                 * seconds in the past so arkime_session_process_commands will clean things up.  10 seconds is arbitrary but
+                 * we want to make sure we don't set the time ahead of any packets that are currently being read off the wire
+                 */
+                if (!config.pcapReadOffline && arkime_packet_queued(thread) == 0 && ts.tv_sec - 10 > arkimeThreadData[thread].lastPacketSecs) {
+                    arkimeThreadData[thread].lastPacketSecs = ts.tv_sec - 10;
+                }
+            }
+            ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].inProgress, 1);
+            // An end of file marker always ends the batch
+            while (cnt < packetBatchSize && DLL_POP_HEAD(packet_, &packetThreadData[thread].packetQ, packets[cnt])) {
+                if (packets[cnt++]->pktlen == ARKIME_PACKET_LEN_FILE_DONE)
+                    break;
             }
+            ARKIME_UNLOCK(packetThreadData[thread].packetQ.lock);
         }
-        ARKIME_THREAD_ATOMIC_STORE_RELAXED(packetThreadData[thread].inProgress, 1);
-        DLL_POP_HEAD(packet_, &packetThreadData[thread].packetQ, packet);
-        ARKIME_UNLOCK(packetThreadData[thread].packetQ.lock);
 
         // Only process commands if the packetQ is less than 75% full or every 8 packets
-        if (likely(DLL_COUNT(packet_, &packetThreadData[thread].packetQ) < maxPackets75) || (++skipCount & 0x7) == 0) {
+        if (likely(arkime_packet_queued(thread) < (int)maxPackets75) || (++skipCount & 0x7) == 0) {
             arkime_session_process_commands(thread);
         }
 
-        if (!packet)
-            continue;
+        const gboolean fileDone = cnt > 0 && packets[cnt - 1]->pktlen == ARKIME_PACKET_LEN_FILE_DONE;
+        if (packetRingSize) {
+            arkime_packet_ring_drain(thread, fileDone);
+        }
 
-        if (unlikely(packet->pktlen == ARKIME_PACKET_LEN_FILE_DONE)) {
-            // Make sure no best http requests are in the queue, like the file create
-            while (arkime_http_queue_length_best(esServer) > 0) {
-                usleep(5000);
-            }
+        if (unlikely(fileDone)) {
+            cnt--;
+        }
 
-            // Could do a lock per file pos but this shouldn't happen too often
-            ARKIME_LOCK(offlineInfoLock);
-            ArkimeOfflineInfo_t *oi = &offlineInfo[packet->readerPos];
-            ARKIME_THREAD_DECR(oi->finishWaiting);
-            if (oi->finishWaiting == 0) {
-                arkime_db_update_file(oi->outputId, oi->lastBytes, oi->lastBytes, oi->lastPackets, &oi->lastPacketTime, oi->sessionsStarted, oi->sessionsPresent);
-                if (oi->notifyClientRef) {
-                    arkime_command_notify_file_done(oi->notifyClientRef, oi->notifyFilename, oi->lastBytes, oi->lastPackets);
-                    arkime_command_client_decref(oi->notifyClientRef);
-                    g_free(oi->notifyFilename);
-                    oi->notifyClientRef = NULL;
-                    oi->notifyFilename = NULL;
-                }
-            }
-            ARKIME_UNLOCK(offlineInfoLock);
-            arkime_packet_free(packet);
-            continue;
+        if (cnt > 0) {
+            arkime_packet_process_batch(packets, cnt, thread);
+        }
+
+        if (unlikely(fileDone)) {
+            arkime_packet_file_done(packets[cnt]);
         }
-        arkime_packet_process(packet, thread);
     }
 
     arkime_call_named_func(arkime_packet_thread_exit_func, thread, NULL);
@@ -594,65 +886,126 @@ LOCAL void *arkime_packet_thread(void *threadp)
 }
 #endif
 /******************************************************************************/
-LOCAL void arkime_packet_frags_free(ArkimeFrags_t *const frags)
+SUPPRESS_UNSIGNED_INTEGER_OVERFLOW
+LOCAL uint32_t arkime_packet_frag_hash(const void *key)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < ARKIME_FRAGS_KEY_LEN; i++) {
+        n = (n << 5) - n + ((uint8_t *)key)[i];
+    }
+    return n;
+}
+/******************************************************************************/
+LOCAL int arkime_packet_frag_cmp(const void *keyv, const ArkimeFrags_t *element)
+{
+    return memcmp(keyv, element->key, ARKIME_FRAGS_KEY_LEN) == 0;
+}
+/******************************************************************************/
+LOCAL void arkime_packet_frags_table_init(ArkimeFragsTable_t *table)
+{
+    for (int s = 0; s < ARKIME_FRAGS_SHARDS; s++) {
+        HASHP_INIT(fragh_, table->shards[s].hash, ARKIME_FRAGS_HASH_SIZE, arkime_packet_frag_hash, (HASH_CMP_FUNC)arkime_packet_frag_cmp);
+        DLL_INIT(fragl_, &table->shards[s].list);
+        ARKIME_LOCK_INIT(table->shards[s].lock);
+    }
+}
+/******************************************************************************/
+// Double the buckets once a shard averages more than 2 entries per bucket
+LOCAL void arkime_packet_frags_resize(ArkimeFragsShard_t *shard)
+{
+    ArkimeFragsHash_t  old = shard->hash;
+    const int          size = old.size * 2 + 1;
+    ArkimeFrags_t     *frags;
+
+    HASHP_INIT(fragh_, shard->hash, size, arkime_packet_frag_hash, (HASH_CMP_FUNC)arkime_packet_frag_cmp);
+    HASH_FORALL_POP_HEAD2(fragh_, old, frags) {
+        HASH_ADD_HASH(fragh_, shard->hash, frags->fragh_hash, frags->key, frags);
+    }
+    free(old.buckets);
+}
+/******************************************************************************/
+LOCAL void arkime_packet_frags_free(ArkimeFragsTable_t *table, ArkimeFragsShard_t *shard, ArkimeFrags_t *const frags)
 {
     ArkimePacket_t *packet;
 
     while (DLL_POP_HEAD(packet_, &frags->packets, packet)) {
         arkime_packet_free(packet);
     }
-    HASH_REMOVE(fragh_, fragsHash, frags);
-    DLL_REMOVE(fragl_, &fragsList, frags);
+    HASH_REMOVE(fragh_, shard->hash, frags);
+    DLL_REMOVE(fragl_, &shard->list, frags);
+    ARKIME_THREAD_DECR(table->count);
     ARKIME_TYPE_FREE(ArkimeFrags_t, frags);
 }
 /******************************************************************************/
+// The ip6 fragment header is always just before the fragment data
+#define ARKIME_PACKET_FRAG6(p) ((struct ip6_frag *)((p)->pkt + (p)->payloadOffset - sizeof(struct ip6_frag)))
+
 SUPPRESS_ALIGNMENT
-LOCAL gboolean arkime_packet_frags_process(ArkimePacket_t *const packet)
+LOCAL int arkime_packet_frag_offset(const ArkimePacket_t *packet, int *more)
+{
+    if (packet->v6) {
+        const struct ip6_frag *frag = ARKIME_PACKET_FRAG6(packet);
+        if (more)
+            *more = (frag->ip6f_offlg & IP6F_MORE_FRAG) != 0;
+        return ntohs(frag->ip6f_offlg & IP6F_OFF_MASK);
+    }
+
+    const struct ip *ip4 = (struct ip *)(packet->pkt + packet->ipOffset);
+    const uint16_t ip_off = ntohs(ip4->ip_off);
+    if (more)
+        *more = (ip_off & IP_MF) != 0;
+    return (ip_off & IP_OFFMASK) * 8;
+}
+/******************************************************************************/
+/* The datagram is rebuilt using the headers of the packet that completes it.
+ * For ip6 the fragment header is dropped and the next header byte at
+ * nxtOffset is set to the protocol from the first fragment.
+ */
+SUPPRESS_ALIGNMENT
+LOCAL gboolean arkime_packet_frags_process(ArkimeFragsTable_t *table, ArkimeFragsShard_t *shard, ArkimePacket_t *const packet, const uint8_t *key, uint32_t h, int nxtOffset)
 {
     ArkimePacket_t  *fpacket;
     ArkimeFrags_t   *frags;
-    char             key[10];
-
-    struct ip *const ip4 = (struct ip *)(packet->pkt + packet->ipOffset);
-    memcpy(key, &ip4->ip_src.s_addr, 4);
-    memcpy(key + 4, &ip4->ip_dst.s_addr, 4);
-    memcpy(key + 8, &ip4->ip_id, 2);
 
-    HASH_FIND(fragh_, fragsHash, key, frags);
+    HASH_FIND_HASH(fragh_, shard->hash, h, key, frags);
 
     if (!frags) {
         frags = ARKIME_TYPE_ALLOC0_ALIGNED(ArkimeFrags_t);
-        memcpy(frags->key, key, 10);
+        memcpy(frags->key, key, ARKIME_FRAGS_KEY_LEN);
         frags->secs = packet->ts.tv_sec;
-        HASH_ADD(fragh_, fragsHash, key, frags);
-        DLL_PUSH_TAIL(fragl_, &fragsList, frags);
+        HASH_ADD_HASH(fragh_, shard->hash, h, key, frags);
+        DLL_PUSH_TAIL(fragl_, &shard->list, frags);
         DLL_INIT(packet_, &frags->packets);
-        DLL_PUSH_TAIL(packet_, &frags->packets, packet);
 
-        if (DLL_COUNT(fragl_, &fragsList) > config.maxFrags) {
-            droppedFrags++;
-            arkime_packet_frags_free(DLL_PEEK_HEAD(fragl_, &fragsList));
+        if (HASH_COUNT(fragh_, shard->hash) > 2 * shard->hash.size) {
+            arkime_packet_frags_resize(shard);
+        }
+
+        // Over the limit, drop the oldest in this shard which might be us
+        if (ARKIME_THREAD_INCR(table->count) > config.maxFrags) {
+            ArkimeFrags_t *oldest = DLL_PEEK_HEAD(fragl_, &shard->list);
+            ARKIME_THREAD_INCR(droppedFrags);
+            arkime_packet_frags_free(table, shard, oldest);
+            if (oldest == frags) {
+                arkime_packet_free(packet);
+                return FALSE;
+            }
         }
-        return FALSE;
     } else {
-        DLL_MOVE_TAIL(fragl_, &fragsList, frags);
+        DLL_MOVE_TAIL(fragl_, &shard->list, frags);
     }
 
-    uint16_t          ip_off = ntohs(ip4->ip_off);
-    uint16_t          ip_flags = ip_off & ~IP_OFFMASK;
-    ip_off &= IP_OFFMASK;
-
+    int more;
+    const int off = arkime_packet_frag_offset(packet, &more);
 
     // Last fragment = MF clear; ignore DF/reserved bits
-    if ((ip_flags & IP_MF) == 0) {
+    if (!more) {
         frags->haveNoFlags = 1;
     }
 
     // Insert this packet in correct location sorted by offset
     DLL_FOREACH_REVERSE(packet_, &frags->packets, fpacket) {
-        struct ip *fip4 = (struct ip *)(fpacket->pkt + fpacket->ipOffset);
-        uint16_t fip_off = ntohs(fip4->ip_off) & IP_OFFMASK;
-        if (ip_off >= fip_off) {
+        if (off >= arkime_packet_frag_offset(fpacket, NULL)) {
             DLL_ADD_AFTER(packet_, &frags->packets, fpacket, packet);
             break;
         }
@@ -662,8 +1015,8 @@ LOCAL gboolean arkime_packet_frags_process(ArkimePacket_t *const packet)
     }
 
     if (DLL_COUNT(packet_, &frags->packets) > 50) {
-        droppedFrags++;
-        arkime_packet_frags_free(frags);
+        ARKIME_THREAD_INCR(droppedFrags);
+        arkime_packet_frags_free(table, shard, frags);
         return FALSE;
     }
 
@@ -672,94 +1025,123 @@ LOCAL gboolean arkime_packet_frags_process(ArkimePacket_t *const packet)
         return FALSE;
     }
 
-    int off = 0;
-    struct ip *fip4;
-
+    int next = 0;
     int payloadLen = 0;
     DLL_FOREACH(packet_, &frags->packets, fpacket) {
-        fip4 = (struct ip *)(fpacket->pkt + fpacket->ipOffset);
-        uint16_t fip_off = ntohs(fip4->ip_off) & IP_OFFMASK;
-        if (fip_off != off)
+        const int foff = arkime_packet_frag_offset(fpacket, NULL);
+        if (foff != next)
             break;
-        off += fpacket->payloadLen / 8;
-        payloadLen = MAX(payloadLen, fip_off * 8 + fpacket->payloadLen);
+        next += fpacket->payloadLen & ~7;
+        payloadLen = MAX(payloadLen, foff + fpacket->payloadLen);
     }
     // We have a hole
     if ((void *)fpacket != (void *)&frags->packets) {
         return FALSE;
     }
 
+    const int hdrLen = packet->v6 ? packet->payloadOffset - (int)sizeof(struct ip6_frag) : packet->payloadOffset;
+
     // Packet is too large, hacker
-    if (payloadLen + packet->payloadOffset > ARKIME_PACKET_MAX_LEN) {
-        droppedFrags++;
-        arkime_packet_frags_free(frags);
+    if (payloadLen + hdrLen > ARKIME_PACKET_MAX_LEN) {
+        ARKIME_THREAD_INCR(droppedFrags);
+        arkime_packet_frags_free(table, shard, frags);
         return FALSE;
     }
 
     // Now alloc the full packet
-    packet->pktlen = packet->payloadOffset + payloadLen;
-    uint8_t *pkt = malloc(packet->pktlen);
+    const int pktlen = hdrLen + payloadLen;
+    uint8_t *pkt = malloc(pktlen);
 
     // Copy packet header
-    memcpy(pkt, packet->pkt, packet->payloadOffset);
+    memcpy(pkt, packet->pkt, hdrLen);
 
     // Fix header of new packet
-    fip4 = (struct ip *)(pkt + packet->ipOffset);
-    fip4->ip_len = htons(payloadLen + 4 * ip4->ip_hl);
-    fip4->ip_off = 0;
+    if (packet->v6) {
+        pkt[nxtOffset] = ARKIME_PACKET_FRAG6(DLL_PEEK_HEAD(packet_, &frags->packets))->ip6f_nxt;
+        struct ip6_hdr *ip6 = (struct ip6_hdr *)(pkt + packet->ipOffset);
+        ip6->ip6_plen = htons(pktlen - packet->ipOffset - sizeof(struct ip6_hdr));
+    } else {
+        struct ip *ip4 = (struct ip *)(pkt + packet->ipOffset);
+        ip4->ip_len = htons(payloadLen + 4 * ip4->ip_hl);
+        ip4->ip_off = 0;
+    }
 
     // Copy payload
     DLL_FOREACH(packet_, &frags->packets, fpacket) {
-        fip4 = (struct ip *)(fpacket->pkt + fpacket->ipOffset);
-        uint16_t fip_off = ntohs(fip4->ip_off) & IP_OFFMASK;
+        const int foff = arkime_packet_frag_offset(fpacket, NULL);
 
-        if (packet->payloadOffset + (fip_off * 8) + fpacket->payloadLen <= packet->pktlen)
-            memcpy(pkt + packet->payloadOffset + (fip_off * 8), fpacket->pkt + fpacket->payloadOffset, fpacket->payloadLen);
+        if (hdrLen + foff + fpacket->payloadLen <= pktlen)
+            memcpy(pkt + hdrLen + foff, fpacket->pkt + fpacket->payloadOffset, fpacket->payloadLen);
         else
-            LOG("WARNING - Not enough room for frag %d > %d", packet->payloadOffset + (fip_off * 8) + fpacket->payloadLen, packet->pktlen);
+            LOG("WARNING - Not enough room for frag %d > %d", hdrLen + foff + fpacket->payloadLen, pktlen);
     }
 
     // Set all the vars in the current packet to new defragged packet
     if (packet->copied)
         free(packet->pkt);
     packet->pkt = pkt;
+    packet->pktlen = pktlen;
     packet->copied = 1;
     packet->wasfrag = 1;
+    packet->payloadOffset = hdrLen;
     packet->payloadLen = payloadLen;
     DLL_REMOVE(packet_, &frags->packets, packet); // Remove from list so we don't get freed in frags_free
-    arkime_packet_frags_free(frags);
+    arkime_packet_frags_free(table, shard, frags);
     return TRUE;
 }
 /******************************************************************************/
-LOCAL void arkime_packet_frags4(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet)
+LOCAL void arkime_packet_frags(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, ArkimeFragsTable_t *table, const uint8_t *key, int nxtOffset)
 {
     ArkimeFrags_t *frags;
 
+    // Buckets use the low bits so pick the shard from the mixed high bits
+    const uint32_t h = arkime_packet_frag_hash(key);
+    ArkimeFragsShard_t *shard = &table->shards[((uint64_t)h * 2654435761U >> 16) % ARKIME_FRAGS_SHARDS];
+
     // ALW - Should change frags_process to make the copy when needed
-    if (!packet->copied) {
-        uint8_t *pkt = malloc(packet->pktlen);
-        memcpy(pkt, packet->pkt, packet->pktlen);
-        packet->pkt = pkt;
-        packet->copied = 1;
-    }
+    arkime_packet_copy(packet);
 
-    ARKIME_LOCK(frags);
+    ARKIME_LOCK(shard->lock);
     // Remove expired entries
-    while ((frags = DLL_PEEK_HEAD(fragl_, &fragsList)) && (frags->secs + config.fragsTimeout < packet->ts.tv_sec)) {
-        droppedFrags++;
-        arkime_packet_frags_free(frags);
+    while ((frags = DLL_PEEK_HEAD(fragl_, &shard->list)) && (frags->secs + config.fragsTimeout < packet->ts.tv_sec)) {
+        ARKIME_THREAD_INCR(droppedFrags);
+        arkime_packet_frags_free(table, shard, frags);
     }
 
-    gboolean process = arkime_packet_frags_process(packet);
-    ARKIME_UNLOCK(frags);
+    gboolean process = arkime_packet_frags_process(table, shard, packet, key, h, nxtOffset);
+    ARKIME_UNLOCK(shard->lock);
 
     if (process)
         arkime_packet_batch(batch, packet);
 }
 /******************************************************************************/
+LOCAL void arkime_packet_frags4(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet)
+{
+    uint8_t key[ARKIME_FRAGS_KEY_LEN] = {0};
+
+    const struct ip *ip4 = (struct ip *)(packet->pkt + packet->ipOffset);
+    memcpy(key, &ip4->ip_src.s_addr, 4);
+    memcpy(key + 4, &ip4->ip_dst.s_addr, 4);
+    memcpy(key + 8, &ip4->ip_id, 2);
+
+    arkime_packet_frags(batch, packet, &frags4, key, 0);
+}
+/******************************************************************************/
+LOCAL void arkime_packet_frags6(ArkimePacketBatch_t *batch, ArkimePacket_t *const packet, int nxtOffset)
+{
+    uint8_t key[ARKIME_FRAGS_KEY_LEN];
+
+    const struct ip6_hdr *ip6 = (struct ip6_hdr *)(packet->pkt + packet->ipOffset);
+    memcpy(key, &ip6->ip6_src, 16);
+    memcpy(key + 16, &ip6->ip6_dst, 16);
+    memcpy(key + 32, &ARKIME_PACKET_FRAG6(packet)->ip6f_ident, 4);
+
+    arkime_packet_frags(batch, packet, &frags6, key, nxtOffset);
+}
+/******************************************************************************/
 int arkime_packet_frags_size()
 {
-    return DLL_COUNT(fragl_, &fragsList);
+    return ARKIME_THREAD_ATOMIC_LOAD(frags4.count) + ARKIME_THREAD_ATOMIC_LOAD(frags6.count);
 }
 /******************************************************************************/
 int arkime_packet_frags_outstanding()
@@ -889,6 +1271,125 @@ LOCAL void arkime_packet_cmd_stats(int UNUSED(argc), char **UNUSED(argv), gpoint
                        arkimeCounters.packetStats[ARKIME_PACKET_DUPLICATE_DROPPED]
                       );
 
+    if (packetBatchSize > 1) {
+        BSB_EXPORT_sprintf(bsb, "\n%-8s %14s %14s %10s %10s\n", "Thread", "Batches", "Packets", "Avg Size", "ns/Packet");
+        for (int t = 0; t < config.packetThreads; t++) {
+            const PacketThreadData_t *ptd = &packetThreadData[t];
+            BSB_EXPORT_sprintf(bsb, "%-8d %14" PRIu64 " %14" PRIu64 " %10.1f %10.1f\n", t, ptd->batches, ptd->batchPackets,
+                               ptd->batches ? (double)ptd->batchPackets / ptd->batches : 0.0,
+                               ptd->batchPackets ? (double)ptd->batchNs / ptd->batchPackets : 0.0);
+        }
+    }
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+}
+/******************************************************************************/
+/* Microbenchmark of what carrying the session id from the reader saves.  Small
+ * tcp packets are built in memory, then their ids are either rebuilt with the
+ * tcp createSessionId like the packet thread used to, or read from the
+ * packet->sessionId the ip decode filled in.  TSC ticks are shown on x86.
+ */
+LOCAL void arkime_packet_cmd_sessionid_bench(int argc, char **argv, gpointer cc)
+{
+    char                  output[500];
+    BSB                   bsb;
+    struct timespec       start, stop;
+    uint8_t               sessionId[ARKIME_SESSIONID_LEN];
+    uint32_t              sum = 0;
+
+    uint32_t num = 100000;
+    if (argc > 1) {
+        num = MIN(10000000, MAX(1000, strtoul(argv[1], NULL, 10)));
+    }
+
+    // Ethernet, ip6 and a tcp header without options is the largest
+    const int       pktSize = 14 + sizeof(struct ip6_hdr) + sizeof(struct tcphdr);
+    uint8_t        *pkts = ARKIME_SIZE_ALLOC("bench", (size_t)pktSize * num);
+    ArkimePacket_t **packets = ARKIME_SIZE_ALLOC("bench", sizeof(ArkimePacket_t *) * num);
+
+    BSB_INIT(bsb, output, sizeof(output));
+    BSB_EXPORT_sprintf(bsb, "Session id with %u small tcp packets (ns/packet", num);
+#if defined(__x86_64__) || defined(__i386__)
+    BSB_EXPORT_cstr(bsb, ", tsc ticks/packet");
+#endif
+    BSB_EXPORT_cstr(bsb, ")\n");
+
+    for (int v6 = 0; v6 < 2; v6++) {
+        memset(pkts, 0, (size_t)pktSize * num);
+        for (uint32_t i = 0; i < num; i++) {
+            ArkimePacket_t *packet = packets[i] = arkime_packet_alloc();
+            packet->pkt = pkts + (size_t)i * pktSize;
+            packet->ipOffset = 14;
+            packet->v6 = v6;
+            packet->mProtocol = tcpMProtocol;
+
+            struct tcphdr *tcphdr;
+            if (v6) {
+                struct ip6_hdr *ip6 = (struct ip6_hdr *)(packet->pkt + 14);
+                ip6->ip6_vfc = 0x60;
+                ip6->ip6_nxt = IPPROTO_TCP;
+                const uint32_t client = htonl(i >> 4);
+                const uint32_t server = htonl(0x10000 | (random() % 500));
+                memcpy(ip6->ip6_src.s6_addr, "\x20\x01\x0d\xb8", 4);
+                memcpy(ip6->ip6_src.s6_addr + 12, &client, 4);
+                memcpy(ip6->ip6_dst.s6_addr, "\x20\x01\x0d\xb8", 4);
+                memcpy(ip6->ip6_dst.s6_addr + 12, &server, 4);
+                packet->payloadOffset = 14 + sizeof(struct ip6_hdr);
+                tcphdr = (struct tcphdr *)(packet->pkt + packet->payloadOffset);
+                tcphdr->th_sport = htons(1024 + random() % 64000);
+                tcphdr->th_dport = htons(443);
+                arkime_session_id6(packet->sessionId, ip6->ip6_src.s6_addr, tcphdr->th_sport,
+                                   ip6->ip6_dst.s6_addr, tcphdr->th_dport, packet->vlan, packet->vni);
+            } else {
+                struct ip *ip4 = (struct ip *)(packet->pkt + 14);
+                ip4->ip_v = 4;
+                ip4->ip_hl = 5;
+                ip4->ip_p = IPPROTO_TCP;
+                ip4->ip_src.s_addr = htonl(0x0a000000 | (i >> 4));
+                ip4->ip_dst.s_addr = htonl(0xc0a80000 | (random() % 500));
+                packet->payloadOffset = 14 + sizeof(struct ip);
+                tcphdr = (struct tcphdr *)(packet->pkt + packet->payloadOffset);
+                tcphdr->th_sport = htons(1024 + random() % 64000);
+                tcphdr->th_dport = htons(443);
+                arkime_session_id(packet->sessionId, ip4->ip_src.s_addr, tcphdr->th_sport,
+                                  ip4->ip_dst.s_addr, tcphdr->th_dport, packet->vlan, packet->vni);
+            }
+            packet->pktlen = packet->payloadOffset + sizeof(struct tcphdr);
+            packet->haveSessionId = 1;
+        }
+
+        for (int carried = 0; carried < 2; carried++) {
+#if defined(__x86_64__) || defined(__i386__)
+            const uint64_t tsc = __builtin_ia32_rdtsc();
+#endif
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (uint32_t i = 0; i < num; i++) {
+                const uint8_t *id = packets[i]->sessionId;
+                if (!carried) {
+                    mProtocols[packets[i]->mProtocol].createSessionId(sessionId, packets[i]);
+                    id = sessionId;
+                }
+                sum += id[4] + id[id[0] - 1];
+            }
+            clock_gettime(CLOCK_MONOTONIC, &stop);
+
+            const double ns = (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+            BSB_EXPORT_sprintf(bsb, "  %s %-8s %8.1f", v6 ? "ip6" : "ip4", carried ? "carried" : "rebuilt", ns / num);
+#if defined(__x86_64__) || defined(__i386__)
+            BSB_EXPORT_sprintf(bsb, " %8.1f", (double)(__builtin_ia32_rdtsc() - tsc) / num);
+#endif
+            BSB_EXPORT_cstr(bsb, "\n");
+        }
+
+        for (uint32_t i = 0; i < num; i++) {
+            arkime_packet_free(packets[i]);
+        }
+    }
+    BSB_EXPORT_sprintf(bsb, "  checksum %u\n", sum);
+
+    ARKIME_SIZE_FREE("bench", pkts);
+    ARKIME_SIZE_FREE("bench", packets);
+
     arkime_command_respond(cc, output, BSB_LENGTH(bsb));
 }
 /******************************************************************************/
@@ -906,7 +1407,7 @@ LOCAL ArkimePacketRC arkime_packet_ip4(ArkimePacketBatch_t *batch, ArkimePacket_
     struct ip           *ip4 = (struct ip *)data;
     const struct tcphdr *tcphdr = 0;
     const struct udphdr *udphdr = 0;
-    uint8_t              sessionId[ARKIME_SESSIONID_LEN];
+    uint8_t *const       sessionId = packet->sessionId;
 
 #ifdef DEBUG_PACKET
     LOG("enter %p %p %d", packet, data, len);
@@ -1086,6 +1587,7 @@ LOCAL ArkimePacketRC arkime_packet_ip4(ArkimePacketBatch_t *batch, ArkimePacket_
         return arkime_packet_run_ip_cb(batch, packet, data + ip_hdr_len, len - ip_hdr_len, ip4->ip_p, "IP4");
     }
     packet->hash = arkime_session_hash(sessionId);
+    packet->haveSessionId = 1;
     return ARKIME_PACKET_DO_PROCESS;
 }
 /******************************************************************************/
@@ -1095,7 +1597,7 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
     const struct ip6_hdr *ip6 = (struct ip6_hdr *)data;
     const struct tcphdr  *tcphdr = 0;
     const struct udphdr  *udphdr = 0;
-    uint8_t               sessionId[ARKIME_SESSIONID_LEN];
+    uint8_t *const        sessionId = packet->sessionId;
 
 #ifdef DEBUG_PACKET
     LOG("enter %p %p %d", packet, data, len);
@@ -1171,6 +1673,7 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
 
     packet->mProtocol = 0;
     int nxt = ip6->ip6_nxt;
+    int nxtOffset = packet->ipOffset + offsetof(struct ip6_hdr, ip6_nxt);
     int done = 0;
     int extHdrCount = 0;
 
@@ -1211,6 +1714,7 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
             }
 
             nxt = data[ip_hdr_len];
+            nxtOffset = packet->ipOffset + ip_hdr_len;
             ip_hdr_len = newHdrLen;
 
             packet->payloadOffset = packet->ipOffset + ip_hdr_len;
@@ -1225,10 +1729,29 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
 
             break;
         case IPPROTO_FRAGMENT:
+            if (disableIp6Defrag) {
+                return ARKIME_PACKET_UNKNOWN_IP;
+            }
+            if (len < ip_hdr_len + (int)sizeof(struct ip6_frag) || ip_len + (int)sizeof(struct ip6_hdr) < ip_hdr_len + (int)sizeof(struct ip6_frag)) {
 #ifdef DEBUG_PACKET
-            LOG("ERROR - Don't support ip6 fragments yet!");
+                LOG("ERROR - %d < %d + fragment header", len, ip_hdr_len);
 #endif
-            return ARKIME_PACKET_UNKNOWN_IP;
+                return ARKIME_PACKET_CORRUPT;
+            }
+
+            ip_hdr_len += sizeof(struct ip6_frag);
+            packet->payloadOffset = packet->ipOffset + ip_hdr_len;
+            packet->payloadLen = ip_len + sizeof(struct ip6_hdr) - ip_hdr_len;
+
+            if (packet->pktlen < packet->payloadOffset + packet->payloadLen) {
+#ifdef DEBUG_PACKET
+                LOG("ERROR - %d < %d + %d", packet->pktlen, packet->payloadOffset, packet->payloadLen);
+#endif
+                return ARKIME_PACKET_CORRUPT;
+            }
+
+            arkime_packet_frags6(batch, packet, nxtOffset);
+            return ARKIME_PACKET_DONT_PROCESS_OR_FREE;
 
         case IPPROTO_TCP:
             if (len < ip_hdr_len + (int)sizeof(struct tcphdr)) {
@@ -1285,9 +1808,6 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
             if (udpUlen < (int)sizeof(struct udphdr) || udpUlen > ip_len + (int)sizeof(struct ip6_hdr) - ip_hdr_len)
                 return ARKIME_PACKET_CORRUPT;
 
-            arkime_session_id6(sessionId, ip6->ip6_src.s6_addr, udphdr->uh_sport,
-                               ip6->ip6_dst.s6_addr, udphdr->uh_dport, packet->vlan, packet->vni);
-
             if (len > ip_hdr_len + (int)sizeof(struct udphdr) + 8 && udpPortCbs[udphdr->uh_dport]) {
                 // Use the UDP datagram length, not the IP remainder, so trailing
                 // padding is not fed to tunnel decapsulators as smuggled payload.
@@ -1310,6 +1830,9 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
                     return ARKIME_PACKET_DUPLICATE_DROPPED;
             }
 
+            // After the tunnel callbacks since they decode into the same packet->sessionId
+            arkime_session_id6(sessionId, ip6->ip6_src.s6_addr, udphdr->uh_sport,
+                               ip6->ip6_dst.s6_addr, udphdr->uh_dport, packet->vlan, packet->vni);
             packet->mProtocol = udpMProtocol;
             done = 1;
             break;
@@ -1329,6 +1852,7 @@ LOCAL ArkimePacketRC arkime_packet_ip6(ArkimePacketBatch_t *batch, ArkimePacket_
     } while (!done);
 
     packet->hash = arkime_session_hash(sessionId);
+    packet->haveSessionId = 1;
     return ARKIME_PACKET_DO_PROCESS;
 }
 /******************************************************************************/
@@ -1607,6 +2131,7 @@ LOCAL ArkimePacketRC arkime_packet_radiotap(ArkimePacketBatch_t *batch, ArkimePa
 /******************************************************************************/
 void arkime_packet_batch_init(ArkimePacketBatch_t *batch)
 {
+    batch->packetQ = ARKIME_SIZE_ALLOC("packetQ", sizeof(ArkimePacketHead_t) * config.packetThreads);
     for (int t = 0; t < config.packetThreads; t++) {
         DLL_INIT(packet_, &batch->packetQ[t]);
     }
@@ -1616,10 +2141,22 @@ void arkime_packet_batch_init(ArkimePacketBatch_t *batch)
     batch->count = 0;
 }
 /******************************************************************************/
+// The batch must have been flushed
+void arkime_packet_batch_free(ArkimePacketBatch_t *batch)
+{
+    free(batch->packetQ);
+    batch->packetQ = NULL;
+}
+/******************************************************************************/
 void arkime_packet_batch_flush(ArkimePacketBatch_t *batch)
 {
+    const int producer = arkime_packet_ring_producer();
     for (int t = 0; t < config.packetThreads; t++) {
         if (DLL_COUNT(packet_, &batch->packetQ[t]) > 0) {
+            if (producer >= 0) {
+                arkime_packet_ring_push(batch, t, producer);
+                continue;
+            }
             ARKIME_LOCK(packetThreadData[t].packetQ.lock);
             DLL_PUSH_TAIL_DLL(packet_, &packetThreadData[t].packetQ, &batch->packetQ[t]);
             ARKIME_COND_SIGNAL(packetThreadData[t].packetQ.lock);
@@ -1761,7 +2298,7 @@ process_packet:
 
     batch->totalBytes += packet->pktlen;
 
-    if (unlikely(DLL_COUNT(packet_, &packetThreadData[thread].packetQ) >= config.maxPacketsInQueue)) {
+    if (unlikely(arkime_packet_queued(thread) >= (int)config.maxPacketsInQueue)) {
         ARKIME_LOCK(packetThreadData[thread].packetQ.lock);
         packetThreadData[thread].overloadDrops++;
         if ((packetThreadData[thread].overloadDrops % 10000) == 1 && (packetThreadData[thread].overloadDropTimes + 60) < packet->ts.tv_sec) {
@@ -1775,11 +2312,9 @@ process_packet:
         return;
     }
 
-    if (likely(!packet->copied)) {
-        uint8_t *pkt = malloc(packet->pktlen);
-        memcpy(pkt, packet->pkt, packet->pktlen);
-        packet->pkt = pkt;
-        packet->copied = 1;
+    // Packets in a reader block are only copied if a packet thread needs to hold them
+    if (likely(!packet->copied) && !packet->block) {
+        arkime_packet_copy(packet);
     }
 
 #ifdef FUZZLOCH
@@ -1815,27 +2350,12 @@ int arkime_packet_outstanding()
     int count = 0;
 
     for (int t = 0; t < config.packetThreads; t++) {
-        count += DLL_COUNT(packet_, &packetThreadData[t].packetQ);
+        count += arkime_packet_queued(t);
         count += ARKIME_THREAD_ATOMIC_LOAD_RELAXED(packetThreadData[t].inProgress);
     }
     return count;
 }
 /******************************************************************************/
-SUPPRESS_UNSIGNED_INTEGER_OVERFLOW
-LOCAL uint32_t arkime_packet_frag_hash(const void *key)
-{
-    uint32_t n = 0;
-    for (int i = 0; i < 10; i++) {
-        n = (n << 5) - n + ((uint8_t *)key)[i];
-    }
-    return n;
-}
-/******************************************************************************/
-LOCAL int arkime_packet_frag_cmp(const void *keyv, const ArkimeFrags_t *element)
-{
-    return memcmp(keyv, element->key, 10) == 0;
-}
-/******************************************************************************/
 LOCAL gboolean arkime_packet_save_drophash(gpointer UNUSED(user_data))
 {
     if (packetDrop4.changed)
@@ -1990,6 +2510,7 @@ void arkime_packet_init()
     arkimeCounters.nextLogPackets = config.logEveryXPackets;
 
     disableIp4Defrag = arkime_config_boolean(NULL, "disableIp4Defrag", FALSE);
+    disableIp6Defrag = arkime_config_boolean(NULL, "disableIp6Defrag", FALSE);
     trimEthernetPadding = arkime_config_boolean(NULL, "trimEthernetPadding", FALSE);
 
     pcapFileHeader.magic = 0xa1b2c3d4;
@@ -2302,6 +2823,15 @@ void arkime_packet_init()
                         0,  ARKIME_FIELD_FLAG_FAKE,
                         (char *)NULL);
 
+    packetBatchSize = arkime_config_int(NULL, "packetBatchSize", 1, 1, ARKIME_PACKET_BATCH_MAX);
+
+    packetRingSize = arkime_config_int(NULL, "packetRingSize", 0, 0, 0x100000);
+    if (packetRingSize) {
+        packetRingSize = MAX(1024, arkime_get_next_powerof2(packetRingSize));
+    }
+
+    packetThreadData = arkime_numa_alloc0("packetThreadData", sizeof(PacketThreadData_t), config.packetThreads);
+
     for (int t = 0; t < config.packetThreads; t++) {
         char name[100];
         DLL_INIT(packet_, &packetThreadData[t].packetQ);
@@ -2313,8 +2843,8 @@ void arkime_packet_init()
 #endif
     }
 
-    HASH_INIT(fragh_, fragsHash, arkime_packet_frag_hash, (HASH_CMP_FUNC)arkime_packet_frag_cmp);
-    DLL_INIT(fragl_, &fragsList);
+    arkime_packet_frags_table_init(&frags4);
+    arkime_packet_frags_table_init(&frags6);
 
     arkime_add_can_quit(arkime_packet_outstanding, "packet outstanding");
     arkime_add_can_quit(arkime_packet_frags_outstanding, "packet frags outstanding");
@@ -2326,6 +2856,7 @@ void arkime_packet_init()
     arkime_packet_set_ethernet_cb(ETHERTYPE_IPV6, arkime_packet_ip6);
 
     arkime_command_register("packet-stats", arkime_packet_cmd_stats, "Packet Stats");
+    arkime_command_register("packet-sessionid-bench", arkime_packet_cmd_sessionid_bench, "Benchmark rebuilding vs carrying tcp session ids - packet-sessionid-bench [<packets>]");
 }
 /******************************************************************************/
 uint64_t arkime_packet_dropped_packets()
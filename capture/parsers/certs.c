@@ -561,7 +561,7 @@ LOCAL int certinfo_process_single_cert(ArkimeSession_t *session, const uint8_t *
     }
 
     // no previous certs AND not a CA AND either no orgName or the same orgName AND the same 1 commonName
-    if (!session->fields[certsField] &&
+    if (!arkime_field_get(session, certsField) &&
         !certs->isCA &&
         ((certs->subject.orgName.s_count == 1 && certs->issuer.orgName.s_count == 1 && strcmp(certs->subject.orgName.s_next->str, certs->issuer.orgName.s_next->str) == 0) ||
          (certs->subject.orgName.s_count == 0 && certs->issuer.orgName.s_count == 0)) &&
@@ -642,10 +642,11 @@ void arkime_field_certsinfo_update_extra (void *cert, char *key, char *value)
 /******************************************************************************/
 GPtrArray *arkime_field_certsinfo_get_extra(const ArkimeSession_t *session, const char *key)
 {
-    if (!session->fields[certsField])
+    const ArkimeField_t *field = arkime_field_get(session, certsField);
+    if (!field)
         return NULL;
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[certsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     GPtrArray *array = NULL;
@@ -668,11 +669,12 @@ GPtrArray *arkime_field_certsinfo_get_extra(const ArkimeSession_t *session, cons
 /******************************************************************************/
 LOCAL void *certs_getcb_alt(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[certsField])
+    const ArkimeField_t *field = arkime_field_get(session, certsField);
+    if (!field)
         return NULL;
 
     ArkimeString_t *string;
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[certsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     const ArkimeFieldObject_t *object;
 
     GPtrArray *array = g_ptr_array_new();
@@ -794,8 +794,9 @@ LOCAL void dns_parser(ArkimeSession_t *session, int kind, const uint8_t *data, i
     ArkimeFieldObject_t *fobject = NULL;;
     DNS_t *dns = NULL;
 
-    if (session->fields[dnsField] && session->fields[dnsField]->ohash) {
-        HASH_FIND(o_, *(session->fields[dnsField]->ohash), &key, fobject);
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (field && field->ohash) {
+        HASH_FIND(o_, *(field->ohash), &key, fobject);
     }
 
     jsonLen = DEFAULT_JSON_LEN;
@@ -1387,7 +1388,7 @@ continueerr:
 
     dns->headerFlags = (data[2] & 0x07) << 4 | ((data[3] & 0xf0) >> 4);
 
-    session->fields[dnsField]->jsonSize += jsonLen;
+    arkime_field_get(session, dnsField)->jsonSize += jsonLen;
 }
 /******************************************************************************/
 LOCAL int dns_tcp_parser(ArkimeSession_t *session, void *uw, const uint8_t *data, int len, int which)
@@ -1942,12 +1943,13 @@ LOCAL int dns_cmp(const void *keyv, const void *elementv)
 /******************************************************************************/
 LOCAL void *dns_getcb_host(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -1965,12 +1967,13 @@ LOCAL void *dns_getcb_host(const ArkimeSession_t *session, int UNUSED(pos))
 /******************************************************************************/
 LOCAL void *dns_getcb_host_mailserver(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -1989,12 +1992,13 @@ LOCAL void *dns_getcb_host_mailserver(const ArkimeSession_t *session, int UNUSED
 /******************************************************************************/
 LOCAL void *dns_getcb_host_nameserver(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -2013,12 +2017,13 @@ LOCAL void *dns_getcb_host_nameserver(const ArkimeSession_t *session, int UNUSED
 /******************************************************************************/
 LOCAL void *dns_getcb_puny(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -2037,12 +2042,13 @@ LOCAL void *dns_getcb_puny(const ArkimeSession_t *session, int UNUSED(pos))
 /******************************************************************************/
 LOCAL void *dns_getcb_status(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -2057,12 +2063,13 @@ LOCAL void *dns_getcb_status(const ArkimeSession_t *session, int UNUSED(pos))
 /******************************************************************************/
 LOCAL void *dns_getcb_opcode(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -2077,12 +2084,13 @@ LOCAL void *dns_getcb_opcode(const ArkimeSession_t *session, int UNUSED(pos))
 /******************************************************************************/
 LOCAL void *dns_getcb_query_type(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -2097,12 +2105,13 @@ LOCAL void *dns_getcb_query_type(const ArkimeSession_t *session, int UNUSED(pos)
 /******************************************************************************/
 LOCAL void *dns_getcb_query_class(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -2117,12 +2126,13 @@ LOCAL void *dns_getcb_query_class(const ArkimeSession_t *session, int UNUSED(pos
 /******************************************************************************/
 LOCAL void *dns_getcb_query_host(const ArkimeSession_t *session, int UNUSED(pos))
 {
-    if (!session->fields[dnsField])
+    const ArkimeField_t *field = arkime_field_get(session, dnsField);
+    if (!field)
         return NULL;
 
     GHashTable *hash = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, NULL);
 
-    const ArkimeFieldObjectHashStd_t *ohash = session->fields[dnsField]->ohash;
+    const ArkimeFieldObjectHashStd_t *ohash = field->ohash;
     ArkimeFieldObject_t *object;
 
     HASH_FORALL2(o_, *ohash, object) {
@@ -30,8 +30,17 @@ extern int                   tcpMProtocol;
 LOCAL int                    maxTcpOutOfOrderPackets;
 extern uint32_t              pluginsCbs;
 LOCAL int                    tcp_raw_packet_func;
-
-void arkime_packet_free(ArkimePacket_t *packet);
+LOCAL ArkimePool_t          *tcpDataPool;
+
+// Only updated by the packet thread that owns the sessions
+typedef struct {
+    uint64_t                 bytes;         // Payload bytes waiting for reassembly
+    uint64_t                 maxBytes;
+    uint64_t                 segments;
+    uint64_t                 queued;
+    uint64_t                 merged;        // Queued by appending to the segment before
+} ARKIME_CACHE_ALIGN ArkimeTcpStats_t;
+LOCAL ArkimeTcpStats_t      *tcpStats;
 
 LOCAL int tcpflagsSynField;
 LOCAL int tcpflagsSynAckField;
@@ -59,23 +68,80 @@ LOCAL void tcp_mid_save(ArkimeSession_t *session)
     memset(session->tcpData.tcpFlagCnt, 0, sizeof(session->tcpData.tcpFlagCnt));
 }
 /******************************************************************************/
+/* Out of order segments only keep a copy of their payload so the packet, and
+ * any reader block it points into, is released right away.  In order data
+ * never gets here, it is processed straight from the packet.
+ */
+LOCAL ArkimeTcpData_t *tcp_data_alloc(ArkimeSession_t *session, const uint8_t *data, int len)
+{
+    ArkimeTcpData_t *td = arkime_pool_alloc(tcpDataPool);
+    td->data = ARKIME_SIZE_ALLOC("tcp data", len);
+    memcpy(td->data, data, len);
+    td->len = len;
+    td->size = len;
+    td->packets = 1;
+    session->tcpData.tdPackets++;
+
+    ArkimeTcpStats_t *stats = &tcpStats[session->thread];
+    stats->bytes += len;
+    if (stats->bytes > stats->maxBytes)
+        stats->maxBytes = stats->bytes;
+    stats->segments++;
+    stats->queued++;
+    return td;
+}
+/******************************************************************************/
+// Append a contiguous segment, returns FALSE if it doesn't fit
+LOCAL gboolean tcp_data_append(ArkimeSession_t *session, ArkimeTcpData_t *td, const uint8_t *data, int len)
+{
+    if (td->len + len > 0xffff || td->packets == 0xffff)
+        return FALSE;
+
+    if (td->len + len > td->size) {
+        const int size = MIN(MAX(td->size * 2, td->len + len), 0xffff);
+        ARKIME_SIZE_REALLOC("tcp data", td->data, size);
+        td->size = size;
+    }
+    memcpy(td->data + td->len, data, len);
+    td->len += len;
+    td->packets++;
+    session->tcpData.tdPackets++;
+
+    ArkimeTcpStats_t *stats = &tcpStats[session->thread];
+    stats->bytes += len;
+    if (stats->bytes > stats->maxBytes)
+        stats->maxBytes = stats->bytes;
+    stats->queued++;
+    stats->merged++;
+    return TRUE;
+}
+/******************************************************************************/
+LOCAL void tcp_data_free(ArkimeSession_t *session, ArkimeTcpData_t *td)
+{
+    session->tcpData.tdPackets -= td->packets;
+
+    ArkimeTcpStats_t *stats = &tcpStats[session->thread];
+    stats->bytes -= td->len;
+    stats->segments--;
+
+    ARKIME_SIZE_FREE("tcp data", td->data);
+    arkime_pool_free(tcpDataPool, td);
+}
+/******************************************************************************/
 LOCAL void tcp_session_free(ArkimeSession_t *session)
 {
     if (session->tcpData.td_count == 1 && session->tcpData.tcpFlagCnt[ARKIME_TCPFLAG_PSH] == 1) {
         ArkimeTcpData_t *ftd = DLL_PEEK_HEAD(td_, &session->tcpData);
-        const int which = ftd->packet->direction;
-        const uint8_t *data = ftd->packet->pkt + ftd->dataOffset;
-        const int len = ftd->len;
 
-        arkime_parsers_classify_tcp(session, data, len, which);
-        arkime_packet_process_data(session, data, len, which);
+        arkime_parsers_classify_tcp(session, ftd->data, ftd->len, ftd->which);
+        arkime_packet_process_data(session, ftd->data, ftd->len, ftd->which);
     }
 
     ArkimeTcpData_t *td;
     while (DLL_POP_HEAD(td_, &session->tcpData, td)) {
-        arkime_packet_free(td->packet);
-        ARKIME_TYPE_FREE(ArkimeTcpData_t, td);
+        tcp_data_free(session, td);
     }
+    session->tcpData.tdPackets = 0;
 }
 
 /******************************************************************************/
@@ -91,6 +157,32 @@ LOCAL int64_t tcp_sequence_diff(int64_t a, int64_t b)
     return b - a;
 }
 /******************************************************************************/
+// Hand the next in order bytes of a direction to the parsers
+LOCAL void tcp_data_process(ArkimeSession_t *session, const uint8_t *data, int len, int which)
+{
+    if (session->firstBytesLen[which] < 8) {
+        int copy = MIN(8 - session->firstBytesLen[which], len);
+        memcpy(session->firstBytes[which] + session->firstBytesLen[which], data, copy);
+        session->firstBytesLen[which] += copy;
+    }
+
+    if (session->totalDatabytes[which] == session->consumed[which]) {
+        arkime_parsers_classify_tcp(session, data, len, which);
+    }
+
+    arkime_packet_process_data(session, data, len, which);
+    session->tcpData.tcpSeq[which] += len;
+    session->databytes[which] += len;
+    session->totalDatabytes[which] += len;
+
+    if (config.yara && config.yaraEveryPacket && !session->stopYara) {
+        arkime_yara_execute(session, data, len, 0);
+    }
+
+    if (pluginsCbs & ARKIME_PLUGIN_TCP)
+        arkime_plugins_cb_tcp(session, data, len, which);
+}
+/******************************************************************************/
 LOCAL void tcp_packet_finish(ArkimeSession_t *session)
 {
     ArkimeTcpData_t            *ftd;
@@ -101,12 +193,12 @@ LOCAL void tcp_packet_finish(ArkimeSession_t *session)
 #ifdef DEBUG_TCP
     LOG("START %u %u", session->tcpData.tcpSeq[0], session->tcpData.tcpSeq[1]);
     DLL_FOREACH(td_, tcpData, ftd) {
-        LOG("dir: %u seq: %8u ack: %8u len: %4u", ftd->packet->direction, ftd->seq, ftd->ack, ftd->len);
+        LOG("dir: %u seq: %8u ack: %8u len: %4u", ftd->which, ftd->seq, ftd->ack, ftd->len);
     }
 #endif
 
     DLL_FOREACH_REMOVABLE(td_, tcpData, ftd, next) {
-        const int which = ftd->packet->direction;
+        const int which = ftd->which;
         const uint32_t tcpSeq = session->tcpData.tcpSeq[which];
 
         /* The sequence number we are looking for is past the start of the packet */
@@ -115,8 +207,7 @@ LOCAL void tcp_packet_finish(ArkimeSession_t *session)
             /* The sequence number we are looking for is past the end of the packet, free it */
             if (tcp_sequence_diff(tcpSeq, (uint32_t)(ftd->seq + ftd->len)) <= 0) {
                 DLL_REMOVE(td_, tcpData, ftd);
-                arkime_packet_free(ftd->packet);
-                ARKIME_TYPE_FREE(ArkimeTcpData_t, ftd);
+                tcp_data_free(session, ftd);
                 continue;
             }
 
@@ -130,42 +221,31 @@ LOCAL void tcp_packet_finish(ArkimeSession_t *session)
 
             /* This packet has the sequence number we are looking for */
             const int offset = (int)offsetDiff;
-            const uint8_t *data = ftd->packet->pkt + ftd->dataOffset + offset;
-            const int len = ftd->len - offset;
-
-            if (session->firstBytesLen[which] < 8) {
-                int copy = MIN(8 - session->firstBytesLen[which], len);
-                memcpy(session->firstBytes[which] + session->firstBytesLen[which], data, copy);
-                session->firstBytesLen[which] += copy;
-            }
-
-            if (session->totalDatabytes[which] == session->consumed[which]) {
-                arkime_parsers_classify_tcp(session, data, len, which);
-            }
-
-            arkime_packet_process_data(session, data, len, which);
-            session->tcpData.tcpSeq[which] += len;
-            session->databytes[which] += len;
-            session->totalDatabytes[which] += len;
-
-            if (config.yara && config.yaraEveryPacket && !session->stopYara) {
-                arkime_yara_execute(session, data, len, 0);
-            }
-
-            if (pluginsCbs & ARKIME_PLUGIN_TCP)
-                arkime_plugins_cb_tcp(session, data, len, which);
+            tcp_data_process(session, ftd->data + offset, ftd->len - offset, which);
 
             DLL_REMOVE(td_, tcpData, ftd);
-            arkime_packet_free(ftd->packet);
-            ARKIME_TYPE_FREE(ArkimeTcpData_t, ftd);
+            tcp_data_free(session, ftd);
         } else {
             return;
         }
     }
 }
 /******************************************************************************/
+// Called when data has to wait behind other data
+LOCAL void tcp_out_of_order(ArkimeSession_t *session, int which)
+{
+    if (session->haveTcpSession && (session->outOfOrder & (1 << which)) == 0) {
+        static const char *tags[2] = {"out-of-order-src", "out-of-order-dst"};
+        arkime_session_add_tag(session, tags[which]);
+        session->outOfOrder |= (1 << which);
+    }
+}
+/******************************************************************************/
+/* In order data with nothing queued ahead of it isn't copied, it is returned
+ * in inOrder/inOrderLen for tcp_process to hand to the parsers.
+ */
 SUPPRESS_ALIGNMENT
-LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *const packet)
+LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *const packet, const uint8_t **inOrder, int *inOrderLen)
 {
     struct tcphdr       *tcphdr = (struct tcphdr *)(packet->pkt + packet->payloadOffset);
 
@@ -363,7 +443,7 @@ LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *con
 
     ArkimeTcpDataHead_t *const tcpData = &session->tcpData;
 
-    if (DLL_COUNT(td_, tcpData) > maxTcpOutOfOrderPackets) {
+    if (tcpData->tdPackets > (uint32_t)maxTcpOutOfOrderPackets) {
         tcp_session_free(session);
         arkime_session_add_tag(session, "incomplete-tcp");
         session->stopTCP = 1;
@@ -405,25 +485,49 @@ LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *con
     if (session->haveTcpSession && diff <= 0)
         return 1;
 
-    ArkimeTcpData_t *ftd, *td = ARKIME_TYPE_ALLOC(ArkimeTcpData_t);
+    const uint8_t *data = packet->pkt + packet->payloadOffset + 4 * tcphdr->th_off;
     const uint32_t ack = ntohl(tcphdr->th_ack);
-
-    td->packet = packet;
-    td->ack = ack;
-    td->seq = seq;
-    td->len = len;
-    td->dataOffset = packet->payloadOffset + 4 * tcphdr->th_off;
+    ArkimeTcpData_t *ftd, *td;
 
 #ifdef DEBUG_TCP
     LOG("dir: %u seq: %u ack: %u len: %d diff0: %" PRId64, packet->direction, seq, ack, len, diff);
 #endif
 
+    if (DLL_COUNT(td_, tcpData) == 0) {
+        const uint32_t tcpSeq = session->tcpData.tcpSeq[packet->direction];
+        if (tcpSeq >= seq) {
+            // Already have all of it
+            if (tcp_sequence_diff(tcpSeq, seq + len) <= 0)
+                return 1;
+
+            const int64_t offset = tcp_sequence_diff(seq, tcpSeq);
+            if (offset >= 0 && offset < len) {
+                *inOrder = data + offset;
+                *inOrderLen = len - (int)offset;
+                return 1;
+            }
+        }
+    }
+
+    // Usually the next segment in the same direction, just grow the last one
+    ftd = DLL_PEEK_TAIL(td_, tcpData);
+    if (ftd && ftd->which == packet->direction && ftd->ack == ack && (uint32_t)(ftd->seq + ftd->len) == seq &&
+        tcp_data_append(session, ftd, data, len)) {
+        tcp_out_of_order(session, packet->direction);
+        return 1;
+    }
+
+    td = tcp_data_alloc(session, data, len);
+    td->ack = ack;
+    td->seq = seq;
+    td->which = packet->direction;
+
     if (DLL_COUNT(td_, tcpData) == 0) {
         DLL_PUSH_TAIL(td_, tcpData, td);
     } else {
         uint32_t sortA, sortB;
         DLL_FOREACH_REVERSE(td_, tcpData, ftd) {
-            if (packet->direction == ftd->packet->direction) {
+            if (packet->direction == ftd->which) {
                 sortA = seq;
                 sortB = ftd->seq;
             } else {
@@ -433,16 +537,15 @@ LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *con
 
             diff = tcp_sequence_diff(sortB, sortA);
             if (diff == 0) {
-                if (packet->direction == ftd->packet->direction) {
+                if (packet->direction == ftd->which) {
                     if (td->len > ftd->len) {
                         DLL_ADD_AFTER(td_, tcpData, ftd, td);
 
                         DLL_REMOVE(td_, tcpData, ftd);
-                        arkime_packet_free(ftd->packet);
-                        ARKIME_TYPE_FREE(ArkimeTcpData_t, ftd);
+                        tcp_data_free(session, ftd);
                         ftd = td;
                     } else {
-                        ARKIME_TYPE_FREE(ArkimeTcpData_t, td);
+                        tcp_data_free(session, td);
                         return 1;
                     }
                     break;
@@ -451,6 +554,11 @@ LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *con
                     break;
                 }
             } else if (diff > 0) {
+                // Already have all of it, a retransmit of something that was appended
+                if (packet->direction == ftd->which && tcp_sequence_diff(seq + len, ftd->seq + ftd->len) >= 0) {
+                    tcp_data_free(session, td);
+                    return 1;
+                }
                 DLL_ADD_AFTER(td_, tcpData, ftd, td);
                 break;
             }
@@ -460,14 +568,10 @@ LOCAL int tcp_packet_process(ArkimeSession_t *const session, ArkimePacket_t *con
             DLL_PUSH_HEAD(td_, tcpData, td);
         }
 
-        if (session->haveTcpSession && (session->outOfOrder & (1 << packet->direction)) == 0) {
-            static const char *tags[2] = {"out-of-order-src", "out-of-order-dst"};
-            arkime_session_add_tag(session, tags[packet->direction]);
-            session->outOfOrder |= (1 << packet->direction);
-        }
+        tcp_out_of_order(session, packet->direction);
     }
 
-    return 0;
+    return 1;
 }
 
 /******************************************************************************/
@@ -514,6 +618,7 @@ LOCAL int tcp_pre_process(ArkimeSession_t *session, ArkimePacket_t *const packet
 
     if (isNewSession) {
         DLL_INIT(td_, &session->tcpData);
+        session->tcpData.tdPackets = 0;
 
         /* if the syn-ack was captured first then the syn probably got dropped.*/
         if ((tcphdr->th_flags & TH_SYN) && (tcphdr->th_flags & TH_ACK)) {
@@ -556,18 +661,44 @@ LOCAL int tcp_pre_process(ArkimeSession_t *session, ArkimePacket_t *const packet
 /******************************************************************************/
 LOCAL int tcp_process(ArkimeSession_t *session, ArkimePacket_t *const packet)
 {
-    int freePacket = tcp_packet_process(session, packet);
+    const uint8_t *inOrder = NULL;
+    int            inOrderLen = 0;
+
+    int freePacket = tcp_packet_process(session, packet, &inOrder, &inOrderLen);
     if (ARKIME_PARSERS_HAS_NAMED_FUNC(tcp_raw_packet_func)) {
         arkime_parsers_call_named_func(tcp_raw_packet_func, session, NULL, 0, packet);
     }
-    tcp_packet_finish(session);
+    if (inOrder) {
+        tcp_data_process(session, inOrder, inOrderLen, packet->direction);
+    } else {
+        tcp_packet_finish(session);
+    }
     return freePacket;
 }
 /******************************************************************************/
+LOCAL void tcp_cmd_stats(int UNUSED(argc), char **UNUSED(argv), gpointer cc)
+{
+    char output[10000];
+    BSB bsb;
+    BSB_INIT(bsb, output, sizeof(output));
+
+    BSB_EXPORT_sprintf(bsb, "%-6s %14s %14s %10s %14s %14s\n", "Thread", "Bytes", "Max Bytes", "Segments", "Queued", "Merged");
+    for (int t = 0; t < config.packetThreads; t++) {
+        const ArkimeTcpStats_t *stats = &tcpStats[t];
+        BSB_EXPORT_sprintf(bsb, "%-6d %14" PRIu64 " %14" PRIu64 " %10" PRIu64 " %14" PRIu64 " %14" PRIu64 "\n",
+                           t, stats->bytes, stats->maxBytes, stats->segments, stats->queued, stats->merged);
+    }
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+}
+/******************************************************************************/
 void arkime_parser_init()
 {
     maxTcpOutOfOrderPackets = arkime_config_int(NULL, "maxTcpOutOfOrderPackets", 256, 64, 10000);
     tcp_raw_packet_func = arkime_parsers_get_named_func("tcp_raw_packet");
+    tcpDataPool = arkime_pool_create("tcpData", sizeof(ArkimeTcpData_t));
+    tcpStats = arkime_numa_alloc0("tcpStats", sizeof(ArkimeTcpStats_t), config.packetThreads);
+    arkime_command_register("tcp-stats", tcp_cmd_stats, "TCP reassembly memory per packet thread");
 
     tcpMProtocol = arkime_mprotocol_register("tcp",
                                              SESSION_TCP,
@@ -55,8 +55,76 @@ typedef struct {
 } ArkimeExtensions_t;
 LOCAL GPtrArray *extensionsArr;
 
+/* The per session and per packet hooks call from flat NULL terminated arrays
+ * of just the registered callbacks instead of walking every plugin.  The
+ * arrays are rebuilt as one block whenever callbacks change and swapped in
+ * with an atomic store, the old block is freed later.
+ */
+typedef struct {
+    ArkimePluginUdpFunc         *udp;
+    ArkimePluginTcpFunc         *tcp;
+    ArkimePluginSaveFunc        *preSave;
+    ArkimePluginSaveFunc        *save;
+    ArkimePluginNewFunc         *newSession;
+    ArkimePluginHttpFunc        *hpOmb;
+    ArkimePluginHttpDataFunc    *hpOu;
+    ArkimePluginHttpDataFunc    *hpOhf;
+    ArkimePluginHttpDataFunc    *hpOhfr;
+    ArkimePluginHttpDataFunc    *hpOhv;
+    ArkimePluginHttpFunc        *hpOhc;
+    ArkimePluginHttpDataFunc    *hpOb;
+    ArkimePluginHttpFunc        *hpOmc;
+    ArkimePluginSMTPHeaderFunc  *smtpOh;
+    ArkimePluginSMTPFunc        *smtpOhc;
+} ArkimePluginsDispatch_t;
+#define ARKIME_PLUGINS_DISPATCH_HOOKS (sizeof(ArkimePluginsDispatch_t) / sizeof(void *))
+
+LOCAL ArkimePluginsDispatch_t *dispatch;
+
 LOCAL uint32_t arkime_plugins_outstanding();
 /******************************************************************************/
+#define PLUGINS_DISPATCH_FILL(array, member) \
+    do { \
+        d->array = (void *)funcs; \
+        int _n = 0; \
+        HASH_FORALL2(p_, plugins, plugin) { \
+            if (plugin->member) \
+                d->array[_n++] = plugin->member; \
+        } \
+        d->array[_n] = NULL; \
+        funcs += num + 1; \
+    } while (0)
+
+LOCAL void arkime_plugins_dispatch_build()
+{
+    ArkimePlugin_t *plugin;
+    const int       num = HASH_COUNT(p_, plugins);
+
+    ArkimePluginsDispatch_t *d = ARKIME_SIZE_ALLOC("plugins dispatch", sizeof(ArkimePluginsDispatch_t) +
+                                                   ARKIME_PLUGINS_DISPATCH_HOOKS * (num + 1) * sizeof(void (*)(void)));
+    void (**funcs)(void) = (void (**)(void))(d + 1);
+
+    PLUGINS_DISPATCH_FILL(udp, udpFunc);
+    PLUGINS_DISPATCH_FILL(tcp, tcpFunc);
+    PLUGINS_DISPATCH_FILL(preSave, preSaveFunc);
+    PLUGINS_DISPATCH_FILL(save, saveFunc);
+    PLUGINS_DISPATCH_FILL(newSession, newFunc);
+    PLUGINS_DISPATCH_FILL(hpOmb, on_message_begin);
+    PLUGINS_DISPATCH_FILL(hpOu, on_url);
+    PLUGINS_DISPATCH_FILL(hpOhf, on_header_field);
+    PLUGINS_DISPATCH_FILL(hpOhfr, on_header_field_raw);
+    PLUGINS_DISPATCH_FILL(hpOhv, on_header_value);
+    PLUGINS_DISPATCH_FILL(hpOhc, on_headers_complete);
+    PLUGINS_DISPATCH_FILL(hpOb, on_body);
+    PLUGINS_DISPATCH_FILL(hpOmc, on_message_complete);
+    PLUGINS_DISPATCH_FILL(smtpOh, smtp_on_header);
+    PLUGINS_DISPATCH_FILL(smtpOhc, smtp_on_header_complete);
+
+    ArkimePluginsDispatch_t *old = dispatch;
+    ARKIME_THREAD_ATOMIC_STORE(dispatch, d);
+    arkime_free_later(old, free);
+}
+/******************************************************************************/
 LOCAL void arkime_plugins_cmd_list(int UNUSED(argc), char UNUSED( * *argv), gpointer cc)
 {
     char buf[10000];
@@ -255,6 +323,8 @@ void arkime_plugins_set_cb(const char             *name,
     plugin->reloadFunc = reloadFunc;
     if (reloadFunc)
         pluginsCbs |= ARKIME_PLUGIN_RELOAD;
+
+    arkime_plugins_dispatch_build();
 }
 /******************************************************************************/
 void arkime_plugins_set_http_cb(const char              *name,
@@ -327,6 +397,7 @@ void arkime_plugins_set_http_ext_cb(const char              *name,
     if (on_message_complete)
         pluginsCbs |= ARKIME_PLUGIN_HP_OMC;
 
+    arkime_plugins_dispatch_build();
 }
 /******************************************************************************/
 void arkime_plugins_set_smtp_cb(const char                 *name,
@@ -348,6 +419,8 @@ void arkime_plugins_set_smtp_cb(const char                 *name,
     plugin->smtp_on_header_complete = on_header_complete;
     if (on_header_complete)
         pluginsCbs |= ARKIME_PLUGIN_SMTP_OHC;
+
+    arkime_plugins_dispatch_build();
 }
 /******************************************************************************/
 void arkime_plugins_set_outstanding_cb(const char                 *name,
@@ -366,152 +439,122 @@ void arkime_plugins_set_outstanding_cb(const char                 *name,
 /******************************************************************************/
 void arkime_plugins_cb_pre_save(ArkimeSession_t *session, int final)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->preSaveFunc)
-            plugin->preSaveFunc(session, final);
-    }
+    for (const ArkimePluginSaveFunc *func = d->preSave; *func; func++)
+        (*func)(session, final);
 }
 /******************************************************************************/
 void arkime_plugins_cb_save(ArkimeSession_t *session, int final)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->saveFunc)
-            plugin->saveFunc(session, final);
-    }
+    for (const ArkimePluginSaveFunc *func = d->save; *func; func++)
+        (*func)(session, final);
 }
 /******************************************************************************/
 void arkime_plugins_cb_new(ArkimeSession_t *session)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->newFunc)
-            plugin->newFunc(session);
-    }
+    for (const ArkimePluginNewFunc *func = d->newSession; *func; func++)
+        (*func)(session);
 }
 /******************************************************************************/
 void arkime_plugins_cb_tcp(ArkimeSession_t *session, const uint8_t *data, int len, int which)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->tcpFunc)
-            plugin->tcpFunc(session, data, len, which);
-    }
+    for (const ArkimePluginTcpFunc *func = d->tcp; *func; func++)
+        (*func)(session, data, len, which);
 }
 /******************************************************************************/
 void arkime_plugins_cb_udp(ArkimeSession_t *session, const uint8_t *data, int len, int which)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->udpFunc)
-            plugin->udpFunc(session, data, len, which);
-    }
+    for (const ArkimePluginUdpFunc *func = d->udp; *func; func++)
+        (*func)(session, data, len, which);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_omb(ArkimeSession_t *session, http_parser *parser)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_message_begin)
-            plugin->on_message_begin(session, parser);
-    }
+    for (const ArkimePluginHttpFunc *func = d->hpOmb; *func; func++)
+        (*func)(session, parser);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_ou(ArkimeSession_t *session, http_parser *parser, const char *at, size_t length)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_url)
-            plugin->on_url(session, parser, at, length);
-    }
+    for (const ArkimePluginHttpDataFunc *func = d->hpOu; *func; func++)
+        (*func)(session, parser, at, length);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_ohf(ArkimeSession_t *session, http_parser *parser, const char *at, size_t length)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_header_field)
-            plugin->on_header_field(session, parser, at, length);
-    }
+    for (const ArkimePluginHttpDataFunc *func = d->hpOhf; *func; func++)
+        (*func)(session, parser, at, length);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_ohfr(ArkimeSession_t *session, http_parser *parser, const char *at, size_t length)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_header_field_raw)
-            plugin->on_header_field_raw(session, parser, at, length);
-    }
+    for (const ArkimePluginHttpDataFunc *func = d->hpOhfr; *func; func++)
+        (*func)(session, parser, at, length);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_ohv(ArkimeSession_t *session, http_parser *parser, const char *at, size_t length)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_header_value)
-            plugin->on_header_value(session, parser, at, length);
-    }
+    for (const ArkimePluginHttpDataFunc *func = d->hpOhv; *func; func++)
+        (*func)(session, parser, at, length);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_ohc(ArkimeSession_t *session, http_parser *parser)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_headers_complete)
-            plugin->on_headers_complete(session, parser);
-    }
+    for (const ArkimePluginHttpFunc *func = d->hpOhc; *func; func++)
+        (*func)(session, parser);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_ob(ArkimeSession_t *session, http_parser *parser, const char *at, size_t length)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_body)
-            plugin->on_body(session, parser, at, length);
-    }
+    for (const ArkimePluginHttpDataFunc *func = d->hpOb; *func; func++)
+        (*func)(session, parser, at, length);
 }
 /******************************************************************************/
 void arkime_plugins_cb_hp_omc(ArkimeSession_t *session, http_parser *parser)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->on_message_complete)
-            plugin->on_message_complete(session, parser);
-    }
+    for (const ArkimePluginHttpFunc *func = d->hpOmc; *func; func++)
+        (*func)(session, parser);
 }
 /******************************************************************************/
 void arkime_plugins_cb_smtp_oh(ArkimeSession_t *session, const char *field, size_t field_len, const char *value, size_t value_len)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->smtp_on_header)
-            plugin->smtp_on_header(session, field, field_len, value, value_len);
-    }
+    for (const ArkimePluginSMTPHeaderFunc *func = d->smtpOh; *func; func++)
+        (*func)(session, field, field_len, value, value_len);
 }
 /******************************************************************************/
 void arkime_plugins_cb_smtp_ohc(ArkimeSession_t *session)
 {
-    ArkimePlugin_t *plugin;
+    const ArkimePluginsDispatch_t *d = ARKIME_THREAD_ATOMIC_LOAD(dispatch);
 
-    HASH_FORALL2(p_, plugins, plugin) {
-        if (plugin->smtp_on_header_complete)
-            plugin->smtp_on_header_complete(session);
-    }
+    for (const ArkimePluginSMTPFunc *func = d->smtpOhc; *func; func++)
+        (*func)(session);
 }
 /******************************************************************************/
 void arkime_plugins_exit()
@@ -554,6 +597,7 @@ LOCAL uint32_t arkime_plugins_outstanding()
 void arkime_plugins_init()
 {
     HASH_INIT(p_, plugins, arkime_string_hash, arkime_string_cmp);
+    arkime_plugins_dispatch_build();
     arkime_command_register("plugins-list", arkime_plugins_cmd_list, "List loaded plugins");
     arkime_plugins_register_load_extension(".so", arkime_plugins_load_so);
 }
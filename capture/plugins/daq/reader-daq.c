@@ -74,6 +74,7 @@ LOCAL void *reader_daq_thread(gpointer posv)
             break;
         }
     }
+    arkime_packet_batch_free(&batch);
     return NULL;
 }
 /******************************************************************************/
@@ -27,7 +27,7 @@ LOCAL uint32_t entropyChunkSize;
 LOCAL uint32_t entropyMaxUniqueValues;
 
 #define ENTROPY_NUM_VALUES(session, which)                                                             \
-    ((session)->fields[entropy_field[which]] ? (session)->fields[entropy_field[which]]->iarray->len : 0)
+    (arkime_field_get(session, entropy_field[which]) ? arkime_field_get(session, entropy_field[which])->iarray->len : 0)
 
 /******************************************************************************/
 /* Generate a complete set of routines for a given count storage width.       */
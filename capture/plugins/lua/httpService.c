@@ -9,7 +9,6 @@
 
 
 extern lua_State *Ls[ARKIME_MAX_PACKET_THREADS];
-extern ArkimeSession_t moluaFakeSessions[ARKIME_MAX_PACKET_THREADS];
 
 typedef struct {
     long ref;
@@ -734,13 +734,13 @@ LOCAL int MS_get(lua_State *L)
         pos = arkime_field_by_exp(lua_tostring(L, 2));
     }
 
-    if (pos < 0 || pos >= session->maxFields || !session->fields[pos] || !config.fields[pos]) {
+    ArkimeField_t         *field = pos < 0 || pos >= config.maxDbField ? NULL : arkime_field_get(session, pos);
+    if (!field || !config.fields[pos]) {
         lua_pushnil(L);
         return 1;
     }
 
     guint                  i;
-    ArkimeField_t         *field = session->fields[pos];
     ArkimeString_t        *hstring;
     ArkimeInt_t           *hint;
     const ArkimeStringHashStd_t *shash;
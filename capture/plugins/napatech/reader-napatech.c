@@ -182,7 +182,7 @@ LOCAL void *reader_napatech_thread(gpointer streamv)
                         capLen, wireLen);
             }
 
-            ArkimePacket_t *packet = ARKIME_TYPE_ALLOC0(ArkimePacket_t);
+            ArkimePacket_t *packet = arkime_packet_alloc();
             packet->pkt       = l2;   /* zero-copy: pointer into segment buffer */
             packet->pktlen    = capLen;
             packet->readerPos = st->interfacePos;
@@ -210,6 +210,7 @@ LOCAL void *reader_napatech_thread(gpointer streamv)
     }
 
     arkime_packet_batch_flush(&batch);
+    arkime_packet_batch_free(&batch);
 
     int exitFunc = arkime_get_named_func("arkime_reader_thread_exit");
     arkime_call_named_func(exitFunc, threadNum, NULL);
@@ -44,7 +44,7 @@ typedef struct {
     int             bufCount;
 } ARKIME_CACHE_ALIGN NetflowThreadData_t;
 
-LOCAL NetflowThreadData_t netflowThreadData[ARKIME_MAX_PACKET_THREADS];
+LOCAL NetflowThreadData_t *netflowThreadData;
 
 /******************************************************************************/
 LOCAL void netflow_send(const int thread)
@@ -303,6 +303,7 @@ void arkime_plugin_init()
     }
     g_strfreev(dsts);
 
+    netflowThreadData = arkime_numa_alloc0("netflowThreadData", sizeof(NetflowThreadData_t), config.packetThreads);
     int thread;
     for (thread = 0; thread < config.packetThreads; thread++) {
         netflowThreadData[thread].bufCount = -1;
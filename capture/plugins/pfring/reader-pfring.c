@@ -74,6 +74,7 @@ LOCAL void *reader_pfring_thread(void *posv)
             break;
         }
     }
+    arkime_packet_batch_free(&batch);
     return NULL;
 }
 /******************************************************************************/
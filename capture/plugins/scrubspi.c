@@ -39,33 +39,33 @@ LOCAL void scrubspi_plugin_save(ArkimeSession_t *session, int UNUSED(final))
 
     for (s = 0; s < ssLen; s++) {
         const int pos = ss[s].pos;
-        if (!session->fields[pos])
+        ArkimeField_t *field = arkime_field_get(session, pos);
+        if (!field)
             continue;
 
-        const ArkimeFieldInfo_t *field = config.fields[pos];
-        switch (field->type) {
+        switch (config.fields[pos]->type) {
         case ARKIME_FIELD_TYPE_STR:
-            newstr = g_regex_replace(ss[s].search, session->fields[pos]->str, -1, 0, ss[s].replace, 0, NULL);
+            newstr = g_regex_replace(ss[s].search, field->str, -1, 0, ss[s].replace, 0, NULL);
             if (newstr) {
-                g_free(session->fields[pos]->str);
-                session->fields[pos]->str = newstr;
+                g_free(field->str);
+                field->str = newstr;
             }
             break;
         case ARKIME_FIELD_TYPE_STR_ARRAY:
-            for (i = 0; i < session->fields[pos]->sarray->len; i++) {
-                newstr = g_regex_replace(ss[s].search, g_ptr_array_index(session->fields[pos]->sarray, i), -1, 0, ss[s].replace, 0, NULL);
+            for (i = 0; i < field->sarray->len; i++) {
+                newstr = g_regex_replace(ss[s].search, g_ptr_array_index(field->sarray, i), -1, 0, ss[s].replace, 0, NULL);
                 if (newstr) {
-                    g_free(g_ptr_array_index(session->fields[pos]->sarray, i));
-                    g_ptr_array_index(session->fields[pos]->sarray, i) = newstr;
+                    g_free(g_ptr_array_index(field->sarray, i));
+                    g_ptr_array_index(field->sarray, i) = newstr;
                 }
             }
             break;
         case ARKIME_FIELD_TYPE_STR_HASH:
-            shash = session->fields[pos]->shash;
+            shash = field->shash;
             HASH_FORALL2(s_, *shash, hstring) {
                 newstr = g_regex_replace(ss[s].search, hstring->str, -1, 0, ss[s].replace, 0, NULL);
                 if (newstr) {
-                    g_free(hstring->str);
+                    arkime_field_string_free(session, hstring->str);
                     hstring->str = newstr;
                 }
             }
@@ -76,15 +76,15 @@ LOCAL void scrubspi_plugin_save(ArkimeSession_t *session, int UNUSED(final))
             GHashTable    *ghash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
             gpointer       ikey;
 
-            g_hash_table_iter_init (&iter, session->fields[pos]->ghash);
+            g_hash_table_iter_init (&iter, field->ghash);
             while (g_hash_table_iter_next (&iter, &ikey, NULL)) {
                 newstr = g_regex_replace(ss[s].search, ikey, -1, 0, ss[s].replace, 0, NULL);
                 if (!newstr)
                     newstr = g_strdup(ikey);
                 g_hash_table_add(ghash, newstr);
             }
-            g_hash_table_destroy(session->fields[pos]->ghash);
-            session->fields[pos]->ghash = ghash;
+            g_hash_table_destroy(field->ghash);
+            field->ghash = ghash;
             break;
         }
         case ARKIME_FIELD_TYPE_INT:
@@ -110,6 +110,7 @@ LOCAL void *reader_snf_thread(gpointer posv)
             arkime_packet_batch_flush(&batch);
     }
     arkime_packet_batch_flush(&batch);
+    arkime_packet_batch_free(&batch);
     return NULL;
 }
 /******************************************************************************/
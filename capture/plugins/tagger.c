@@ -148,6 +148,7 @@ LOCAL patricia_node_t *tagger_make_and_lookup(patricia_tree_t *tree, const char
 LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
 {
     TaggerString_t *tstring;
+    const ArkimeField_t *field;
 
     patricia_node_t *nodes[PATRICIA_MAXBITS + 1];
     int cnt;
@@ -172,12 +173,12 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
         tagger_process_match(session, ((TaggerIP_t *)(nodes[i]->data))->infos, dstIpField);
     }
 
-    if (httpXffField != -1 && session->fields[httpXffField]) {
+    if (httpXffField != -1 && (field = arkime_field_get(session, httpXffField))) {
         GHashTable            *ghash;
         GHashTableIter         iter;
         gpointer               ikey;
 
-        ghash = session->fields[httpXffField]->ghash;
+        ghash = field->ghash;
         g_hash_table_iter_init (&iter, ghash);
         while (g_hash_table_iter_next (&iter, &ikey, NULL)) {
             memcpy(&prefix.add.sin6.s6_addr, ikey, 16);
@@ -189,8 +190,8 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
     }
 
     ArkimeString_t *hstring;
-    if (httpHostField != -1 && session->fields[httpHostField]) {
-        const ArkimeStringHashStd_t *shash = session->fields[httpHostField]->shash;
+    if (httpHostField != -1 && (field = arkime_field_get(session, httpHostField))) {
+        const ArkimeStringHashStd_t *shash = field->shash;
         HASH_FORALL2(s_, *shash, hstring) {
             HASH_FIND_HASH(s_, allDomains, hstring->s_hash, hstring->str, tstring);
             if (tstring)
@@ -252,8 +253,8 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
         }
     }
 
-    if (httpMd5Field != -1 && session->fields[httpMd5Field]) {
-        const ArkimeStringHashStd_t *shash = session->fields[httpMd5Field]->shash;
+    if (httpMd5Field != -1 && (field = arkime_field_get(session, httpMd5Field))) {
+        const ArkimeStringHashStd_t *shash = field->shash;
         HASH_FORALL2(s_, *shash, hstring) {
             HASH_FIND_HASH(s_, allMD5s, hstring->s_hash, hstring->str, tstring);
             if (tstring)
@@ -261,8 +262,8 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
         }
     }
 
-    if (httpPathField != -1 && session->fields[httpPathField]) {
-        const ArkimeStringHashStd_t *shash = session->fields[httpPathField]->shash;
+    if (httpPathField != -1 && (field = arkime_field_get(session, httpPathField))) {
+        const ArkimeStringHashStd_t *shash = field->shash;
         HASH_FORALL2(s_, *shash, hstring) {
             HASH_FIND_HASH(s_, allURIs, hstring->s_hash, hstring->str, tstring);
             if (tstring) {
@@ -271,8 +272,8 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
         }
     }
 
-    if (emailMd5Field != -1 && session->fields[emailMd5Field]) {
-        const ArkimeStringHashStd_t *shash = session->fields[emailMd5Field]->shash;
+    if (emailMd5Field != -1 && (field = arkime_field_get(session, emailMd5Field))) {
+        const ArkimeStringHashStd_t *shash = field->shash;
         HASH_FORALL2(s_, *shash, hstring) {
             HASH_FIND_HASH(s_, allMD5s, hstring->s_hash, hstring->str, tstring);
             if (tstring)
@@ -280,8 +281,8 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
         }
     }
 
-    if (emailSrcField != -1 && session->fields[emailSrcField]) {
-        const ArkimeStringHashStd_t *shash = session->fields[emailSrcField]->shash;
+    if (emailSrcField != -1 && (field = arkime_field_get(session, emailSrcField))) {
+        const ArkimeStringHashStd_t *shash = field->shash;
         HASH_FORALL2(s_, *shash, hstring) {
             HASH_FIND_HASH(s_, allEmails, hstring->s_hash, hstring->str, tstring);
             if (tstring)
@@ -289,8 +290,8 @@ LOCAL void tagger_plugin_save(ArkimeSession_t *session, int UNUSED(final))
         }
     }
 
-    if (emailDstField != -1 && session->fields[emailDstField]) {
-        const ArkimeStringHashStd_t *shash = session->fields[emailDstField]->shash;
+    if (emailDstField != -1 && (field = arkime_field_get(session, emailDstField))) {
+        const ArkimeStringHashStd_t *shash = field->shash;
         HASH_FORALL2(s_, *shash, hstring) {
             HASH_FIND_HASH(s_, allEmails, hstring->s_hash, hstring->str, tstring);
             if (tstring)
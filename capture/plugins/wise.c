@@ -616,7 +616,8 @@ LOCAL void wise_lookup_ip(ArkimeSession_t *session, WiseRequest_t *request, stru
 /******************************************************************************/
 LOCAL void wise_lookup_tuple(ArkimeSession_t *session, WiseRequest_t *request)
 {
-    if (!session->fields[protocolField])
+    const ArkimeField_t *protocols = arkime_field_get(session, protocolField);
+    if (!protocols)
         return;
 
     char    str[1000];
@@ -627,7 +628,7 @@ LOCAL void wise_lookup_tuple(ArkimeSession_t *session, WiseRequest_t *request)
 
     int first = 1;
     const ArkimeString_t *hstring;
-    const ArkimeStringHashStd_t *shash = session->fields[protocolField]->shash;
+    const ArkimeStringHashStd_t *shash = protocols->shash;
     HASH_FORALL2(s_, *shash, hstring) {
         if (first) {
             first = 0;
@@ -757,7 +758,8 @@ LOCAL void wise_plugin_pre_save(ArkimeSession_t *session, int UNUSED(final))
             }
 
             // This session doesn't have this many fields or field isn't set
-            if (pos < 0 || pos >= session->maxFields || !session->fields[pos] || !config.fields[pos])
+            const ArkimeField_t *field = pos < 0 || pos >= config.maxDbField ? NULL : arkime_field_get(session, pos);
+            if (!field || !config.fields[pos])
                 continue;
 
             const ArkimeStringHashStd_t *shash;
@@ -767,25 +769,25 @@ LOCAL void wise_plugin_pre_save(ArkimeSession_t *session, int UNUSED(final))
 
             switch (config.fields[pos]->type) {
             case ARKIME_FIELD_TYPE_INT:
-                snprintf(buf, sizeof(buf), "%d", session->fields[pos]->i);
+                snprintf(buf, sizeof(buf), "%d", field->i);
                 wise_lookup(session, iRequest, buf, type, pos);
                 break;
             case ARKIME_FIELD_TYPE_INT_ARRAY:
             case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
-                for (guint a = 0; a < session->fields[pos]->iarray->len; a++) {
-                    snprintf(buf, sizeof(buf), "%u", g_array_index(session->fields[pos]->iarray, uint32_t, a));
+                for (guint a = 0; a < field->iarray->len; a++) {
+                    snprintf(buf, sizeof(buf), "%u", g_array_index(field->iarray, uint32_t, a));
                     wise_lookup(session, iRequest, buf, type, pos);
                 }
                 break;
             case ARKIME_FIELD_TYPE_INT_HASH:
-                ihash = session->fields[pos]->ihash;
+                ihash = field->ihash;
                 HASH_FORALL2(i_, *ihash, hint) {
                     snprintf(buf, sizeof(buf), "%u", hint->i_hash);
                     wise_lookup(session, iRequest, buf, type, pos);
                 }
                 break;
             case ARKIME_FIELD_TYPE_INT_GHASH:
-                ghash = session->fields[pos]->ghash;
+                ghash = field->ghash;
                 g_hash_table_iter_init (&iter, ghash);
                 while (g_hash_table_iter_next (&iter, &ikey, NULL)) {
                     snprintf(buf, sizeof(buf), "%d", (int)(long)ikey);
@@ -793,17 +795,17 @@ LOCAL void wise_plugin_pre_save(ArkimeSession_t *session, int UNUSED(final))
                 }
                 break;
             case ARKIME_FIELD_TYPE_FLOAT:
-                snprintf(buf, sizeof(buf), "%f", session->fields[pos]->f);
+                snprintf(buf, sizeof(buf), "%f", field->f);
                 wise_lookup(session, iRequest, buf, type, pos);
                 break;
             case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
-                for (guint a = 0; a < session->fields[pos]->farray->len; a++) {
-                    snprintf(buf, sizeof(buf), "%f", g_array_index(session->fields[pos]->farray, float, a));
+                for (guint a = 0; a < field->farray->len; a++) {
+                    snprintf(buf, sizeof(buf), "%f", g_array_index(field->farray, float, a));
                     wise_lookup(session, iRequest, buf, type, pos);
                 }
                 break;
             case ARKIME_FIELD_TYPE_FLOAT_GHASH:
-                ghash = session->fields[pos]->ghash;
+                ghash = field->ghash;
                 g_hash_table_iter_init (&iter, ghash);
                 while (g_hash_table_iter_next (&iter, &ikey, NULL)) {
                     snprintf(buf, sizeof(buf), "%f", POINTER_TO_FLOAT(ikey));
@@ -811,10 +813,10 @@ LOCAL void wise_plugin_pre_save(ArkimeSession_t *session, int UNUSED(final))
                 }
                 break;
             case ARKIME_FIELD_TYPE_IP:
-                wise_lookup_ip(session, iRequest, (struct in6_addr *)session->fields[pos]->ip, pos);
+                wise_lookup_ip(session, iRequest, (struct in6_addr *)field->ip, pos);
                 break;
             case ARKIME_FIELD_TYPE_IP_GHASH:
-                ghash = session->fields[pos]->ghash;
+                ghash = field->ghash;
                 g_hash_table_iter_init (&iter, ghash);
                 while (g_hash_table_iter_next (&iter, &ikey, NULL)) {
                     wise_lookup_ip(session, iRequest, (struct in6_addr *)ikey, pos);
@@ -822,20 +824,20 @@ LOCAL void wise_plugin_pre_save(ArkimeSession_t *session, int UNUSED(final))
                 break;
             case ARKIME_FIELD_TYPE_STR:
                 if (type == INTEL_TYPE_DOMAIN)
-                    wise_lookup_domain(session, iRequest, session->fields[pos]->str, pos);
+                    wise_lookup_domain(session, iRequest, field->str, pos);
                 else
-                    wise_lookup(session, iRequest, session->fields[pos]->str, type, pos);
+                    wise_lookup(session, iRequest, field->str, type, pos);
                 break;
             case ARKIME_FIELD_TYPE_STR_ARRAY:
-                for (guint a = 0; a < session->fields[pos]->sarray->len; a++) {
+                for (guint a = 0; a < field->sarray->len; a++) {
                     if (type == INTEL_TYPE_DOMAIN)
-                        wise_lookup_domain(session, iRequest, g_ptr_array_index(session->fields[pos]->sarray, a), pos);
+                        wise_lookup_domain(session, iRequest, g_ptr_array_index(field->sarray, a), pos);
                     else
-                        wise_lookup(session, iRequest, g_ptr_array_index(session->fields[pos]->sarray, a), type, pos);
+                        wise_lookup(session, iRequest, g_ptr_array_index(field->sarray, a), type, pos);
                 }
                 break;
             case ARKIME_FIELD_TYPE_STR_HASH:
-                shash = session->fields[pos]->shash;
+                shash = field->shash;
                 HASH_FORALL2(s_, *shash, hstring) {
                     if (type == INTEL_TYPE_DOMAIN)
                         wise_lookup_domain(session, iRequest, hstring->str, pos);
@@ -851,7 +853,7 @@ LOCAL void wise_plugin_pre_save(ArkimeSession_t *session, int UNUSED(final))
                 }
                 break;
             case ARKIME_FIELD_TYPE_STR_GHASH:
-                ghash = session->fields[pos]->ghash;
+                ghash = field->ghash;
                 g_hash_table_iter_init (&iter, ghash);
                 while (g_hash_table_iter_next (&iter, &ikey, NULL)) {
                     if (type == INTEL_TYPE_DOMAIN)
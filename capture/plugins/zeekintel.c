@@ -753,20 +753,21 @@ LOCAL void zeekintel_match_str_field(ArkimeSession_t *session, ZeekIntelStringHa
     const char *where = info->expression;
 
     void *getval = NULL;
+    const ArkimeField_t *field = NULL;
     if (info->getCb) {
         getval = info->getCb(session, pos);
         if (!getval)
             return;
-    } else if (pos >= session->maxFields || !session->fields[pos]) {
+    } else if (pos >= config.maxDbField || !(field = arkime_field_get(session, pos))) {
         return;
     }
 
     switch (info->type) {
     case ARKIME_FIELD_TYPE_STR:
-        zeekintel_match_str_value(session, hash, info->getCb ? (char *)getval : session->fields[pos]->str, lower, where);
+        zeekintel_match_str_value(session, hash, info->getCb ? (char *)getval : field->str, lower, where);
         break;
     case ARKIME_FIELD_TYPE_STR_ARRAY: {
-        const GPtrArray *arr = info->getCb ? (GPtrArray *)getval : session->fields[pos]->sarray;
+        const GPtrArray *arr = info->getCb ? (GPtrArray *)getval : field->sarray;
         for (guint i = 0; i < arr->len; i++)
             zeekintel_match_str_value(session, hash, g_ptr_array_index(arr, i), lower, where);
         break;
@@ -774,14 +775,14 @@ LOCAL void zeekintel_match_str_field(ArkimeSession_t *session, ZeekIntelStringHa
     case ARKIME_FIELD_TYPE_STR_HASH: {
         if (info->getCb)
             break;  // no getCb STR_HASH fields exist
-        const ArkimeStringHashStd_t *shash = session->fields[pos]->shash;
+        const ArkimeStringHashStd_t *shash = field->shash;
         const ArkimeString_t *hstring;
         HASH_FORALL2(s_, *shash, hstring)
         zeekintel_match_str_value(session, hash, hstring->str, lower, where);
         break;
     }
     case ARKIME_FIELD_TYPE_STR_GHASH: {
-        GHashTable    *ghash = info->getCb ? (GHashTable *)getval : session->fields[pos]->ghash;
+        GHashTable    *ghash = info->getCb ? (GHashTable *)getval : field->ghash;
         GHashTableIter iter;
         gpointer       ikey;
         g_hash_table_iter_init(&iter, ghash);
@@ -801,15 +802,16 @@ LOCAL void zeekintel_match_str_field(ArkimeSession_t *session, ZeekIntelStringHa
 LOCAL void zeekintel_match_ip_field(ArkimeSession_t *session, ZeekIntelDB_t *db, int pos)
 {
     const ArkimeFieldInfo_t *info = config.fields[pos];
-    if (!info || pos >= session->maxFields || !session->fields[pos])
+    const ArkimeField_t *field = pos < config.maxDbField ? arkime_field_get(session, pos) : NULL;
+    if (!info || !field)
         return;
 
     const char *where = info->expression;
 
     if (info->type == ARKIME_FIELD_TYPE_IP) {
-        zeekintel_match_ip(session, db, session->fields[pos]->ip, where);
+        zeekintel_match_ip(session, db, field->ip, where);
     } else { // ARKIME_FIELD_TYPE_IP_GHASH
-        GHashTable    *ghash = session->fields[pos]->ghash;
+        GHashTable    *ghash = field->ghash;
         GHashTableIter iter;
         gpointer       ikey;
         g_hash_table_iter_init(&iter, ghash);
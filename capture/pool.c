@@ -0,0 +1,251 @@
+/******************************************************************************/
+/* pool.c  -- Fixed size object pools
+ *
+ * Copyright 2026 AOL Inc. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Each pool hands out fixed size items carved from slabs.  Every thread has
+ * its own cache of free items so alloc and free don't take a lock.  Items are
+ * often allocated on one thread and freed on another (packets are allocated by
+ * readers and freed by packet threads), so when a thread's cache gets too
+ * big a magazine of items is moved to the pool's depot where any thread that
+ * runs out can pick it up.  Memory is never given back to the system, it is
+ * just reused, which stops glibc arenas from fragmenting.
+ */
+
+#include <inttypes.h>
+#include "arkime.h"
+
+extern ArkimeConfig_t        config;
+
+#define ARKIME_POOL_MAX          16
+// Items moved between a thread cache and the depot at a time
+#define ARKIME_POOL_MAG_SIZE     128
+// Items created each time a pool needs more memory
+#define ARKIME_POOL_SLAB_ITEMS   512
+
+typedef struct arkimepoolitem {
+    struct arkimepoolitem *next;
+    struct arkimepoolitem *nextMag;        // Only used by the first item of a magazine in the depot
+} ArkimePoolItem_t;
+
+typedef struct arkimepoolcache {
+    struct arkimepoolcache *cache_next;
+    ArkimePoolItem_t       *items;
+    uint32_t                count;
+    uint64_t                allocs;
+    uint64_t                frees;
+} ARKIME_CACHE_ALIGN ArkimePoolCache_t;
+
+struct arkimepool {
+    char                   *name;
+    uint32_t                size;
+    int                     id;
+    ArkimePoolItem_t       *mags;
+    uint32_t                magCount;
+    uint32_t                slabs;
+    ArkimePoolCache_t      *caches;
+    ARKIME_LOCK_EXTERN(lock);
+};
+
+LOCAL ArkimePool_t          *pools[ARKIME_POOL_MAX];
+LOCAL int                    numPools;
+LOCAL ARKIME_LOCK_DEFINE(pools);
+
+LOCAL __thread ArkimePoolCache_t *poolCaches[ARKIME_POOL_MAX];
+
+/******************************************************************************/
+ArkimePool_t *arkime_pool_create(const char *name, uint32_t size)
+{
+    ARKIME_LOCK(pools);
+    if (numPools >= ARKIME_POOL_MAX) {
+        LOGEXIT("ERROR - Too many pools, can't create '%s'", name);
+    }
+
+    ArkimePool_t *pool = ARKIME_TYPE_ALLOC0(ArkimePool_t);
+    pool->name = g_strdup(name);
+    // Keep items 16 byte aligned like malloc does
+    pool->size = (MAX(size, sizeof(ArkimePoolItem_t)) + 15) & ~15U;
+    pool->id = numPools;
+    ARKIME_LOCK_INIT(pool->lock);
+
+    pools[numPools] = pool;
+    numPools++;
+    ARKIME_UNLOCK(pools);
+    return pool;
+}
+/******************************************************************************/
+LOCAL ArkimePoolCache_t *arkime_pool_cache(ArkimePool_t *pool)
+{
+    ArkimePoolCache_t *cache = poolCaches[pool->id];
+    if (likely(cache != NULL))
+        return cache;
+
+    cache = ARKIME_TYPE_ALLOC0_ALIGNED(ArkimePoolCache_t);
+    poolCaches[pool->id] = cache;
+
+    // Thread caches are never freed so the stats can always walk them
+    ARKIME_LOCK(pool->lock);
+    cache->cache_next = pool->caches;
+    pool->caches = cache;
+    ARKIME_UNLOCK(pool->lock);
+    return cache;
+}
+/******************************************************************************/
+LOCAL void arkime_pool_refill(ArkimePool_t *pool, ArkimePoolCache_t *cache)
+{
+    ARKIME_LOCK(pool->lock);
+    ArkimePoolItem_t *mag = pool->mags;
+    if (mag) {
+        pool->mags = mag->nextMag;
+        pool->magCount--;
+    }
+    ARKIME_UNLOCK(pool->lock);
+
+    if (mag) {
+        cache->items = mag;
+        cache->count = ARKIME_POOL_MAG_SIZE;
+        return;
+    }
+
+    uint8_t *slab = ARKIME_SIZE_ALLOC(pool->name, (size_t)pool->size * ARKIME_POOL_SLAB_ITEMS);
+    if (!slab) {
+        LOGEXIT("ERROR - Couldn't allocate %u items for pool '%s'", ARKIME_POOL_SLAB_ITEMS, pool->name);
+    }
+
+    ArkimePoolItem_t *item = NULL;
+    for (int i = ARKIME_POOL_SLAB_ITEMS - 1; i >= 0; i--) {
+        ArkimePoolItem_t *next = item;
+        item = (ArkimePoolItem_t *)(slab + (size_t)i * pool->size);
+        item->next = next;
+    }
+    cache->items = item;
+    cache->count = ARKIME_POOL_SLAB_ITEMS;
+    ARKIME_THREAD_INCR(pool->slabs);
+}
+/******************************************************************************/
+LOCAL void arkime_pool_flush(ArkimePool_t *pool, ArkimePoolCache_t *cache)
+{
+    ArkimePoolItem_t *first = cache->items;
+    ArkimePoolItem_t *last = first;
+    for (int i = 1; i < ARKIME_POOL_MAG_SIZE; i++) {
+        last = last->next;
+    }
+    cache->items = last->next;
+    cache->count -= ARKIME_POOL_MAG_SIZE;
+    last->next = NULL;
+
+    ARKIME_LOCK(pool->lock);
+    first->nextMag = pool->mags;
+    pool->mags = first;
+    pool->magCount++;
+    ARKIME_UNLOCK(pool->lock);
+}
+/******************************************************************************/
+void *arkime_pool_alloc(ArkimePool_t *pool)
+{
+#ifdef __SANITIZE_ADDRESS__
+    return malloc(pool->size);
+#else
+    ArkimePoolCache_t *cache = arkime_pool_cache(pool);
+
+    if (unlikely(!cache->items)) {
+        arkime_pool_refill(pool, cache);
+    }
+
+    ArkimePoolItem_t *item = cache->items;
+    cache->items = item->next;
+    cache->count--;
+    cache->allocs++;
+    return item;
+#endif
+}
+/******************************************************************************/
+void *arkime_pool_alloc0(ArkimePool_t *pool)
+{
+    void *mem = arkime_pool_alloc(pool);
+    memset(mem, 0, pool->size);
+    return mem;
+}
+/******************************************************************************/
+void arkime_pool_free(ArkimePool_t *pool, void *mem)
+{
+#ifdef __SANITIZE_ADDRESS__
+    free(mem);
+#else
+    ArkimePoolCache_t *cache = arkime_pool_cache(pool);
+    ArkimePoolItem_t  *item = mem;
+
+    item->next = cache->items;
+    cache->items = item;
+    cache->count++;
+    cache->frees++;
+
+    // Keep a magazine for ourselves and give the rest back
+    if (unlikely(cache->count >= 2 * ARKIME_POOL_MAG_SIZE)) {
+        arkime_pool_flush(pool, cache);
+    }
+#endif
+}
+/******************************************************************************/
+/* The thread cache counters are read without locks so the numbers are only
+ * approximate while things are running.
+ */
+LOCAL void arkime_pool_info(ArkimePool_t *pool, ArkimePoolInfo_t *info)
+{
+    uint64_t allocs = 0, frees = 0;
+
+    memset(info, 0, sizeof(*info));
+
+    ARKIME_LOCK(pool->lock);
+    for (ArkimePoolCache_t *cache = pool->caches; cache; cache = cache->cache_next) {
+        allocs += cache->allocs;
+        frees += cache->frees;
+        info->cached += cache->count;
+    }
+    info->depot = (uint64_t)pool->magCount * ARKIME_POOL_MAG_SIZE;
+    info->bytes = (uint64_t)pool->slabs * ARKIME_POOL_SLAB_ITEMS * pool->size;
+    ARKIME_UNLOCK(pool->lock);
+
+    info->allocs = allocs;
+    info->inUse = allocs > frees ? allocs - frees : 0;
+}
+/******************************************************************************/
+void arkime_pool_stats(ArkimePoolInfo_t *total)
+{
+    ArkimePoolInfo_t info;
+
+    memset(total, 0, sizeof(*total));
+    for (int p = 0; p < ARKIME_THREAD_ATOMIC_LOAD(numPools); p++) {
+        arkime_pool_info(pools[p], &info);
+        total->allocs += info.allocs;
+        total->inUse += info.inUse;
+        total->cached += info.cached;
+        total->depot += info.depot;
+        total->bytes += info.bytes;
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_pool_cmd_stats(int UNUSED(argc), char **UNUSED(argv), gpointer cc)
+{
+    char output[4000];
+    BSB bsb;
+    BSB_INIT(bsb, output, sizeof(output));
+
+    BSB_EXPORT_sprintf(bsb, "%-12s %6s %14s %12s %12s %12s %14s\n", "Pool", "Size", "Allocs", "In Use", "Cached", "Depot", "Bytes");
+    for (int p = 0; p < ARKIME_THREAD_ATOMIC_LOAD(numPools); p++) {
+        ArkimePoolInfo_t info;
+        arkime_pool_info(pools[p], &info);
+        BSB_EXPORT_sprintf(bsb, "%-12s %6u %14" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %14" PRIu64 "\n",
+                           pools[p]->name, pools[p]->size, info.allocs, info.inUse, info.cached, info.depot, info.bytes);
+    }
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+}
+/******************************************************************************/
+void arkime_pool_init()
+{
+    arkime_command_register("pool-stats", arkime_pool_cmd_stats, "Object pool stats");
+}
@@ -17,7 +17,7 @@ typedef struct {
     time_t      lastRun;
 } ARKIME_CACHE_ALIGN pqThreadData_t;
 
-LOCAL pqThreadData_t pqThreadData[ARKIME_MAX_PACKET_THREADS];
+LOCAL pqThreadData_t *pqThreadData;
 
 /******************************************************************************/
 typedef struct arkimepqitem {
@@ -41,8 +41,8 @@ typedef struct {
 typedef HASH_VAR(s_, ARKIME_CACHE_ALIGN ArkimePQHash_t, ArkimePQHead_t, 51);
 
 struct ArkimePQ_t {
-    ArkimePQHead_t      lists[ARKIME_MAX_PACKET_THREADS];
-    ArkimePQHash_t      keys[ARKIME_MAX_PACKET_THREADS];
+    ArkimePQHead_t     *lists;
+    ArkimePQHash_t     *keys;
     ArkimePQ_cb         cb;
     uint32_t            timeout;
 };
@@ -57,11 +57,14 @@ ArkimePQ_t *arkime_pq_alloc(int timeout, ArkimePQ_cb cb)
 {
     if (!pqs) {
         pqs = g_ptr_array_new();
+        pqThreadData = arkime_numa_alloc0("pqThreadData", sizeof(pqThreadData_t), config.packetThreads);
     }
 
     ArkimePQ_t *pq = ARKIME_TYPE_ALLOC0_ALIGNED(ArkimePQ_t);
 
     pq->timeout = timeout;
+    pq->lists = arkime_numa_alloc0("pqLists", sizeof(ArkimePQHead_t), config.packetThreads);
+    pq->keys = arkime_numa_alloc0("pqKeys", sizeof(ArkimePQHash_t), config.packetThreads);
     for (int t = 0; t < config.packetThreads; t++) {
         HASH_INIT(pqh_, pq->keys[t], arkime_session_hash, (HASH_CMP_FUNC)arkime_pq_cmp);
         DLL_INIT(pql_, &pq->lists[t]);
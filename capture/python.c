@@ -1007,16 +1007,17 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
     }
 
     // This session doesn't have this many fields or field isn't set
-    if (pos < 0 || pos >= session->maxFields || !session->fields[pos])
+    const ArkimeField_t *field = pos < 0 || pos >= config.maxDbField ? NULL : arkime_field_get(session, pos);
+    if (!field)
         Py_RETURN_NONE;
 
     switch (config.fields[pos]->type) {
     case ARKIME_FIELD_TYPE_INT:
-        return PyLong_FromLong((long)session->fields[pos]->i);
+        return PyLong_FromLong((long)field->i);
 
     case ARKIME_FIELD_TYPE_INT_ARRAY:
     case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
-        iarray = session->fields[pos]->iarray;
+        iarray = field->iarray;
 
         py_list = PyList_New(iarray->len);
         for (int i = 0; i < (int)iarray->len; i++) {
@@ -1025,7 +1026,7 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
         return py_list;
 
     case ARKIME_FIELD_TYPE_INT_HASH: {
-        ihash = session->fields[pos]->ihash;
+        ihash = field->ihash;
         py_list = PyList_New(HASH_COUNT(i_, *ihash));
         int i = 0;
         HASH_FORALL2(i_, *ihash, hint) {
@@ -1036,7 +1037,7 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
     }
 
     case ARKIME_FIELD_TYPE_INT_GHASH: {
-        ghash = session->fields[pos]->ghash;
+        ghash = field->ghash;
         g_hash_table_iter_init(&iter, ghash);
 
         py_list = PyList_New(g_hash_table_size(ghash));
@@ -1049,17 +1050,17 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
     }
 
     case ARKIME_FIELD_TYPE_FLOAT:
-        return PyFloat_FromDouble(session->fields[pos]->f);
+        return PyFloat_FromDouble(field->f);
 
     case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
-        py_list = PyList_New(session->fields[pos]->farray->len);
-        for (int i = 0; i < (int)session->fields[pos]->farray->len; i++) {
-            PyList_SetItem(py_list, i, PyFloat_FromDouble(g_array_index(session->fields[pos]->farray, float, i)));
+        py_list = PyList_New(field->farray->len);
+        for (int i = 0; i < (int)field->farray->len; i++) {
+            PyList_SetItem(py_list, i, PyFloat_FromDouble(g_array_index(field->farray, float, i)));
         }
         return py_list;
 
     case ARKIME_FIELD_TYPE_FLOAT_GHASH: {
-        ghash = session->fields[pos]->ghash;
+        ghash = field->ghash;
         g_hash_table_iter_init(&iter, ghash);
 
         py_list = PyList_New(g_hash_table_size(ghash));
@@ -1072,7 +1073,7 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
     }
 
     case ARKIME_FIELD_TYPE_IP:
-        ip6 = (struct in6_addr *)session->fields[pos]->ip;
+        ip6 = (struct in6_addr *)field->ip;
         if (IN6_IS_ADDR_V4MAPPED(ip6)) {
             arkime_ip4tostr(ARKIME_V6_TO_V4(*ip6), ipstr, sizeof(ipstr));
         } else {
@@ -1081,7 +1082,7 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
         return PyUnicode_FromString(ipstr);
 
     case ARKIME_FIELD_TYPE_IP_GHASH: {
-        ghash = session->fields[pos]->ghash;
+        ghash = field->ghash;
         g_hash_table_iter_init(&iter, ghash);
 
         py_list = PyList_New(g_hash_table_size(ghash));
@@ -1100,17 +1101,17 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
     }
 
     case ARKIME_FIELD_TYPE_STR:
-        return PyUnicode_FromString(session->fields[pos]->str);
+        return PyUnicode_FromString(field->str);
 
     case ARKIME_FIELD_TYPE_STR_ARRAY:
-        py_list = PyList_New(session->fields[pos]->sarray->len);
-        for (int i = 0; i < (int)session->fields[pos]->sarray->len; i++) {
-            PyList_SetItem(py_list, i, PyUnicode_FromString((char *)g_ptr_array_index(session->fields[pos]->sarray, i)));
+        py_list = PyList_New(field->sarray->len);
+        for (int i = 0; i < (int)field->sarray->len; i++) {
+            PyList_SetItem(py_list, i, PyUnicode_FromString((char *)g_ptr_array_index(field->sarray, i)));
         }
         return py_list;
 
     case ARKIME_FIELD_TYPE_STR_HASH: {
-        shash = session->fields[pos]->shash;
+        shash = field->shash;
         py_list = PyList_New(HASH_COUNT(s_, *shash));
         int i = 0;
 
@@ -1122,7 +1123,7 @@ LOCAL PyObject *arkime_python_session_get(PyObject UNUSED(*self), PyObject *args
     }
 
     case ARKIME_FIELD_TYPE_STR_GHASH: {
-        ghash = session->fields[pos]->ghash;
+        ghash = field->ghash;
         g_hash_table_iter_init(&iter, ghash);
 
         py_list = PyList_New(g_hash_table_size(ghash));
@@ -1423,6 +1424,9 @@ LOCAL PyObject *arkime_python_packet_get(PyObject UNUSED(*self), PyObject *args)
             return PyLong_FromUnsignedLong(packet->writerFileNum);
         }
         if (strcmp(field, "writerFilePos") == 0) {
+            // Not known yet when the block is still being compressed
+            if (packet->writerFilePos == ARKIME_WRITER_FILE_POS_PENDING)
+                return PyLong_FromUnsignedLong(0);
             return PyLong_FromUnsignedLong(packet->writerFilePos);
         }
         break;
@@ -145,6 +145,7 @@ LOCAL void *reader_bpf_thread(gpointer readerv)
         arkime_packet_batch_flush(&batch);
     }
 
+    arkime_packet_batch_free(&batch);
     int exitFunc = arkime_get_named_func("arkime_reader_thread_exit");
     arkime_call_named_func(exitFunc, reader->interfacePos, NULL);
     return NULL;
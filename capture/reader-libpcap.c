@@ -81,6 +81,7 @@ LOCAL void *reader_libpcap_thread(gpointer posv)
     //ALW - Need to close after packet finishes
     //pcap_close(pcap);
 
+    arkime_packet_batch_free(&batch);
     int exitFunc = arkime_get_named_func("arkime_reader_thread_exit");
     arkime_call_named_func(exitFunc, interface, NULL);
     return NULL;
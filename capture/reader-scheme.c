@@ -544,6 +544,18 @@ typedef struct {
     uint32_t block_total_length;
 } ArkimePcapNGBlockHeader_t;
 
+/******************************************************************************/
+/* Each thread that feeds buffers in keeps one batch, so the per packet thread
+ * queues aren't allocated for every buffer.
+ */
+LOCAL ArkimePacketBatch_t *reader_scheme_batch()
+{
+    static __thread ArkimePacketBatch_t batch;
+
+    if (!batch.packetQ)
+        arkime_packet_batch_init(&batch);
+    return &batch;
+}
 /**
  * Process a buffer of data, it can be called on any thread including main.
  * Returns 0 on success or 1 on error
@@ -551,8 +563,7 @@ typedef struct {
 SUPPRESS_ALIGNMENT
 LOCAL int arkime_reader_scheme_processNG(const char *uri, uint8_t *data, int len, const char *extraInfo, ArkimeSchemeAction_t *actions)
 {
-    ArkimePacketBatch_t   batch;
-    arkime_packet_batch_init(&batch);
+    ArkimePacketBatch_t  *batch = reader_scheme_batch();
 
     reader_scheme_pause();
 
@@ -891,7 +902,7 @@ LOCAL int arkime_reader_scheme_processNG(const char *uri, uint8_t *data, int len
             if (deadPcap && !bpf_filter(bpf.bf_insns, readerState.packet->pkt, readerState.pktlen, readerState.pktlen)) {
                 arkime_packet_free(readerState.packet);
             } else {
-                arkime_packet_batch(&batch, readerState.packet);
+                arkime_packet_batch(batch, readerState.packet);
             }
             readerState.packet = 0;
             readerState.state = ARKIME_SCHEME_NG_SKIP; // skip options and 2nd block length
@@ -915,9 +926,9 @@ LOCAL int arkime_reader_scheme_processNG(const char *uri, uint8_t *data, int len
 
 processNG:
     // Record if any packets were batched
-    if (batch.count > 0) {
+    if (batch->count > 0) {
         offlineInfo[readerState.readerPos].didBatch = 1;
-        arkime_packet_batch_flush(&batch);
+        arkime_packet_batch_flush(batch);
     }
     return 0;
 }
@@ -929,8 +940,7 @@ int arkime_reader_scheme_process(const char *uri, uint8_t *data, int len, const
         return arkime_reader_scheme_processNG(uri, data, len, extraInfo, actions);
     }
 
-    ArkimePacketBatch_t   batch;
-    arkime_packet_batch_init(&batch);
+    ArkimePacketBatch_t  *batch = reader_scheme_batch();
 
     reader_scheme_pause();
 
@@ -1075,7 +1085,7 @@ int arkime_reader_scheme_process(const char *uri, uint8_t *data, int len, const
             if (deadPcap && !bpf_filter(bpf.bf_insns, readerState.packet->pkt, readerState.pktlen, readerState.pktlen)) {
                 arkime_packet_free(readerState.packet);
             } else {
-                arkime_packet_batch(&batch, readerState.packet);
+                arkime_packet_batch(batch, readerState.packet);
             }
             readerState.packet = 0;
             readerState.state = ARKIME_SCHEME_PACKET_HEADER;
@@ -1099,9 +1109,9 @@ int arkime_reader_scheme_process(const char *uri, uint8_t *data, int len, const
     }
 process:
     // Record if any packets were batched
-    if (batch.count > 0) {
+    if (batch->count > 0) {
         offlineInfo[readerState.readerPos].didBatch = 1;
-        arkime_packet_batch_flush(&batch);
+        arkime_packet_batch_flush(batch);
     }
     return 0;
 }
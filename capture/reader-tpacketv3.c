@@ -45,6 +45,7 @@ typedef struct {
     struct tpacket_req3  req;
     uint8_t             *map;
     struct iovec        *rd;
+    ArkimePacketBlock_t *blocks;
     uint8_t              interfacePos;
     uint8_t              thread;
 } ARKIME_CACHE_ALIGN ArkimeTPacketV3_t;
@@ -60,6 +61,7 @@ LOCAL ArkimeReaderStats_t gStats;
 LOCAL ARKIME_LOCK_DEFINE(gStats);
 
 LOCAL gboolean tpacketv3OldVlan;
+LOCAL gboolean tpacketv3ZeroCopy;
 
 /******************************************************************************/
 int reader_tpacketv3_stats(ArkimeReaderStats_t *stats)
@@ -81,6 +83,15 @@ int reader_tpacketv3_stats(ArkimeReaderStats_t *stats)
     return 0;
 }
 /******************************************************************************/
+/* Called once the last packet pointing into a zero copy block is freed or
+ * copied, can be on any thread.
+ */
+LOCAL void reader_tpacketv3_block_release(ArkimePacketBlock_t *block)
+{
+    struct tpacket_block_desc *tbd = block->uw;
+    ARKIME_THREAD_ATOMIC_STORE(tbd->hdr.bh1.block_status, TP_STATUS_KERNEL);
+}
+/******************************************************************************/
 LOCAL void *reader_tpacketv3_thread(gpointer infov)
 {
     ArkimeTPacketV3_t *info = (ArkimeTPacketV3_t *)infov;
@@ -117,12 +128,25 @@ LOCAL void *reader_tpacketv3_thread(gpointer infov)
             LOG("Stats pos:%d info:%d status:%x waiting:%d total cnt:%d total waiting:%d", pos, info->interfacePos, tbd->hdr.bh1.block_status, tbd->hdr.bh1.num_pkts, cnt, waiting);
         }
 
+        // The packet threads are still using this block from the last time around the ring
+        if (tpacketv3ZeroCopy && ARKIME_THREAD_ATOMIC_LOAD(info->blocks[pos].refs) > 0) {
+            usleep(100);
+            continue;
+        }
+
         // Wait until the block is owned by capture
         if ((tbd->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
             poll(&pfd, 1, -1);
             continue;
         }
 
+        // Each packet holds a reference, plus one for us until the batch is flushed
+        ArkimePacketBlock_t *block = NULL;
+        if (tpacketv3ZeroCopy) {
+            block = &info->blocks[pos];
+            ARKIME_THREAD_ATOMIC_STORE(block->refs, tbd->hdr.bh1.num_pkts + 1);
+        }
+
         struct tpacket3_hdr *th;
 
         th = (struct tpacket3_hdr *)((uint8_t *) tbd + tbd->hdr.bh1.offset_to_first_pkt);
@@ -140,6 +164,7 @@ LOCAL void *reader_tpacketv3_thread(gpointer infov)
             packet->ts.tv_sec     = th->tp_sec;
             packet->ts.tv_usec    = th->tp_nsec / 1000;
             packet->readerPos     = info->interfacePos;
+            packet->block         = block;
 
             if ((th->tp_status & TP_STATUS_VLAN_VALID) && th->hv1.tp_vlan_tci) {
                 if (tpacketv3OldVlan) {
@@ -167,10 +192,15 @@ LOCAL void *reader_tpacketv3_thread(gpointer infov)
         }
         arkime_packet_batch_flush(&batch);
 
-        tbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        if (block) {
+            arkime_packet_block_unref(block);
+        } else {
+            tbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        }
         pos = (pos + 1) % info->req.tp_block_nr;
     }
 
+    arkime_packet_batch_free(&batch);
     int exitFunc = arkime_get_named_func("arkime_reader_thread_exit");
     arkime_call_named_func(exitFunc, info->interfacePos * MAX_THREADS_PER_INTERFACE + info->thread, NULL);
     return NULL;
@@ -198,7 +228,7 @@ void reader_tpacketv3_exit()
 /******************************************************************************/
 void reader_tpacketv3_init(const char *UNUSED(name))
 {
-    arkime_config_check("tpacketv3", "tpacketv3BlockSize", "tpacketv3NumThreads", "tpacketv3ClusterId", NULL);
+    arkime_config_check("tpacketv3", "tpacketv3BlockSize", "tpacketv3NumThreads", "tpacketv3ClusterId", "tpacketv3OldVlan", "tpacketv3ZeroCopy", NULL);
 
     int blocksize = arkime_config_int(NULL, "tpacketv3BlockSize", 1 << 21, 1 << 16, 1U << 31);
     numThreads = arkime_config_int(NULL, "tpacketv3NumThreads", 2, 1, MAX_THREADS_PER_INTERFACE);
@@ -224,6 +254,7 @@ void reader_tpacketv3_init(const char *UNUSED(name))
     int fanout_group_id = arkime_config_int(NULL, "tpacketv3ClusterId", 8005, 0x0001, 0xffff);
 
     tpacketv3OldVlan = arkime_config_boolean(NULL, "tpacketv3OldVlan", FALSE);
+    tpacketv3ZeroCopy = arkime_config_boolean(NULL, "tpacketv3ZeroCopy", FALSE);
 
     int version = TPACKET_V3;
     int reserve = 4;
@@ -278,6 +309,14 @@ void reader_tpacketv3_init(const char *UNUSED(name))
                 infos[i][t].rd[j].iov_len = infos[i][t].req.tp_block_size;
             }
 
+            if (tpacketv3ZeroCopy) {
+                infos[i][t].blocks = ARKIME_SIZE_ALLOC0("blocks", infos[i][t].req.tp_block_nr * sizeof(ArkimePacketBlock_t));
+                for (uint16_t j = 0; j < infos[i][t].req.tp_block_nr; j++) {
+                    infos[i][t].blocks[j].release = reader_tpacketv3_block_release;
+                    infos[i][t].blocks[j].uw = infos[i][t].rd[j].iov_base;
+                }
+            }
+
             struct sockaddr_ll ll;
             memset(&ll, 0, sizeof(ll));
             ll.sll_family = PF_PACKET;
@@ -125,6 +125,7 @@ LOCAL void *tzsp_thread(gpointer UNUSED(uw))
         arkime_packet_batch_flush(&batch);
     }
 
+    arkime_packet_batch_free(&batch);
     int exitFunc = arkime_get_named_func("arkime_reader_thread_exit");
     arkime_call_named_func(exitFunc, 0, NULL);
 
@@ -75,11 +75,48 @@ typedef struct {
  * Used by the fieldset rule type.  This allows us on field setting to find just the rules
  * that we need to eval.
  */
+typedef struct {
+    uint8_t               *chars;        // Sorted, cnt long
+    uint32_t              *kids;
+    uint16_t               cnt;
+    uint32_t               fail;         // Contains only, longest suffix of this node that is also in the trie
+    uint32_t               out;          // Contains only, closest node along the fail links with rules
+    GPtrArray             *rules;        // Rules for the match ending here, owned by fieldsMatch
+} ArkimeRulesTrieNode_t;
+
+typedef struct {
+    ArkimeRulesTrieNode_t *nodes;        // nodes[0] is the root, NULL if no matches of this type
+    uint32_t               num;
+    uint32_t               size;
+} ArkimeRulesTrie_t;
+
+typedef struct {
+    ArkimeRulesTrie_t      head;
+    ArkimeRulesTrie_t      tail;         // Built from the reversed strings
+    ArkimeRulesTrie_t      contains;
+} ArkimeRulesStrMatch_t;
+
+#define ARKIME_RULES_MAX_FOUND 64
+typedef struct {
+    uint32_t               nodes[ARKIME_RULES_MAX_FOUND];
+    int                    cnt;
+    GHashTable            *hash;         // Only if more than ARKIME_RULES_MAX_FOUND are found
+} ArkimeRulesFound_t;
+
+typedef struct {
+    uint32_t              *starts;       // Sorted first value of each segment, the last one runs to UINT32_MAX
+    uint32_t              *offsets;      // Segment s has rules[offsets[s]] up to rules[offsets[s + 1]]
+    GPtrArray            **rules;        // Owned by fieldsMatch
+    uint32_t               num;
+} ArkimeRulesRangeIndex_t;
+
 typedef struct {
     GHashTable            *fieldsHash[ARKIME_FIELDS_MAX];
     patricia_tree_t       *fieldsTree4[ARKIME_FIELDS_MAX];
     patricia_tree_t       *fieldsTree6[ARKIME_FIELDS_MAX];
     GHashTable            *fieldsMatch[ARKIME_FIELDS_MAX];
+    ArkimeRulesStrMatch_t *fieldsStrMatch[ARKIME_FIELDS_MAX]; // Compiled from the string fieldsMatch
+    ArkimeRulesRangeIndex_t *fieldsRange[ARKIME_FIELDS_MAX];  // Compiled from the integer fieldsMatch
 
     GPtrArray             *rules[ARKIME_RULE_TYPE_NUM];
 } ArkimeRulesInfo_t;
@@ -756,6 +793,265 @@ LOCAL void arkime_rules_parser_load_file(char *filename, YamlNode_t *parent)
     }
 }
 /******************************************************************************/
+/* The head, tail and contains matches of each field are compiled into tries
+ * when the rules are loaded so a value is checked against all of them in one
+ * pass instead of one memcmp/arkime_memstr per match.  Head walks a trie of
+ * the prefixes from the start of the value, tail walks a trie of the reversed
+ * suffixes from the end, and contains is an Aho-Corasick automaton.
+ */
+LOCAL void arkime_rules_trie_init(ArkimeRulesTrie_t *trie)
+{
+    trie->size = 64;
+    trie->num = 1;
+    trie->nodes = ARKIME_SIZE_ALLOC0("rules trie", sizeof(ArkimeRulesTrieNode_t) * trie->size);
+}
+/******************************************************************************/
+LOCAL inline uint32_t arkime_rules_trie_child(const ArkimeRulesTrieNode_t *node, uint8_t c)
+{
+    int lo = 0, hi = node->cnt;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (node->chars[mid] < c)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < node->cnt && node->chars[lo] == c)
+        return node->kids[lo];
+    return 0;
+}
+/******************************************************************************/
+LOCAL void arkime_rules_trie_add(ArkimeRulesTrie_t *trie, const uint8_t *key, int len, gboolean reverse, GPtrArray *rules)
+{
+    uint32_t n = 0;
+
+    for (int i = 0; i < len; i++) {
+        const uint8_t c = reverse ? key[len - 1 - i] : key[i];
+        uint32_t kid = arkime_rules_trie_child(&trie->nodes[n], c);
+        if (!kid) {
+            if (trie->num == trie->size) {
+                trie->size *= 2;
+                ARKIME_SIZE_REALLOC("rules trie", trie->nodes, sizeof(ArkimeRulesTrieNode_t) * trie->size);
+            }
+            kid = trie->num++;
+            memset(&trie->nodes[kid], 0, sizeof(trie->nodes[kid]));
+
+            ArkimeRulesTrieNode_t *node = &trie->nodes[n];
+            node->chars = g_realloc(node->chars, node->cnt + 1);
+            node->kids = g_realloc(node->kids, (node->cnt + 1) * sizeof(uint32_t));
+            int j = node->cnt;
+            while (j > 0 && node->chars[j - 1] > c) {
+                node->chars[j] = node->chars[j - 1];
+                node->kids[j] = node->kids[j - 1];
+                j--;
+            }
+            node->chars[j] = c;
+            node->kids[j] = kid;
+            node->cnt++;
+        }
+        n = kid;
+    }
+    trie->nodes[n].rules = rules;
+}
+/******************************************************************************/
+/* Breadth first so a node's fail target is always done before the node */
+LOCAL void arkime_rules_trie_build_fail(ArkimeRulesTrie_t *trie)
+{
+    uint32_t *queue = ARKIME_SIZE_ALLOC("rules trie", sizeof(uint32_t) * trie->num);
+    uint32_t  qhead = 0, qtail = 0;
+
+    queue[qtail++] = 0;
+    while (qhead < qtail) {
+        const uint32_t n = queue[qhead++];
+        const ArkimeRulesTrieNode_t *node = &trie->nodes[n];
+
+        for (int i = 0; i < node->cnt; i++) {
+            const uint32_t kid = node->kids[i];
+            uint32_t fail = 0;
+
+            if (n != 0) {
+                uint32_t f = node->fail;
+                while (f && !arkime_rules_trie_child(&trie->nodes[f], node->chars[i]))
+                    f = trie->nodes[f].fail;
+                fail = arkime_rules_trie_child(&trie->nodes[f], node->chars[i]);
+            }
+
+            trie->nodes[kid].fail = fail;
+            trie->nodes[kid].out = trie->nodes[fail].rules ? fail : trie->nodes[fail].out;
+            queue[qtail++] = kid;
+        }
+    }
+    ARKIME_SIZE_FREE("rules trie", queue);
+}
+/******************************************************************************/
+LOCAL void arkime_rules_trie_free(ArkimeRulesTrie_t *trie)
+{
+    if (!trie->nodes)
+        return;
+
+    for (uint32_t n = 0; n < trie->num; n++) {
+        g_free(trie->nodes[n].chars);
+        g_free(trie->nodes[n].kids);
+    }
+    ARKIME_SIZE_FREE("rules trie", trie->nodes);
+}
+/******************************************************************************/
+LOCAL ArkimeRulesStrMatch_t *arkime_rules_str_match_compile(GHashTable *fieldsMatch)
+{
+    ArkimeRulesStrMatch_t *sm = ARKIME_TYPE_ALLOC0(ArkimeRulesStrMatch_t);
+    GHashTableIter         iter;
+    uint8_t               *akey;
+    GPtrArray             *rules;
+
+    g_hash_table_iter_init(&iter, fieldsMatch);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&akey, (gpointer *)&rules)) {
+        ArkimeRulesTrie_t *trie;
+        switch (akey[0]) {
+        case ARKIME_RULES_STR_MATCH_HEAD:
+            trie = &sm->head;
+            break;
+        case ARKIME_RULES_STR_MATCH_TAIL:
+            trie = &sm->tail;
+            break;
+        case ARKIME_RULES_STR_MATCH_CONTAINS:
+            trie = &sm->contains;
+            break;
+        default:
+            continue;
+        }
+        if (!trie->nodes)
+            arkime_rules_trie_init(trie);
+        arkime_rules_trie_add(trie, akey + 2, akey[1], akey[0] == ARKIME_RULES_STR_MATCH_TAIL, rules);
+    }
+
+    if (sm->contains.nodes)
+        arkime_rules_trie_build_fail(&sm->contains);
+
+    return sm;
+}
+/******************************************************************************/
+LOCAL void arkime_rules_str_match_free(ArkimeRulesStrMatch_t *sm)
+{
+    arkime_rules_trie_free(&sm->head);
+    arkime_rules_trie_free(&sm->tail);
+    arkime_rules_trie_free(&sm->contains);
+    ARKIME_TYPE_FREE(ArkimeRulesStrMatch_t, sm);
+}
+/******************************************************************************/
+/* A contains match can be found more than once in a value, only run its rules
+ * the first time.  Returns TRUE if n hasn't been seen yet.
+ */
+LOCAL gboolean arkime_rules_str_match_first(ArkimeRulesFound_t *found, uint32_t n)
+{
+    if (found->hash)
+        return g_hash_table_add(found->hash, GUINT_TO_POINTER(n));
+
+    for (int i = 0; i < found->cnt; i++) {
+        if (found->nodes[i] == n)
+            return FALSE;
+    }
+
+    if (found->cnt < ARKIME_RULES_MAX_FOUND) {
+        found->nodes[found->cnt++] = n;
+        return TRUE;
+    }
+
+    found->hash = g_hash_table_new(NULL, NULL);
+    for (int i = 0; i < found->cnt; i++) {
+        g_hash_table_add(found->hash, GUINT_TO_POINTER(found->nodes[i]));
+    }
+    return g_hash_table_add(found->hash, GUINT_TO_POINTER(n));
+}
+/******************************************************************************/
+/* Integer range matches are flattened into segments that don't overlap, each
+ * with the rules of every range covering it, so a value is a binary search.
+ */
+LOCAL int arkime_rules_range_cmp(const void *a, const void *b)
+{
+    const uint32_t ua = *(const uint32_t *)a;
+    const uint32_t ub = *(const uint32_t *)b;
+    return ua < ub ? -1 : ua > ub;
+}
+/******************************************************************************/
+// Index of the segment holding value, -1 if before the first one
+LOCAL inline int arkime_rules_range_find(const ArkimeRulesRangeIndex_t *ri, uint32_t value)
+{
+    int lo = 0, hi = ri->num;
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (ri->starts[mid] <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo - 1;
+}
+/******************************************************************************/
+LOCAL ArkimeRulesRangeIndex_t *arkime_rules_range_compile(GHashTable *fieldsMatch)
+{
+    ArkimeRulesRangeIndex_t *ri = ARKIME_TYPE_ALLOC0(ArkimeRulesRangeIndex_t);
+    GHashTableIter           iter;
+    uint64_t                 num;
+    GPtrArray               *rules;
+
+    // Every range starts a segment and ends one at max + 1
+    const int ranges = g_hash_table_size(fieldsMatch);
+    ri->starts = ARKIME_SIZE_ALLOC("rules range", sizeof(uint32_t) * (2 * ranges + 1));
+    g_hash_table_iter_init(&iter, fieldsMatch);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&num, NULL)) {
+        ArkimeRuleIntMatch_t match;
+        match.num = num;
+        ri->starts[ri->num++] = match.min;
+        if (match.max != UINT32_MAX)
+            ri->starts[ri->num++] = match.max + 1;
+    }
+
+    qsort(ri->starts, ri->num, sizeof(uint32_t), arkime_rules_range_cmp);
+    int n = 0;
+    for (uint32_t i = 0; i < ri->num; i++) {
+        if (n == 0 || ri->starts[n - 1] != ri->starts[i])
+            ri->starts[n++] = ri->starts[i];
+    }
+    ri->num = n;
+
+    // Count then fill the rules of each segment, a range covers the segments from its min up to its max
+    ri->offsets = ARKIME_SIZE_ALLOC0("rules range", sizeof(uint32_t) * (ri->num + 1));
+    g_hash_table_iter_init(&iter, fieldsMatch);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&num, NULL)) {
+        ArkimeRuleIntMatch_t match;
+        match.num = num;
+        for (uint32_t s = arkime_rules_range_find(ri, match.min); s < ri->num && ri->starts[s] <= match.max; s++) {
+            ri->offsets[s + 1]++;
+        }
+    }
+    for (uint32_t s = 0; s < ri->num; s++) {
+        ri->offsets[s + 1] += ri->offsets[s];
+    }
+
+    uint32_t *fill = ARKIME_SIZE_ALLOC("rules range", sizeof(uint32_t) * ri->num);
+    memcpy(fill, ri->offsets, sizeof(uint32_t) * ri->num);
+    ri->rules = ARKIME_SIZE_ALLOC("rules range", sizeof(GPtrArray *) * MAX(ri->offsets[ri->num], 1));
+    g_hash_table_iter_init(&iter, fieldsMatch);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&num, (gpointer *)&rules)) {
+        ArkimeRuleIntMatch_t match;
+        match.num = num;
+        for (uint32_t s = arkime_rules_range_find(ri, match.min); s < ri->num && ri->starts[s] <= match.max; s++) {
+            ri->rules[fill[s]++] = rules;
+        }
+    }
+    ARKIME_SIZE_FREE("rules range", fill);
+
+    return ri;
+}
+/******************************************************************************/
+LOCAL void arkime_rules_range_free(ArkimeRulesRangeIndex_t *ri)
+{
+    ARKIME_SIZE_FREE("rules range", ri->starts);
+    ARKIME_SIZE_FREE("rules range", ri->offsets);
+    ARKIME_SIZE_FREE("rules range", ri->rules);
+    ARKIME_TYPE_FREE(ArkimeRulesRangeIndex_t, ri);
+}
+/******************************************************************************/
 LOCAL void arkime_rules_load_complete()
 {
     char      **bpfs;
@@ -820,6 +1116,16 @@ LOCAL void arkime_rules_load_complete()
     }
     g_regex_unref(regex);
 
+    for (int i = 0; i < ARKIME_FIELDS_MAX; i++) {
+        if (!loading.fieldsMatch[i])
+            continue;
+        if (ARKIME_FIELD_TYPE_IS_INT(config.fields[i]->type)) {
+            loading.fieldsRange[i] = arkime_rules_range_compile(loading.fieldsMatch[i]);
+        } else {
+            loading.fieldsStrMatch[i] = arkime_rules_str_match_compile(loading.fieldsMatch[i]);
+        }
+    }
+
     memcpy(&current, &loading, sizeof(loading));
     memset(&loading, 0, sizeof(loading));
 }
@@ -847,6 +1153,12 @@ LOCAL void arkime_rules_free(ArkimeRulesInfo_t *freeing)
         if (freeing->fieldsMatch[i]) {
             g_hash_table_destroy(freeing->fieldsMatch[i]);
         }
+        if (freeing->fieldsStrMatch[i]) {
+            arkime_rules_str_match_free(freeing->fieldsStrMatch[i]);
+        }
+        if (freeing->fieldsRange[i]) {
+            arkime_rules_range_free(freeing->fieldsRange[i]);
+        }
     }
 
     for (int t = 0; t < ARKIME_RULE_TYPE_NUM; t++) {
@@ -1116,6 +1428,7 @@ LOCAL void arkime_rules_match(ArkimeSession_t *const session, ArkimeRule_t *cons
 
 LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, ArkimeRule_t *const rule, int skipPos, BSB *logStr)
 {
+    const ArkimeField_t         *field;
     const ArkimeString_t        *hstring;
     const ArkimeInt_t           *hint;
     const ArkimeStringHashStd_t *shash;
@@ -1195,14 +1508,14 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
         }
 
         // This session doesn't have the field or it isn't set
-        if (p >= session->maxFields || !session->fields[p]) {
+        if (p >= config.maxDbField || !(field = arkime_field_get(session, p))) {
             continue;
         }
 
         // Check a real field
         switch (config.fields[p]->type) {
         case ARKIME_FIELD_TYPE_STR_GHASH:
-            ghash = session->fields[p]->ghash;
+            ghash = field->ghash;
             g_hash_table_iter_init(&iter, ghash);
             while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
                 if (g_hash_table_contains(rule->hashNOT[p], ikey)) {
@@ -1212,18 +1525,18 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
             }
             break;
         case ARKIME_FIELD_TYPE_STR:
-            good = !g_hash_table_contains(rule->hashNOT[p], session->fields[p]->str);
+            good = !g_hash_table_contains(rule->hashNOT[p], field->str);
             break;
         case ARKIME_FIELD_TYPE_STR_ARRAY:
-            for (int i = 0; i < (int)session->fields[p]->sarray->len; i++) {
-                if (g_hash_table_contains(rule->hashNOT[p], g_ptr_array_index(session->fields[p]->sarray, i))) {
+            for (int i = 0; i < (int)field->sarray->len; i++) {
+                if (g_hash_table_contains(rule->hashNOT[p], g_ptr_array_index(field->sarray, i))) {
                     good = 0;
                     break;
                 }
             }
             break;
         case ARKIME_FIELD_TYPE_STR_HASH:
-            shash = session->fields[p]->shash;
+            shash = field->shash;
             HASH_FORALL2(s_, *shash, hstring) {
                 if (g_hash_table_contains(rule->hashNOT[p], (gpointer)hstring->str)) {
                     good = 0;
@@ -1232,10 +1545,10 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
             }
             break;
         case ARKIME_FIELD_TYPE_INT:
-            good = !g_hash_table_contains(rule->hashNOT[p], (void *)(long)session->fields[p]->i);
+            good = !g_hash_table_contains(rule->hashNOT[p], (void *)(long)field->i);
             break;
         case ARKIME_FIELD_TYPE_INT_ARRAY: {
-            const GArray *iarray = session->fields[p]->iarray;
+            const GArray *iarray = field->iarray;
             for (int i = 0; i < (int)iarray->len; i++) {
                 if (g_hash_table_contains(rule->hashNOT[p], (void *)(long)g_array_index(iarray, uint32_t, i))) {
                     good = 0;
@@ -1246,7 +1559,7 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
         }
 
         case ARKIME_FIELD_TYPE_INT_HASH: {
-            ihash = session->fields[p]->ihash;
+            ihash = field->ihash;
             HASH_FORALL2(i_, *ihash, hint) {
                 if (g_hash_table_contains(rule->hashNOT[p], (void *)(long)hint->i_hash)) {
                     good = 0;
@@ -1257,7 +1570,7 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
         }
 
         case ARKIME_FIELD_TYPE_INT_GHASH: {
-            ghash = session->fields[p]->ghash;
+            ghash = field->ghash;
             g_hash_table_iter_init(&iter, ghash);
             while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
                 if (g_hash_table_contains(rule->hashNOT[p], ikey)) {
@@ -1282,12 +1595,13 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
         // Check count fields
         if (config.fields[p]->cntForPos) {
             int cp = config.fields[p]->cntForPos;
-            if (cp >= session->maxFields) {
+            if (cp >= config.maxDbField) {
                 good = 0;
                 continue;
             }
 
-            if (!session->fields[cp]) {
+            field = arkime_field_get(session, cp);
+            if (!field) {
                 good = arkime_rules_check_int_match(rule, p, 0, logStr);
                 continue;
             }
@@ -1301,27 +1615,27 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
                 break;
             case ARKIME_FIELD_TYPE_INT_ARRAY:
             case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
-                good = arkime_rules_check_int_match(rule, p, session->fields[cp]->iarray->len, logStr);
+                good = arkime_rules_check_int_match(rule, p, field->iarray->len, logStr);
                 break;
             case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
-                good = arkime_rules_check_int_match(rule, p, session->fields[cp]->farray->len, logStr);
+                good = arkime_rules_check_int_match(rule, p, field->farray->len, logStr);
                 break;
             case ARKIME_FIELD_TYPE_INT_HASH:
-                ihash = session->fields[cp]->ihash;
+                ihash = field->ihash;
                 good = arkime_rules_check_int_match(rule, p, HASH_COUNT(i_, *ihash), logStr);
                 break;
             case ARKIME_FIELD_TYPE_IP_GHASH:
             case ARKIME_FIELD_TYPE_FLOAT_GHASH:
             case ARKIME_FIELD_TYPE_STR_GHASH:
             case ARKIME_FIELD_TYPE_INT_GHASH:
-                ghash = session->fields[cp]->ghash;
+                ghash = field->ghash;
                 good = arkime_rules_check_int_match(rule, p, g_hash_table_size(ghash), logStr);
                 break;
             case ARKIME_FIELD_TYPE_STR_ARRAY:
-                good = arkime_rules_check_int_match(rule, p, session->fields[cp]->sarray->len, logStr);
+                good = arkime_rules_check_int_match(rule, p, field->sarray->len, logStr);
                 break;
             case ARKIME_FIELD_TYPE_STR_HASH:
-                shash = session->fields[cp]->shash;
+                shash = field->shash;
                 good = arkime_rules_check_int_match(rule, p, HASH_COUNT(s_, *shash), logStr);
                 break;
             case ARKIME_FIELD_TYPE_OBJECT:
@@ -1398,7 +1712,7 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
         }
 
         // This session doesn't have the field or it isn't set
-        if (p >= session->maxFields || !session->fields[p]) {
+        if (p >= config.maxDbField || !(field = arkime_field_get(session, p))) {
             good = 0;
             continue;
         }
@@ -1406,24 +1720,24 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
         // Check a real field
         switch (config.fields[p]->type) {
         case ARKIME_FIELD_TYPE_IP:
-            good = arkime_rules_check_ip(rule, p, session->fields[p]->ip, logStr);
+            good = arkime_rules_check_ip(rule, p, field->ip, logStr);
             break;
 
         case ARKIME_FIELD_TYPE_INT:
-            good = arkime_rules_check_int_match(rule, p, session->fields[p]->i, logStr);
+            good = arkime_rules_check_int_match(rule, p, field->i, logStr);
             break;
         case ARKIME_FIELD_TYPE_INT_ARRAY:
         case ARKIME_FIELD_TYPE_INT_ARRAY_UNIQUE:
             good = 0;
-            for (int i = 0; i < (int)session->fields[p]->iarray->len; i++) {
-                if (arkime_rules_check_int_match(rule, p, g_array_index(session->fields[p]->iarray, uint32_t, i), logStr)) {
+            for (int i = 0; i < (int)field->iarray->len; i++) {
+                if (arkime_rules_check_int_match(rule, p, g_array_index(field->iarray, uint32_t, i), logStr)) {
                     good = 1;
                     break;
                 }
             }
             break;
         case ARKIME_FIELD_TYPE_INT_HASH:
-            ihash = session->fields[p]->ihash;
+            ihash = field->ihash;
             good = 0;
             HASH_FORALL2(i_, *ihash, hint) {
                 if (arkime_rules_check_int_match(rule, p, hint->i_hash, logStr)) {
@@ -1433,7 +1747,7 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
             }
             break;
         case ARKIME_FIELD_TYPE_INT_GHASH:
-            ghash = session->fields[p]->ghash;
+            ghash = field->ghash;
             g_hash_table_iter_init(&iter, ghash);
             good = 0;
             while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
@@ -1446,21 +1760,21 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
 
         case ARKIME_FIELD_TYPE_FLOAT:
             // ->i aliases ->f in the union, giving the float bit pattern used as hash key
-            good = g_hash_table_contains(rule->hash[p], (gpointer)(long)(uint32_t)session->fields[p]->i);
-            RULE_LOG_FLOAT(session->fields[p]->f);
+            good = g_hash_table_contains(rule->hash[p], (gpointer)(long)(uint32_t)field->i);
+            RULE_LOG_FLOAT(field->f);
             break;
         case ARKIME_FIELD_TYPE_FLOAT_ARRAY:
             good = 0;
-            for (int i = 0; i < (int)session->fields[p]->farray->len; i++) {
-                if (g_hash_table_contains(rule->hash[p], (gpointer)(long)g_array_index(session->fields[p]->farray, uint32_t, i))) {
+            for (int i = 0; i < (int)field->farray->len; i++) {
+                if (g_hash_table_contains(rule->hash[p], (gpointer)(long)g_array_index(field->farray, uint32_t, i))) {
                     good = 1;
-                    RULE_LOG_FLOAT(g_array_index(session->fields[p]->farray, float, i));
+                    RULE_LOG_FLOAT(g_array_index(field->farray, float, i));
                     break;
                 }
             }
             break;
         case ARKIME_FIELD_TYPE_FLOAT_GHASH:
-            ghash = session->fields[p]->ghash;
+            ghash = field->ghash;
             g_hash_table_iter_init(&iter, ghash);
             good = 0;
             while (g_hash_table_iter_next(&iter, &fkey, NULL)) {
@@ -1473,7 +1787,7 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
             break;
 
         case ARKIME_FIELD_TYPE_IP_GHASH:
-            ghash = session->fields[p]->ghash;
+            ghash = field->ghash;
             g_hash_table_iter_init(&iter, ghash);
             good = 0;
             while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
@@ -1484,7 +1798,7 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
             }
             break;
         case ARKIME_FIELD_TYPE_STR_GHASH:
-            ghash = session->fields[p]->ghash;
+            ghash = field->ghash;
             g_hash_table_iter_init(&iter, ghash);
             good = 0;
             while (g_hash_table_iter_next(&iter, &ikey, NULL)) {
@@ -1495,19 +1809,19 @@ LOCAL void arkime_rules_check_rule_fields(ArkimeSession_t *const session, Arkime
             }
             break;
         case ARKIME_FIELD_TYPE_STR:
-            good = arkime_rules_check_str_match(rule, p, session->fields[p]->str, logStr);
+            good = arkime_rules_check_str_match(rule, p, field->str, logStr);
             break;
         case ARKIME_FIELD_TYPE_STR_ARRAY:
             good = 0;
-            for (int i = 0; i < (int)session->fields[p]->sarray->len; i++) {
-                if (arkime_rules_check_str_match(rule, p, g_ptr_array_index(session->fields[p]->sarray, i), logStr)) {
+            for (int i = 0; i < (int)field->sarray->len; i++) {
+                if (arkime_rules_check_str_match(rule, p, g_ptr_array_index(field->sarray, i), logStr)) {
                     good = 1;
                     break;
                 }
             }
             break;
         case ARKIME_FIELD_TYPE_STR_HASH:
-            shash = session->fields[p]->shash;
+            shash = field->shash;
             good = 0;
             HASH_FORALL2(s_, *shash, hstring) {
                 if (arkime_rules_check_str_match(rule, p, (gpointer)hstring->str, logStr)) {
@@ -1554,6 +1868,58 @@ LOCAL void arkime_rules_run_field_set_rules(ArkimeSession_t *session, int pos, G
     }
 }
 /******************************************************************************/
+LOCAL void arkime_rules_run_field_set_str_match(ArkimeSession_t *session, int pos, const ArkimeRulesStrMatch_t *sm, const uint8_t *value, int len)
+{
+    const ArkimeRulesTrieNode_t *nodes;
+    uint32_t                     n;
+
+    // Every node on the walk down from the start with rules is a matching head
+    if ((nodes = sm->head.nodes)) {
+        if (nodes[0].rules)
+            arkime_rules_run_field_set_rules(session, pos, nodes[0].rules);
+        n = 0;
+        for (int i = 0; i < len && (n = arkime_rules_trie_child(&nodes[n], value[i])); i++) {
+            if (nodes[n].rules)
+                arkime_rules_run_field_set_rules(session, pos, nodes[n].rules);
+        }
+    }
+
+    // Same from the end for the reversed tails
+    if ((nodes = sm->tail.nodes)) {
+        if (nodes[0].rules)
+            arkime_rules_run_field_set_rules(session, pos, nodes[0].rules);
+        n = 0;
+        for (int i = len - 1; i >= 0 && (n = arkime_rules_trie_child(&nodes[n], value[i])); i--) {
+            if (nodes[n].rules)
+                arkime_rules_run_field_set_rules(session, pos, nodes[n].rules);
+        }
+    }
+
+    if ((nodes = sm->contains.nodes)) {
+        ArkimeRulesFound_t found;
+        found.cnt = 0;
+        found.hash = NULL;
+
+        if (nodes[0].rules)
+            arkime_rules_run_field_set_rules(session, pos, nodes[0].rules);
+        n = 0;
+        for (int i = 0; i < len; i++) {
+            uint32_t kid;
+            while (!(kid = arkime_rules_trie_child(&nodes[n], value[i])) && n)
+                n = nodes[n].fail;
+            n = kid;
+
+            for (uint32_t m = nodes[n].rules ? n : nodes[n].out; m; m = nodes[m].out) {
+                if (arkime_rules_str_match_first(&found, m))
+                    arkime_rules_run_field_set_rules(session, pos, nodes[m].rules);
+            }
+        }
+
+        if (found.hash)
+            g_hash_table_destroy(found.hash);
+    }
+}
+/******************************************************************************/
 void arkime_rules_run_field_set(ArkimeSession_t *session, int pos, const gpointer value)
 {
     if (ARKIME_FIELD_TYPE_IS_IP(config.fields[pos]->type)) {
@@ -1577,44 +1943,16 @@ void arkime_rules_run_field_set(ArkimeSession_t *session, int pos, const gpointe
         GPtrArray *rules;
 
         // See if this value matches anything in our matching list
-        if (current.fieldsMatch[pos]) {
-            GHashTableIter         iter;
-
-            g_hash_table_iter_init(&iter, current.fieldsMatch[pos]);
-            if (ARKIME_FIELD_TYPE_IS_INT(config.fields[pos]->type)) {
-                uint64_t               num;
-
-                while (g_hash_table_iter_next(&iter, (gpointer *)&num, (gpointer *)&rules)) {
-                    ArkimeRuleIntMatch_t match;
-                    match.num = num;
-                    uint32_t test = (uint32_t)(long)value;
-                    if (test >= match.min && test <= match.max) {
-                        arkime_rules_run_field_set_rules(session, pos, rules);
-                    }
-                }
-            } else {
-                uint8_t               *akey;
-                int                    len = strlen(value);
-
-                while (g_hash_table_iter_next(&iter, (gpointer *)&akey, (gpointer *)&rules)) {
-                    if (len < akey[1])
-                        continue;
-
-                    switch (akey[0]) {
-                    case ARKIME_RULES_STR_MATCH_TAIL:
-                        if (memcmp(akey + 2, (char *)value + len - akey[1], akey[1]) == 0)
-                            arkime_rules_run_field_set_rules(session, pos, rules);
-                        break;
-                    case ARKIME_RULES_STR_MATCH_HEAD:
-                        if (memcmp(akey + 2, (char *)value, akey[1]) == 0)
-                            arkime_rules_run_field_set_rules(session, pos, rules);
-                        break;
-                    case ARKIME_RULES_STR_MATCH_CONTAINS:
-                        if (arkime_memstr((char *)value, len, (char *)akey + 2, akey[1]) != 0)
-                            arkime_rules_run_field_set_rules(session, pos, rules);
-                    }
+        if (current.fieldsRange[pos]) {
+            const ArkimeRulesRangeIndex_t *ri = current.fieldsRange[pos];
+            const int s = arkime_rules_range_find(ri, (uint32_t)(long)value);
+            if (s >= 0) {
+                for (uint32_t r = ri->offsets[s]; r < ri->offsets[s + 1]; r++) {
+                    arkime_rules_run_field_set_rules(session, pos, ri->rules[r]);
                 }
             }
+        } else if (current.fieldsStrMatch[pos]) {
+            arkime_rules_run_field_set_str_match(session, pos, current.fieldsStrMatch[pos], value, strlen(value));
         }
 
         // See if this value is in the hash table of values we are watching for
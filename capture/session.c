@@ -9,6 +9,9 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include "arkime.h"
+#if ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_CTRL_PROBE && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /******************************************************************************/
 extern ArkimeConfig_t        config;
@@ -22,14 +25,24 @@ LOCAL int                   protocolField;
 extern uint32_t             hashSalt;
 
 #if ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_CTRL_PROBE
+// Control bytes are 0x00-0x7f (low 7 bits of hash) for used slots
 #define PROBE_EMPTY   0x80
-#define PROBE_DELETED 0xFF
+#define PROBE_DELETED 0xFE
+// Slots are probed a group at a time, a group's control bytes fit in one SSE2 register
+#define PROBE_GROUP   16
 typedef struct {
     uint8_t *ctrl;
     ArkimeSession_t **sessions;
     uint32_t count;
+    uint32_t deleted;
     uint32_t mask;
     uint32_t size;
+    // Previous table while it is being migrated after a resize
+    uint8_t *oldCtrl;
+    ArkimeSession_t **oldSessions;
+    uint32_t oldMask;
+    uint32_t oldSize;
+    uint32_t migratePos;
 } ArkimeSessionHash_t;
 #elif ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_SLL
 typedef struct {
@@ -37,6 +50,11 @@ typedef struct {
     uint32_t count;
     uint32_t mask;
     uint32_t size;
+    // Previous table while it is being migrated after a resize
+    ArkimeSession_t **oldSessions;
+    uint32_t oldMask;
+    uint32_t oldSize;
+    uint32_t migratePos;
 } ArkimeSessionHash_t;
 #elif ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_DLL
 typedef struct {
@@ -44,9 +62,24 @@ typedef struct {
     uint32_t count;
     uint32_t mask;
     uint32_t size;
+    // Previous table while it is being migrated after a resize
+    ArkimeSessionHead_t *oldBuckets;
+    uint32_t oldMask;
+    uint32_t oldSize;
+    uint32_t migratePos;
 } ArkimeSessionHash_t;
 #endif
 
+/* Resizing doesn't rehash everything at once, the old table is kept and
+ * SESSION_HASH_MIGRATE slots/buckets are moved to the new table on every
+ * find_or_create until it is empty.  Lookups check both tables meanwhile.
+ */
+#define SESSION_HASH_MIGRATE 64
+
+#if ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_CTRL_PROBE
+LOCAL gboolean sessionHashPresize;
+#endif
+
 LOCAL int tcpClosingTimeout;
 
 typedef struct arkimesescmd {
@@ -65,6 +98,8 @@ typedef struct {
     ARKIME_LOCK_EXTERN(lock);
 } ArkimeSesCmdHead_t;
 
+LOCAL ArkimePool_t        *sesCmdPool;
+
 LOCAL char                 stoppedFilename[PATH_MAX];
 
 typedef struct {
@@ -80,7 +115,7 @@ typedef struct {
     } stoppedSessions;
 } ARKIME_CACHE_ALIGN SessionThreadData_t;
 
-LOCAL SessionThreadData_t sessionThreadData[ARKIME_MAX_PACKET_THREADS];
+LOCAL SessionThreadData_t *sessionThreadData;
 
 ArkimeSessionIdTracking sessionIdTracking = ARKIME_TRACKING_NONE;
 GHashTable *collapseTable;
@@ -336,7 +371,7 @@ LOCAL gboolean arkime_session_equal(const uint8_t *a, const uint8_t *b)
 /******************************************************************************/
 void arkime_session_add_cmd(ArkimeSession_t *session, ArkimeSesCmd sesCmd, gpointer uw1, gpointer uw2, ArkimeCmd_func func)
 {
-    ArkimeSesCmd_t *cmd = ARKIME_TYPE_ALLOC(ArkimeSesCmd_t);
+    ArkimeSesCmd_t *cmd = arkime_pool_alloc(sesCmdPool);
     cmd->cmd = sesCmd;
     cmd->session = session;
     cmd->uw1 = uw1;
@@ -350,7 +385,7 @@ void arkime_session_add_cmd(ArkimeSession_t *session, ArkimeSesCmd sesCmd, gpoin
 /******************************************************************************/
 void arkime_session_add_cmd_thread(int thread, gpointer uw1, gpointer uw2, ArkimeCmd_func func)
 {
-    ArkimeSesCmd_t *cmd = ARKIME_TYPE_ALLOC(ArkimeSesCmd_t);
+    ArkimeSesCmd_t *cmd = arkime_pool_alloc(sesCmdPool);
     cmd->cmd = ARKIME_SES_CMD_FUNC;
     cmd->session = NULL;
     cmd->uw1 = uw1;
@@ -370,27 +405,29 @@ void arkime_session_add_protocol(ArkimeSession_t *session, const char *protocol)
 /******************************************************************************/
 gboolean arkime_session_has_protocol(ArkimeSession_t *session, const char *protocol)
 {
-    if (!session->fields[protocolField])
+    const ArkimeField_t     *field = arkime_field_get(session, protocolField);
+    if (!field)
         return FALSE;
 
     ArkimeString_t          *hstring;
-    HASH_FIND(s_, *(session->fields[protocolField]->shash), protocol, hstring);
+    HASH_FIND(s_, *(field->shash), protocol, hstring);
     return hstring != 0;
 }
 /******************************************************************************/
 gboolean arkime_session_rm_protocol(ArkimeSession_t *session, const char *protocol)
 {
-    if (!session->fields[protocolField])
+    const ArkimeField_t     *field = arkime_field_get(session, protocolField);
+    if (!field)
         return FALSE;
 
-    ArkimeStringHashStd_t   *shash = session->fields[protocolField]->shash;
+    ArkimeStringHashStd_t   *shash = field->shash;
     ArkimeString_t          *hstring;
     HASH_FIND(s_, *shash, protocol, hstring);
     if (!hstring)
         return FALSE;
 
     HASH_REMOVE(s_, *shash, hstring);
-    g_free(hstring->str);
+    arkime_field_string_free(session, hstring->str);
     ARKIME_TYPE_FREE(ArkimeString_t, hstring);
     return TRUE;
 }
@@ -435,10 +472,8 @@ LOCAL void arkime_session_free(ArkimeSession_t *session)
         DLL_REMOVE(tcp_, &arkimeThreadData[session->thread].tcpWriteQ, session);
     }
 
-    g_array_free(session->filePosArray, TRUE);
-    if (config.enablePacketLen) {
-        g_array_free(session->fileLenArray, TRUE);
-    }
+    arkime_varint_free(&session->filePosArray);
+    arkime_varint_free(&session->fileLenArray);
     g_array_free(session->fileNumArray, TRUE);
 
     if (session->rootId && session->rootId != GINT_TO_POINTER(1))
@@ -475,113 +510,263 @@ LOCAL void arkime_session_free(ArkimeSession_t *session)
 /******************************************************************************/
 /** CTRL_PROBE Hash Implementation **/
 /******************************************************************************/
+/* Swiss table style, the table is split into groups of PROBE_GROUP slots and
+ * all the control bytes of a group are compared at once.  Groups are probed
+ * quadratically and a lookup stops at the first group with an empty slot.
+ */
 #if ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_CTRL_PROBE
 #define IN_SESSION_TABLE(s) ((s)->ses_slot != 0xffffffff)
+// Resize when 7/8 full, tombstones count as full
+#define SESSION_HASH_FULL(size) ((size) - ((size) >> 3))
+
+#ifdef __SSE2__
+/******************************************************************************/
+// Bit i set if control byte i of the group is h2
+LOCAL inline uint32_t arkime_session_probe_match(const uint8_t *group, uint8_t h2)
+{
+    const __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+}
+/******************************************************************************/
+// Bit i set if slot i of the group is empty or deleted, both have the high bit set
+LOCAL inline uint32_t arkime_session_probe_match_free(const uint8_t *group)
+{
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+}
+#else
+/******************************************************************************/
+LOCAL inline uint32_t arkime_session_probe_match(const uint8_t *group, uint8_t h2)
+{
+    uint32_t m = 0;
+    for (int i = 0; i < PROBE_GROUP; i++) {
+        if (group[i] == h2)
+            m |= 1U << i;
+    }
+    return m;
+}
+/******************************************************************************/
+LOCAL inline uint32_t arkime_session_probe_match_free(const uint8_t *group)
+{
+    uint32_t m = 0;
+    for (int i = 0; i < PROBE_GROUP; i++) {
+        if (group[i] & PROBE_EMPTY)
+            m |= 1U << i;
+    }
+    return m;
+}
+#endif
+/******************************************************************************/
 LOCAL void arkime_session_hash_init(ArkimeSessionHash_t *hash, uint32_t size)
 {
     size = MAX(32, arkime_get_next_powerof2(size));
     hash->ctrl = ARKIME_SIZE_ALLOC("ctrl", size);
     memset(hash->ctrl, PROBE_EMPTY, size);
-    hash->sessions = ARKIME_SIZE_ALLOC0("sessions", sizeof(ArkimeSessionHead_t *) * size);
+    hash->sessions = ARKIME_SIZE_ALLOC0("sessions", sizeof(ArkimeSession_t *) * size);
     hash->size = size;
     hash->mask = size - 1;
     hash->count = 0;
+    hash->deleted = 0;
+    hash->oldCtrl = NULL;
+    hash->oldSessions = NULL;
 }
 /******************************************************************************/
 LOCAL void arkime_session_hash_remove(ArkimeSessionHash_t *hash, ArkimeSession_t *session)
 {
-    hash->ctrl[session->ses_slot] = PROBE_DELETED;
+    const uint32_t s = session->ses_slot;
+
+    // Not migrated yet, still in the old table
+    if (hash->oldCtrl && s >= hash->migratePos && s < hash->oldSize &&
+        hash->oldSessions[s] == session && !(hash->oldCtrl[s] & PROBE_EMPTY)) {
+        hash->oldCtrl[s] = PROBE_DELETED;
+    } else {
+        /* If the group still has an empty slot no lookup has ever needed to
+         * probe past it, so the slot can go straight back to empty.
+         */
+        const uint8_t *group = hash->ctrl + (s & ~(PROBE_GROUP - 1));
+        if (arkime_session_probe_match(group, PROBE_EMPTY)) {
+            hash->ctrl[s] = PROBE_EMPTY;
+        } else {
+            hash->ctrl[s] = PROBE_DELETED;
+            hash->deleted++;
+        }
+    }
     session->ses_slot = 0xffffffff;
     hash->count--;
 }
 /******************************************************************************/
-LOCAL void arkime_session_hash_add(ArkimeSessionHash_t *hash, uint32_t h, ArkimeSession_t *session);
+// Place in the first empty or deleted slot, caller makes sure there is room
+LOCAL void arkime_session_hash_insert(ArkimeSessionHash_t *hash, uint32_t h, ArkimeSession_t *session)
+{
+    const uint32_t gmask = hash->mask / PROBE_GROUP;
+    uint32_t g = (h >> 7) & gmask;
+
+    for (uint32_t i = 0; i <= gmask; i++) {
+        const uint32_t m = arkime_session_probe_match_free(hash->ctrl + g * PROBE_GROUP);
+        if (m) {
+            const uint32_t s = g * PROBE_GROUP + __builtin_ctz(m);
+            if (hash->ctrl[s] == PROBE_DELETED)
+                hash->deleted--;
+            hash->ctrl[s] = (uint8_t)(h & 0x7f);
+            session->ses_slot = s;
+            hash->sessions[s] = session;
+            return;
+        }
+        g = (g + i + 1) & gmask;
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_migrate(ArkimeSessionHash_t *hash, uint32_t max)
+{
+    if (likely(!hash->oldCtrl))
+        return;
+
+    const uint32_t end = MIN(hash->oldSize, hash->migratePos + max);
+    for (uint32_t s = hash->migratePos; s < end; s++) {
+        if (hash->oldCtrl[s] & PROBE_EMPTY)
+            continue;
+        // Leave a tombstone so probes through this slot still work
+        hash->oldCtrl[s] = PROBE_DELETED;
+        arkime_session_hash_insert(hash, hash->oldSessions[s]->ses_hash, hash->oldSessions[s]);
+    }
+    hash->migratePos = end;
+
+    if (end == hash->oldSize) {
+        ARKIME_SIZE_FREE("sessions", hash->oldSessions);
+        ARKIME_SIZE_FREE("ctrl", hash->oldCtrl);
+        hash->oldSessions = NULL;
+        hash->oldCtrl = NULL;
+    }
+}
+/******************************************************************************/
 LOCAL void arkime_session_hash_resize(ArkimeSessionHash_t *hash)
 {
+    // Finish the previous resize first
+    arkime_session_hash_migrate(hash, hash->oldSize);
+
+    // If it is full because of tombstones just rebuild at the same size
+    const uint32_t size = (hash->count >= (hash->size >> 1) + (hash->size >> 2)) ? MAX(1024, hash->size << 1) : hash->size;
     if (config.debug)
-        LOG("Resizing session hash table from %u to %u with %u items", hash->size, hash->size << 1, hash->count);
-    ArkimeSession_t **oldSessions = hash->sessions;
-    uint8_t *oldCtrl = hash->ctrl;
-    const uint32_t oldSize = hash->size;
-    const uint32_t size = MAX(1024, hash->size << 1);
+        LOG("Resizing session hash table from %u to %u with %u items %u deleted", hash->size, size, hash->count, hash->deleted);
+
+    hash->oldSessions = hash->sessions;
+    hash->oldCtrl = hash->ctrl;
+    hash->oldSize = hash->size;
+    hash->oldMask = hash->mask;
+    hash->migratePos = 0;
 
     hash->ctrl = ARKIME_SIZE_ALLOC("ctrl", size);
     memset(hash->ctrl, PROBE_EMPTY, size);
-    hash->sessions = ARKIME_SIZE_ALLOC0("sessions", sizeof(ArkimeSessionHead_t *) * size);
+    hash->sessions = ARKIME_SIZE_ALLOC0("sessions", sizeof(ArkimeSession_t *) * size);
     hash->size = size;
     hash->mask = size - 1;
-    hash->count = 0;
-
-    for (uint32_t s = 0; s < oldSize; s++) {
-        if (oldCtrl[s] & PROBE_EMPTY)
-            continue;
-        arkime_session_hash_add(hash, oldSessions[s]->ses_hash, oldSessions[s]);
-    }
-    ARKIME_SIZE_FREE("sessions", oldSessions);
-    ARKIME_SIZE_FREE("ctrl", oldCtrl);
+    hash->deleted = 0;
 }
 /******************************************************************************/
 LOCAL void arkime_session_hash_add(ArkimeSessionHash_t *hash, uint32_t h, ArkimeSession_t *session)
 {
-    // Resize when 50% full
-    if (hash->count >= hash->size >> 1) {
+    if (hash->count + hash->deleted >= SESSION_HASH_FULL(hash->size)) {
         arkime_session_hash_resize(hash);
     }
 
     session->ses_hash = h;
-    uint32_t s = (h >> 7) & hash->mask;
-    for (uint32_t i = 0; i < hash->size; i++) {
-        if (hash->ctrl[s] & PROBE_EMPTY) {
-            hash->ctrl[s] = (uint8_t)(h & 0x7f);
-            session->ses_slot = s;
-            hash->sessions[s] = session;
-            hash->count++;
-            return;
-        }
-        s = (s + 1) & hash->mask;
-    }
+    arkime_session_hash_insert(hash, h, session);
+    hash->count++;
 }
 /******************************************************************************/
-LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash, uint32_t h, const uint8_t *sessionId)
+LOCAL ArkimeSession_t *arkime_session_hash_probe(const uint8_t *ctrl, ArkimeSession_t *const *sessions, uint32_t mask, uint32_t h, const uint8_t *sessionId)
 {
-    const uint8_t h2 = (uint8_t)(h & 0x7F);
-
-    uint32_t s = (h >> 7) & hash->mask;
-    for (uint32_t i = 0; i < hash->size; i++) {
-        if (hash->ctrl[s] == PROBE_EMPTY) {
-            return NULL;
+    const uint32_t gmask = mask / PROBE_GROUP;
+    const uint8_t  h2 = (uint8_t)(h & 0x7f);
+    uint32_t       g = (h >> 7) & gmask;
+
+    for (uint32_t i = 0; i <= gmask; i++) {
+        const uint8_t *group = ctrl + g * PROBE_GROUP;
+        uint32_t m = arkime_session_probe_match(group, h2);
+        while (m) {
+            ArkimeSession_t *session = sessions[g * PROBE_GROUP + __builtin_ctz(m)];
+            if (h == session->ses_hash && memcmp(sessionId, session->sessionId, sessionId[0]) == 0) {
+                return session;
+            }
+            m &= m - 1;
         }
-        if (h2 == hash->ctrl[s] && h == hash->sessions[s]->ses_hash && memcmp(sessionId, hash->sessions[s]->sessionId, sessionId[0]) == 0) {
-            return hash->sessions[s];
+        if (arkime_session_probe_match(group, PROBE_EMPTY)) {
+            return NULL;
         }
-        s = (s + 1) & hash->mask;
+        g = (g + i + 1) & gmask;
     }
 
     return NULL;
 }
 /******************************************************************************/
+LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash, uint32_t h, const uint8_t *sessionId)
+{
+    ArkimeSession_t *session = arkime_session_hash_probe(hash->ctrl, hash->sessions, hash->mask, h, sessionId);
+
+    if (!session && hash->oldCtrl) {
+        session = arkime_session_hash_probe(hash->oldCtrl, hash->oldSessions, hash->oldMask, h, sessionId);
+    }
+    return session;
+}
+/******************************************************************************/
+LOCAL void arkime_session_flush_close_table(ArkimeSessionHash_t *hash, uint8_t *ctrl, ArkimeSession_t **sessions, uint32_t size)
+{
+    for (uint32_t s = 0; s < size; s++) {
+        if (ctrl[s] & PROBE_EMPTY)
+            continue;
+        ctrl[s] = PROBE_DELETED;
+        if (ctrl == hash->ctrl)
+            hash->deleted++;
+        sessions[s]->ses_slot = 0xffffffff;
+        hash->count--;
+        arkime_session_save(sessions[s]);
+    }
+}
+/******************************************************************************/
 LOCAL void arkime_session_flush_close(ArkimeSession_t *UNUSED(session), gpointer uw1, gpointer UNUSED(uw2))
 {
     int thread = GPOINTER_TO_INT(uw1);
 
     for (int i = 0; i < SESSION_MAX; i++) {
         ArkimeSessionHash_t *hash = &sessionThreadData[thread].sessions[i];
-        for (uint32_t s = 0; s < hash->size; s++) {
-            if (hash->ctrl[s] & PROBE_EMPTY)
-                continue;
-            hash->ctrl[s] = PROBE_DELETED;
-            hash->sessions[s]->ses_slot = 0xffffffff;
-            hash->count--;
-            arkime_session_save(hash->sessions[s]);
+        arkime_session_flush_close_table(hash, hash->ctrl, hash->sessions, hash->size);
+        if (hash->oldCtrl) {
+            arkime_session_flush_close_table(hash, hash->oldCtrl, hash->oldSessions, hash->oldSize);
         }
     }
     arkime_pq_flush(thread);
 }
 /******************************************************************************/
+LOCAL void arkime_session_hash_prefetch(const ArkimeSessionHash_t *hash, uint32_t h, int stage)
+{
+    const uint32_t g = (h >> 7) & (hash->mask / PROBE_GROUP);
+
+    if (stage == 0) {
+        __builtin_prefetch(hash->ctrl + g * PROBE_GROUP);
+        __builtin_prefetch(hash->sessions + g * PROBE_GROUP);
+        return;
+    }
+
+    const uint32_t m = arkime_session_probe_match(hash->ctrl + g * PROBE_GROUP, (uint8_t)(h & 0x7f));
+    if (m) {
+        const ArkimeSession_t *session = hash->sessions[g * PROBE_GROUP + __builtin_ctz(m)];
+        __builtin_prefetch(session);
+        __builtin_prefetch(session->sessionId);
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_free(ArkimeSessionHash_t *hash)
+{
+    arkime_session_hash_migrate(hash, hash->oldSize);
+    ARKIME_SIZE_FREE("sessions", hash->sessions);
+    ARKIME_SIZE_FREE("ctrl", hash->ctrl);
+}
+/******************************************************************************/
 /** SLL Hash Implementation **/
 /******************************************************************************/
 #elif ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_SLL
 #define IN_SESSION_TABLE(s) ((s)->inSessionTable)
+// Resize when there are 4 entries per bucket on average
+#define SESSION_HASH_FULL(size) ((size) << 2)
 LOCAL void arkime_session_hash_init(ArkimeSessionHash_t *hash, uint32_t size)
 {
     size = MAX(32, arkime_get_next_powerof2(size));
@@ -589,53 +774,44 @@ LOCAL void arkime_session_hash_init(ArkimeSessionHash_t *hash, uint32_t size)
     hash->size = size;
     hash->mask = size - 1;
     hash->count = 0;
+    hash->oldSessions = NULL;
 }
 /******************************************************************************/
-LOCAL void arkime_session_hash_remove(ArkimeSessionHash_t *hash, ArkimeSession_t *session)
+/* Which bucket a session is in, the old table is used if that bucket hasn't
+ * been migrated yet.
+ */
+LOCAL ArkimeSession_t **arkime_session_hash_bucket(const ArkimeSessionHash_t *hash, uint32_t h)
 {
-    uint32_t b = session->ses_hash & hash->mask;
-
-    if (hash->sessions[b] == NULL) {
-        return;
-    }
-
-    if (hash->sessions[b] == session) {
-        hash->sessions[b] = session->ses_next;
-        session->inSessionTable = 0;
-        hash->count--;
-        return;
+    if (hash->oldSessions && (h & hash->oldMask) >= hash->migratePos) {
+        return &hash->oldSessions[h & hash->oldMask];
     }
+    return &hash->sessions[h & hash->mask];
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_remove(ArkimeSessionHash_t *hash, ArkimeSession_t *session)
+{
+    ArkimeSession_t **prev = arkime_session_hash_bucket(hash, session->ses_hash);
 
-    ArkimeSession_t *s = hash->sessions[b];
-    while (s->ses_next && s->ses_next != session) {
-        s = s->ses_next;
+    while (*prev && *prev != session) {
+        prev = &(*prev)->ses_next;
     }
 
-    if (!s->ses_next)
+    if (!*prev)
         return;
 
-    s->ses_next = session->ses_next;
+    *prev = session->ses_next;
     session->inSessionTable = 0;
     hash->count--;
 }
 /******************************************************************************/
-LOCAL void arkime_session_hash_resize(ArkimeSessionHash_t *hash)
+LOCAL void arkime_session_hash_migrate(ArkimeSessionHash_t *hash, uint32_t max)
 {
-    if (config.debug)
-        LOG("Resizing session hash table from %u to %u with %u items", hash->size, hash->size << 1, hash->count);
-    ArkimeSession_t **oldSessions = hash->sessions;
-    const uint32_t oldSize = hash->size;
-    const uint32_t size = MAX(1024, hash->size << 1);
-
-    hash->sessions = ARKIME_SIZE_ALLOC0("sessions", sizeof(ArkimeSession_t *) * size);
-    hash->size = size;
-    hash->mask = size - 1;
-
-    for (uint32_t i = 0; i < oldSize; i++) {
-        if (!oldSessions[i])
-            continue;
+    if (likely(!hash->oldSessions))
+        return;
 
-        ArkimeSession_t *session = oldSessions[i], *next;
+    const uint32_t end = MIN(hash->oldSize, hash->migratePos + max);
+    for (uint32_t i = hash->migratePos; i < end; i++) {
+        ArkimeSession_t *session = hash->oldSessions[i], *next;
         while (session) {
             next = session->ses_next;
 
@@ -645,17 +821,42 @@ LOCAL void arkime_session_hash_resize(ArkimeSessionHash_t *hash)
 
             session = next;
         }
+        hash->oldSessions[i] = NULL;
+    }
+    hash->migratePos = end;
+
+    if (end == hash->oldSize) {
+        ARKIME_SIZE_FREE("sessions", hash->oldSessions);
+        hash->oldSessions = NULL;
     }
-    ARKIME_SIZE_FREE("sessions", oldSessions);
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_resize(ArkimeSessionHash_t *hash)
+{
+    // Finish the previous resize first
+    arkime_session_hash_migrate(hash, hash->oldSize);
+
+    if (config.debug)
+        LOG("Resizing session hash table from %u to %u with %u items", hash->size, hash->size << 1, hash->count);
+    const uint32_t size = MAX(1024, hash->size << 1);
+
+    hash->oldSessions = hash->sessions;
+    hash->oldSize = hash->size;
+    hash->oldMask = hash->mask;
+    hash->migratePos = 0;
+
+    hash->sessions = ARKIME_SIZE_ALLOC0("sessions", sizeof(ArkimeSession_t *) * size);
+    hash->size = size;
+    hash->mask = size - 1;
 }
 /******************************************************************************/
 LOCAL void arkime_session_hash_add(ArkimeSessionHash_t *hash, uint32_t h, ArkimeSession_t *session)
 {
-    // Resize when there are 4 entries per bucket on average
-    if (hash->count >= hash->size << 2) {
+    if (hash->count >= SESSION_HASH_FULL(hash->size)) {
         arkime_session_hash_resize(hash);
     }
 
+    // New sessions always go in the new table
     uint32_t b = h & hash->mask;
 
     session->ses_next = hash->sessions[b];
@@ -668,9 +869,7 @@ LOCAL void arkime_session_hash_add(ArkimeSessionHash_t *hash, uint32_t h, Arkime
 /******************************************************************************/
 LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash, uint32_t h, const uint8_t *sessionId)
 {
-    uint32_t b = h & hash->mask;
-
-    ArkimeSession_t *session = hash->sessions[b];
+    ArkimeSession_t *session = hash->sessions[h & hash->mask];
     while (session) {
         if (h == session->ses_hash && memcmp(sessionId, session->sessionId, sessionId[0]) == 0) {
             return session;
@@ -678,33 +877,75 @@ LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash,
         session = session->ses_next;
     }
 
+    if (hash->oldSessions && (h & hash->oldMask) >= hash->migratePos) {
+        session = hash->oldSessions[h & hash->oldMask];
+        while (session) {
+            if (h == session->ses_hash && memcmp(sessionId, session->sessionId, sessionId[0]) == 0) {
+                return session;
+            }
+            session = session->ses_next;
+        }
+    }
+
     return NULL;
 }
 /******************************************************************************/
-LOCAL void arkime_session_flush_close(ArkimeSession_t *session, gpointer uw1, gpointer UNUSED(uw2))
+LOCAL void arkime_session_flush_close_table(ArkimeSessionHash_t *hash, ArkimeSession_t **sessions, uint32_t size)
+{
+    ArkimeSession_t *session;
+
+    for (uint32_t b = 0; b < size; b++) {
+        while (sessions[b]) {
+            session = sessions[b];
+            sessions[b] = session->ses_next;
+            session->ses_next = NULL;
+            hash->count--;
+            session->inSessionTable = 0;
+            arkime_session_save(session);
+        }
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_flush_close(ArkimeSession_t *UNUSED(session), gpointer uw1, gpointer UNUSED(uw2))
 {
     int thread = GPOINTER_TO_INT(uw1);
 
     for (int i = 0; i < SESSION_MAX; i++) {
         ArkimeSessionHash_t *hash = &sessionThreadData[thread].sessions[i];
-        for (uint32_t b = 0; b < hash->size; b++) {
-            while (hash->sessions[b]) {
-                session = hash->sessions[b];
-                hash->sessions[b] = session->ses_next;
-                session->ses_next = NULL;
-                hash->count--;
-                session->inSessionTable = 0;
-                arkime_session_save(session);
-            }
+        arkime_session_flush_close_table(hash, hash->sessions, hash->size);
+        if (hash->oldSessions) {
+            arkime_session_flush_close_table(hash, hash->oldSessions, hash->oldSize);
         }
     }
     arkime_pq_flush(thread);
 }
 /******************************************************************************/
+LOCAL void arkime_session_hash_prefetch(const ArkimeSessionHash_t *hash, uint32_t h, int stage)
+{
+    if (stage == 0) {
+        __builtin_prefetch(&hash->sessions[h & hash->mask]);
+        return;
+    }
+
+    const ArkimeSession_t *session = hash->sessions[h & hash->mask];
+    if (session) {
+        __builtin_prefetch(session);
+        __builtin_prefetch(session->sessionId);
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_free(ArkimeSessionHash_t *hash)
+{
+    arkime_session_hash_migrate(hash, hash->oldSize);
+    ARKIME_SIZE_FREE("sessions", hash->sessions);
+}
+/******************************************************************************/
 /** DLL Hash Implementation **/
 /******************************************************************************/
 #elif ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_DLL
 #define IN_SESSION_TABLE(s) ((s)->ses_next)
+// Resize when there are 4 entries per bucket on average
+#define SESSION_HASH_FULL(size) ((size) << 2)
 LOCAL void arkime_session_hash_init(ArkimeSessionHash_t *hash, uint32_t size)
 {
     size = MAX(32, arkime_get_next_powerof2(size));
@@ -712,53 +953,83 @@ LOCAL void arkime_session_hash_init(ArkimeSessionHash_t *hash, uint32_t size)
     hash->size = size;
     hash->mask = size - 1;
     hash->count = 0;
+    hash->oldBuckets = NULL;
+}
+/******************************************************************************/
+/* Which bucket a session is in, the old table is used if that bucket hasn't
+ * been migrated yet.
+ */
+LOCAL ArkimeSessionHead_t *arkime_session_hash_bucket(const ArkimeSessionHash_t *hash, uint32_t h)
+{
+    if (hash->oldBuckets && (h & hash->oldMask) >= hash->migratePos) {
+        return &hash->oldBuckets[h & hash->oldMask];
+    }
+    return &hash->buckets[h & hash->mask];
 }
 /******************************************************************************/
 LOCAL void arkime_session_hash_remove(ArkimeSessionHash_t *hash, ArkimeSession_t *session)
 {
-    uint32_t b = session->ses_hash & hash->mask;
+    ArkimeSessionHead_t *bucket = arkime_session_hash_bucket(hash, session->ses_hash);
 
-    if (hash->buckets[b].ses_next == NULL)
+    if (bucket->ses_next == NULL)
         return;
 
-    DLL_REMOVE(ses_, &hash->buckets[b], session);
+    DLL_REMOVE(ses_, bucket, session);
     hash->count--;
 }
 /******************************************************************************/
-LOCAL void arkime_session_hash_resize(ArkimeSessionHash_t *hash)
+LOCAL void arkime_session_hash_migrate(ArkimeSessionHash_t *hash, uint32_t max)
 {
-    if (config.debug)
-        LOG("Resizing session hash table from %u to %u with %u items", hash->size, hash->size << 1, hash->count);
-    ArkimeSessionHead_t *oldBuckets = hash->buckets;
-    const uint32_t oldSize = hash->size;
-    const uint32_t size = MAX(1024, hash->size << 1);
-
-    hash->buckets = ARKIME_SIZE_ALLOC0("buckets", sizeof(ArkimeSessionHead_t) * size);
-    hash->size = size;
-    hash->mask = size - 1;
+    if (likely(!hash->oldBuckets))
+        return;
 
-    for (uint32_t i = 0; i < oldSize; i++) {
-        if (oldBuckets[i].ses_next == NULL)
+    const uint32_t end = MIN(hash->oldSize, hash->migratePos + max);
+    for (uint32_t i = hash->migratePos; i < end; i++) {
+        if (hash->oldBuckets[i].ses_next == NULL)
             continue;
 
         ArkimeSession_t *session;
-        while (DLL_POP_HEAD(ses_, &oldBuckets[i], session)) {
+        while (DLL_POP_HEAD(ses_, &hash->oldBuckets[i], session)) {
             uint32_t b2 = session->ses_hash & hash->mask;
             if (hash->buckets[b2].ses_next == NULL)
                 DLL_INIT(ses_, &hash->buckets[b2]);
             DLL_PUSH_HEAD(ses_, &hash->buckets[b2], session);
         }
     }
-    ARKIME_SIZE_FREE("buckets", oldBuckets);
+    hash->migratePos = end;
+
+    if (end == hash->oldSize) {
+        ARKIME_SIZE_FREE("buckets", hash->oldBuckets);
+        hash->oldBuckets = NULL;
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_resize(ArkimeSessionHash_t *hash)
+{
+    // Finish the previous resize first
+    arkime_session_hash_migrate(hash, hash->oldSize);
+
+    if (config.debug)
+        LOG("Resizing session hash table from %u to %u with %u items", hash->size, hash->size << 1, hash->count);
+    const uint32_t size = MAX(1024, hash->size << 1);
+
+    hash->oldBuckets = hash->buckets;
+    hash->oldSize = hash->size;
+    hash->oldMask = hash->mask;
+    hash->migratePos = 0;
+
+    hash->buckets = ARKIME_SIZE_ALLOC0("buckets", sizeof(ArkimeSessionHead_t) * size);
+    hash->size = size;
+    hash->mask = size - 1;
 }
 /******************************************************************************/
 LOCAL void arkime_session_hash_add(ArkimeSessionHash_t *hash, uint32_t h, ArkimeSession_t *session)
 {
-    // Resize when there are 4 entries per bucket on average
-    if (hash->count >= hash->size << 2) {
+    if (hash->count >= SESSION_HASH_FULL(hash->size)) {
         arkime_session_hash_resize(hash);
     }
 
+    // New sessions always go in the new table
     uint32_t b = h & hash->mask;
 
     session->ses_hash = h;
@@ -768,16 +1039,14 @@ LOCAL void arkime_session_hash_add(ArkimeSessionHash_t *hash, uint32_t h, Arkime
     hash->count++;
 }
 /******************************************************************************/
-LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash, uint32_t h, const uint8_t *sessionId)
+LOCAL ArkimeSession_t *arkime_session_hash_find_bucket(ArkimeSessionHead_t *bucket, uint32_t h, const uint8_t *sessionId)
 {
     ArkimeSession_t *session;
 
-    uint32_t b = h & hash->mask;
-
-    if (hash->buckets[b].ses_next == NULL)
+    if (bucket->ses_next == NULL)
         return NULL;
 
-    DLL_FOREACH(ses_, &hash->buckets[b], session) {
+    DLL_FOREACH(ses_, bucket, session) {
         if (h == session->ses_hash && memcmp(sessionId, session->sessionId, sessionId[0]) == 0)
             return session;
     }
@@ -785,23 +1054,65 @@ LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash,
     return NULL;
 }
 /******************************************************************************/
-LOCAL void arkime_session_flush_close(ArkimeSession_t *session, gpointer uw1, gpointer UNUSED(uw2))
+LOCAL ArkimeSession_t *arkime_session_hash_find(const ArkimeSessionHash_t *hash, uint32_t h, const uint8_t *sessionId)
+{
+    ArkimeSession_t *session = arkime_session_hash_find_bucket(&hash->buckets[h & hash->mask], h, sessionId);
+
+    if (!session && hash->oldBuckets && (h & hash->oldMask) >= hash->migratePos) {
+        session = arkime_session_hash_find_bucket(&hash->oldBuckets[h & hash->oldMask], h, sessionId);
+    }
+    return session;
+}
+/******************************************************************************/
+LOCAL void arkime_session_flush_close_table(ArkimeSessionHash_t *hash, ArkimeSessionHead_t *buckets, uint32_t size)
+{
+    ArkimeSession_t *session;
+
+    for (uint32_t b = 0; b < size; b++) {
+        if (buckets[b].ses_next == NULL)
+            continue;
+        while (DLL_POP_HEAD(ses_, &buckets[b], session)) {
+            hash->count--;
+            arkime_session_save(session);
+        }
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_flush_close(ArkimeSession_t *UNUSED(session), gpointer uw1, gpointer UNUSED(uw2))
 {
     int thread = GPOINTER_TO_INT(uw1);
 
     for (int i = 0; i < SESSION_MAX; i++) {
         ArkimeSessionHash_t *hash = &sessionThreadData[thread].sessions[i];
-        for (uint32_t b = 0; b < hash->size; b++) {
-            if (hash->buckets[b].ses_next == NULL)
-                continue;
-            while (DLL_POP_HEAD(ses_, &hash->buckets[b], session)) {
-                hash->count--;
-                arkime_session_save(session);
-            }
+        arkime_session_flush_close_table(hash, hash->buckets, hash->size);
+        if (hash->oldBuckets) {
+            arkime_session_flush_close_table(hash, hash->oldBuckets, hash->oldSize);
         }
     }
     arkime_pq_flush(thread);
 }
+/******************************************************************************/
+LOCAL void arkime_session_hash_prefetch(const ArkimeSessionHash_t *hash, uint32_t h, int stage)
+{
+    const ArkimeSessionHead_t *bucket = &hash->buckets[h & hash->mask];
+
+    if (stage == 0) {
+        __builtin_prefetch(bucket);
+        return;
+    }
+
+    const ArkimeSession_t *session = bucket->ses_next;
+    if (session && session != (ArkimeSession_t *)bucket) {
+        __builtin_prefetch(session);
+        __builtin_prefetch(session->sessionId);
+    }
+}
+/******************************************************************************/
+LOCAL void arkime_session_hash_free(ArkimeSessionHash_t *hash)
+{
+    arkime_session_hash_migrate(hash, hash->oldSize);
+    ARKIME_SIZE_FREE("buckets", hash->buckets);
+}
 #endif
 /******************************************************************************/
 void arkime_session_save(ArkimeSession_t *session)
@@ -865,10 +1176,8 @@ void arkime_session_mid_save(ArkimeSession_t *session, uint32_t tv_sec)
 
     arkime_rules_run_before_save(session, 0);
     arkime_db_save_session(session, FALSE);
-    g_array_set_size(session->filePosArray, 0);
-    if (config.enablePacketLen) {
-        g_array_set_size(session->fileLenArray, 0);
-    }
+    arkime_varint_clear(&session->filePosArray);
+    arkime_varint_clear(&session->fileLenArray);
     g_array_set_size(session->fileNumArray, 0);
     session->lastFileNum = 0;
 
@@ -1096,6 +1405,19 @@ ArkimeSession_t *arkime_session_find(int ses, const uint8_t *sessionId)
     return session;
 }
 /******************************************************************************/
+/* Called by the packet threads before processing a batch of packets, stage 0
+ * prefetches where the session would be in the hash table and stage 1 the
+ * session it points at.  Only a hint, the tables aren't changed.
+ */
+void arkime_session_prefetch(int mProtocol, uint32_t hash, int stage)
+{
+    if (hash == 0)
+        return;
+
+    const int thread = hash % config.packetThreads;
+    arkime_session_hash_prefetch(&sessionThreadData[thread].sessions[mProtocols[mProtocol].ses], hash, stage);
+}
+/******************************************************************************/
 // Should only be used by packet, lots of side effects
 ArkimeSession_t *arkime_session_find_or_create(int mProtocol, uint32_t hash, const uint8_t *sessionId, int *isNew)
 {
@@ -1108,6 +1430,7 @@ ArkimeSession_t *arkime_session_find_or_create(int mProtocol, uint32_t hash, con
     int          thread = hash % config.packetThreads;
     SessionTypes ses = mProtocols[mProtocol].ses;
 
+    arkime_session_hash_migrate(&sessionThreadData[thread].sessions[ses], SESSION_HASH_MIGRATE);
     session = arkime_session_hash_find(&sessionThreadData[thread].sessions[ses], hash, sessionId);
 
     if (session) {
@@ -1129,13 +1452,7 @@ ArkimeSession_t *arkime_session_find_or_create(int mProtocol, uint32_t hash, con
     arkime_session_hash_add(&sessionThreadData[thread].sessions[ses], hash, session);
     DLL_PUSH_TAIL(q_, &sessionThreadData[thread].sessionsQ[session->mProtocol], session);
 
-    session->filePosArray = g_array_sized_new(FALSE, FALSE, sizeof(uint64_t), 100);
-    if (config.enablePacketLen) {
-        session->fileLenArray = g_array_sized_new(FALSE, FALSE, sizeof(uint16_t), 100);
-    }
     session->fileNumArray = g_array_sized_new(FALSE, FALSE, sizeof(uint32_t), 2);
-    session->fields = ARKIME_SIZE_ALLOC0("fields", sizeof(ArkimeField_t *) * config.maxDbField);
-    session->maxFields = config.maxDbField;
     session->thread = thread;
     if (config.numPlugins > 0)
         session->pluginData = ARKIME_SIZE_ALLOC0("pluginData", sizeof(void *) * config.numPlugins);
@@ -1183,7 +1500,7 @@ void arkime_session_process_commands(int thread)
         default:
             LOG("Unknown cmd %d", cmd->cmd);
         }
-        ARKIME_TYPE_FREE(ArkimeSesCmd_t, cmd);
+        arkime_pool_free(sesCmdPool, cmd);
     }
 
     // Closing Q
@@ -1287,6 +1604,105 @@ LOCAL void arkime_session_load_collapse()
     g_strfreev(keys);
 }
 /******************************************************************************/
+LOCAL double arkime_session_bench_ns(const struct timespec *start, uint32_t ops)
+{
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    return ((stop.tv_sec - start->tv_sec) * 1e9 + (stop.tv_nsec - start->tv_nsec)) / ops;
+}
+/******************************************************************************/
+/* Microbenchmark of the compiled in session hash using IPv4 5-tuple session
+ * ids, rebuild with a different ARKIME_SESSION_HASH to compare the variants.
+ * Runs on the main thread with its own table, the packet threads aren't used.
+ */
+LOCAL void arkime_session_cmd_hash_bench(int argc, char **argv, gpointer cc)
+{
+    static const char *variants[] = {"", "sll", "dll", "ctrl_probe"};
+    static const uint16_t serverPorts[] = {443, 80, 53, 22, 25, 8080, 3389, 445};
+    char                  output[1000];
+    BSB                   bsb;
+    struct timespec       start;
+    ArkimeSessionHash_t   hash;
+    uint32_t              found = 0;
+
+    uint32_t num = 200000;
+    if (argc > 1) {
+        num = MIN(10000000, MAX(1000, strtoul(argv[1], NULL, 10)));
+    }
+
+    ArkimeSession_t **sessions = ARKIME_SIZE_ALLOC("bench", sizeof(ArkimeSession_t *) * num);
+    uint8_t          *missIds = ARKIME_SIZE_ALLOC("bench", (size_t)ARKIME_SESSIONID_LEN * num);
+    uint32_t         *missHashes = ARKIME_SIZE_ALLOC("bench", sizeof(uint32_t) * num);
+    uint32_t         *order = ARKIME_SIZE_ALLOC("bench", sizeof(uint32_t) * num);
+
+    // Clients in 10/8 on ephemeral ports talking to a few hundred servers
+    for (uint32_t i = 0; i < num; i++) {
+        sessions[i] = ARKIME_TYPE_ALLOC0(ArkimeSession_t);
+        arkime_session_id(sessions[i]->sessionId,
+                          htonl(0x0a000000 | (i >> 4)), 1024 + random() % 64000,
+                          htonl(0xc0a80000 | (random() % 500)), serverPorts[random() % 8], 0, 0);
+
+        // Same clients to servers that don't exist
+        arkime_session_id(missIds + (size_t)i * ARKIME_SESSIONID_LEN,
+                          htonl(0x0a000000 | (i >> 4)), 1024 + random() % 64000,
+                          htonl(0xac100000 | (random() % 500)), serverPorts[random() % 8], 0, 0);
+        missHashes[i] = arkime_session_hash(missIds + (size_t)i * ARKIME_SESSIONID_LEN);
+
+        order[i] = i;
+    }
+
+    // Lookups happen in packet order, not insert order
+    for (uint32_t i = num - 1; i > 0; i--) {
+        uint32_t j = random() % (i + 1);
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    BSB_INIT(bsb, output, sizeof(output));
+    BSB_EXPORT_sprintf(bsb, "Session hash %s with %u sessions (ns/op)\n", variants[ARKIME_SESSION_HASH], num);
+
+    arkime_session_hash_init(&hash, 32);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < num; i++) {
+        arkime_session_hash_migrate(&hash, SESSION_HASH_MIGRATE);
+        arkime_session_hash_add(&hash, arkime_session_hash(sessions[i]->sessionId), sessions[i]);
+    }
+    BSB_EXPORT_sprintf(bsb, "  insert   %8.1f\n", arkime_session_bench_ns(&start, num));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < num; i++) {
+        const ArkimeSession_t *session = sessions[order[i]];
+        arkime_session_hash_migrate(&hash, SESSION_HASH_MIGRATE);
+        found += arkime_session_hash_find(&hash, arkime_session_hash(session->sessionId), session->sessionId) != NULL;
+    }
+    BSB_EXPORT_sprintf(bsb, "  find hit %8.1f\n", arkime_session_bench_ns(&start, num));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < num; i++) {
+        found += arkime_session_hash_find(&hash, missHashes[i], missIds + (size_t)i * ARKIME_SESSIONID_LEN) != NULL;
+    }
+    BSB_EXPORT_sprintf(bsb, "  find miss%8.1f\n", arkime_session_bench_ns(&start, num));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < num; i++) {
+        arkime_session_hash_remove(&hash, sessions[order[i]]);
+    }
+    BSB_EXPORT_sprintf(bsb, "  remove   %8.1f\n", arkime_session_bench_ns(&start, num));
+    BSB_EXPORT_sprintf(bsb, "  found %u, left %u\n", found, hash.count);
+
+    arkime_session_hash_free(&hash);
+    for (uint32_t i = 0; i < num; i++) {
+        ARKIME_TYPE_FREE(ArkimeSession_t, sessions[i]);
+    }
+    ARKIME_SIZE_FREE("bench", sessions);
+    ARKIME_SIZE_FREE("bench", missIds);
+    ARKIME_SIZE_FREE("bench", missHashes);
+    ARKIME_SIZE_FREE("bench", order);
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+}
+/******************************************************************************/
 void arkime_session_init()
 {
     protocolField = arkime_field_define("general", "termfield",
@@ -1296,6 +1712,7 @@ void arkime_session_init()
                                         (char *)NULL);
 
     tcpClosingTimeout = arkime_config_int(NULL, "tcpClosingTimeout", 5, 1, 255);
+    sesCmdPool = arkime_pool_create("sesCmd", sizeof(ArkimeSesCmd_t));
 
     char *str = arkime_config_str(NULL, "sessionIdTracking", "none");
     if (strcmp(str, "none") == 0) {
@@ -1309,9 +1726,29 @@ void arkime_session_init()
     }
     g_free(str);
 
+    sessionThreadData = arkime_numa_alloc0("sessionThreadData", sizeof(SessionThreadData_t), config.packetThreads);
+
+#if ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_CTRL_PROBE
+    // Size the open addressing tables so maxStreams sessions never cause a resize.
+    // The chained tables are already sized from maxStreams with 4 entries per bucket to spare.
+    sessionHashPresize = arkime_config_boolean(NULL, "sessionHashPresize", FALSE);
+#else
+    if (arkime_config_boolean(NULL, "sessionHashPresize", FALSE)) {
+        LOG("WARNING - sessionHashPresize only applies to the CTRL_PROBE session hash, ignoring");
+    }
+#endif
+
     for (int t = 0; t < config.packetThreads; t++) {
         for (int s = 0; s < SESSION_MAX; s++) {
-            arkime_session_hash_init(&sessionThreadData[t].sessions[s], config.maxStreams[s]);
+            uint32_t size = config.maxStreams[s];
+#if ARKIME_SESSION_HASH == ARKIME_SESSION_HASH_CTRL_PROBE
+            if (sessionHashPresize) {
+                size = arkime_get_next_powerof2(size);
+                while (SESSION_HASH_FULL(size) <= config.maxStreams[s])
+                    size <<= 1;
+            }
+#endif
+            arkime_session_hash_init(&sessionThreadData[t].sessions[s], size);
         }
 
         for (int mProtocol = ARKIME_MPROTOCOL_MIN; mProtocol < ARKIME_MPROTOCOL_MAX; mProtocol++) {
@@ -1333,6 +1770,8 @@ void arkime_session_init()
     arkime_add_can_quit(arkime_session_close_outstanding, "session close outstanding");
     arkime_add_can_quit(arkime_session_need_save_outstanding, "session save outstanding");
 
+    arkime_command_register("session-hash-bench", arkime_session_cmd_hash_bench, "Benchmark the session hash table - session-hash-bench [<sessions>]");
+
     // The stopped-sessions state file persists "stop saving" decisions across
     // restarts. Only write for live captures.
     snprintf(stoppedFilename, sizeof(stoppedFilename), "%s.stoppedsessions", config.nodeName);
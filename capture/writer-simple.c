@@ -2,7 +2,7 @@
 /* writer-simple.c  -- Simple Writer
  *
  * This writer just creates a file per packet thread and queues buffers
- * to be written to disk in a single output thread.
+ * to be written to disk by output threads, one or more per pcapDir device.
  *
  * Copyright 2012-2017 AOL Inc. All rights reserved.
  *
@@ -22,6 +22,10 @@
 #include <math.h>
 #include "openssl/rand.h"
 #include "openssl/evp.h"
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
 
 #ifndef O_NOATIME
 #define O_NOATIME 0
@@ -63,6 +67,12 @@ typedef struct {
     uint8_t              dek[256];
     z_stream             z_strm;
     uint8_t              thread;
+    uint8_t              writer;
+    uint64_t             writeOffset;    // io_uring: where the next buffer goes
+    uint32_t             inflight;       // io_uring: buffers submitted but not completed
+    struct arkimesimple *closingInfo;    // io_uring: last buffer done, close once inflight is 0
+    uint32_t             gzipCrc;        // compress threads: crc32 of the uncompressed data for the gzip trailer
+    uint32_t             gzipLen;        // compress threads: uncompressed length mod 2^32 for the gzip trailer
 #ifdef HAVE_ZSTD
     ZSTD_CStream        *zstd_strm;
     ZSTD_outBuffer       zstd_out;
@@ -77,7 +87,9 @@ typedef struct arkimesimple {
     struct arkimesimple *simple_next, *simple_prev;
     uint8_t             *buf;     // mmap buffer, ARKIME_SIMPLE_BUFSIZE bytes
     ArkimeSimpleFile_t  *file;
+    uint64_t             offset;  // io_uring: where in the file buf is written
     uint32_t             bufpos;  // Where in buf we are writing to
+    uint32_t             total;   // io_uring: bytes of buf being written
     uint8_t              closing; // This is the last block, close file when done
 } ArkimeSimple_t;
 
@@ -87,14 +99,97 @@ typedef struct {
     ARKIME_LOCK_EXTERN(lock);
 } ArkimeSimpleHead_t;
 
-LOCAL  ArkimeSimpleHead_t simpleQ;
-LOCAL  ARKIME_LOCK_DEFINE(simpleQ);
-LOCAL  ARKIME_COND_DEFINE(simpleQ);
+/* Each writer thread has its own queue and handles the files on one pcapDir
+ * device.  All the buffers of a file go to the same writer so they are
+ * encrypted and written in order.
+ */
+#define ARKIME_SIMPLE_MAX_WRITERS 64
+
+#ifdef HAVE_LINUX_IO_URING_H
+#define ARKIME_SIMPLE_URING_MAX   256
+
+// Just the parts of io_uring we need, using the raw syscalls so liburing isn't required
+typedef struct {
+    int                  fd;
+    uint32_t             entries;
+    uint32_t            *sqTail;
+    uint32_t            *sqMask;
+    uint32_t            *sqArray;
+    struct io_uring_sqe *sqes;
+    uint32_t            *cqHead;
+    uint32_t            *cqTail;
+    uint32_t            *cqMask;
+    struct io_uring_cqe *cqes;
+} ArkimeSimpleUring_t;
+#endif
+
+typedef struct {
+    struct arkimesimple *simple_next, *simple_prev;
+    int                  simple_count;
+    ARKIME_LOCK_EXTERN(lock);
+    ARKIME_COND_EXTERN(lock);
+    char                *dirs;
+    dev_t                dev;
+    uint64_t             bytesWritten;
+    uint32_t             notSaved;
+    uint32_t             inflight;
+    int                  num;
+#ifdef HAVE_LINUX_IO_URING_H
+    ArkimeSimpleUring_t *ring;
+#endif
+} ARKIME_CACHE_ALIGN ArkimeSimpleWriter_t;
+
+LOCAL  ArkimeSimpleWriter_t  simpleWriters[ARKIME_SIMPLE_MAX_WRITERS];
+LOCAL  int                   numSimpleWriters;
+LOCAL  uint32_t              simpleWriterNext;
+
+/* With simpleCompressThreads set the packet threads only copy packets into
+ * uncompressed blocks.  Full blocks are compressed by the compression threads
+ * into a zstd frame or raw deflate data ending in a full flush, the same thing
+ * the inline compression writes for each block, and each packet thread copies
+ * its compressed blocks to the output buffers in order.  Where a block starts
+ * in the file isn't known until all the blocks before it are compressed, so
+ * until then the packet positions are kept on a pending list and added to the
+ * sessions later.  Saving a session with pending positions waits for them.
+ */
+#define ARKIME_SIMPLE_JOBS        8
+
+typedef struct arkimesimplejob {
+    struct arkimesimplejob *job_next, *job_prev;
+    uint8_t             *in;
+    uint8_t             *out;
+    uint64_t             seq;     // Block number for this packet thread
+    uint32_t             inLen;
+    uint32_t             outLen;
+    uint32_t             outSize;
+    uint32_t             crc;
+    int                  thread;
+    int                  done;
+} ArkimeSimpleJob_t;
+
+typedef struct {
+    struct arkimesimplejob *job_next, *job_prev;
+    int                  job_count;
+    ARKIME_LOCK_EXTERN(lock);
+    ARKIME_COND_EXTERN(lock);
+} ArkimeSimpleJobHead_t;
+
+typedef struct {
+    ArkimeSession_t     *session;
+    uint64_t             seq;        // Block the packet is in
+    uint32_t             posInBlock;
+    uint32_t             fileNum;    // Set if first packet of the session in this file
+    uint16_t             len;
+} ArkimeSimplePending_t;
+
+LOCAL  ArkimeSimpleJobHead_t compressQ;
+LOCAL  int                   simpleCompressThreads;
 
 enum ArkimeSimpleMode { ARKIME_SIMPLE_NORMAL, ARKIME_SIMPLE_XOR2048, ARKIME_SIMPLE_AES256CTR};
 enum ArkimeDEKMode { ARKIME_DEK_AES192CBC, ARKIME_DEK_AES256GCM };
 
-#define INDEX_FILES_CACHE_SIZE (ARKIME_MAX_PACKET_THREADS-1)
+// Open index files cached per packet thread, each one is a fd
+#define INDEX_FILES_CACHE_SIZE 23
 
 typedef struct {
     ArkimeSimple_t *currentInfo;
@@ -106,9 +201,21 @@ typedef struct {
         int64_t  fileNum;
         FILE    *fp;
     } indexFiles[INDEX_FILES_CACHE_SIZE];
+
+    // Only used with simpleCompressThreads, the job after the submitted ones is being filled
+    ArkimeSimpleJob_t     *jobs;
+    uint64_t               blockSeq;
+    uint32_t               jobFirst;
+    uint32_t               jobCnt;
+    ArkimeSimplePending_t *pending;
+    uint32_t               pendingFirst;
+    uint32_t               pendingCnt;
+    uint32_t               pendingSize;
+    ARKIME_LOCK_EXTERN(jobs);
+    ARKIME_COND_EXTERN(jobs);
 } ARKIME_CACHE_ALIGN SimpleThreadData_t;
 
-LOCAL SimpleThreadData_t simpleThreadData[ARKIME_MAX_PACKET_THREADS];
+LOCAL SimpleThreadData_t *simpleThreadData;
 
 LOCAL ArkimeSimpleHead_t     freeList;
 ARKIME_LOCK_DEFINE(freeList);
@@ -118,6 +225,8 @@ LOCAL enum ArkimeDEKMode     simpleDEKMode;
 LOCAL int                    simpleMaxQ;
 LOCAL const EVP_CIPHER      *cipher;
 LOCAL int                    openOptions;
+LOCAL gboolean               simpleUring;
+LOCAL int                    simpleUringDepth;
 
 /*
  * Compression design inspired by Philip Gladstone and others.
@@ -138,7 +247,11 @@ LOCAL uint32_t simpleCompressionBlockSize; // Max data that we try and compress,
 /******************************************************************************/
 LOCAL uint32_t writer_simple_queue_length()
 {
-    return DLL_COUNT(simple_, &simpleQ);
+    uint32_t count = 0;
+    for (int w = 0; w < numSimpleWriters; w++) {
+        count += DLL_COUNT(simple_, &simpleWriters[w]) + ARKIME_THREAD_ATOMIC_LOAD_RELAXED(simpleWriters[w].inflight);
+    }
+    return count + DLL_COUNT(job_, &compressQ);
 }
 /******************************************************************************/
 /*
@@ -211,8 +324,17 @@ LOCAL void writer_simple_free(ArkimeSimple_t *info)
 }
 
 /******************************************************************************/
+LOCAL void writer_simple_compress_finish(int thread);
 LOCAL ArkimeSimple_t *writer_simple_process_buf(int thread, int closing)
 {
+    // Compression threads already updated file->pos, just need the rest of the blocks
+    ArkimeCompressionMode mode = compressionMode;
+    if (simpleCompressThreads) {
+        if (closing)
+            writer_simple_compress_finish(thread);
+        mode = ARKIME_COMPRESSION_NONE;
+    }
+
     ArkimeSimple_t *info = simpleThreadData[thread].currentInfo;
 
     info->closing = closing;
@@ -227,7 +349,7 @@ LOCAL ArkimeSimple_t *writer_simple_process_buf(int thread, int closing)
         memcpy(ninfo->buf, info->buf + writeSize, info->bufpos - writeSize);
         ninfo->bufpos = info->bufpos - writeSize;
 
-        switch (compressionMode) {
+        switch (mode) {
         case ARKIME_COMPRESSION_GZIP:
             // Start the gzip buffer after what we copied from previous buffer.
             ninfo->file->z_strm.next_out = (Bytef *) ninfo->buf + ninfo->bufpos;
@@ -247,7 +369,7 @@ LOCAL ArkimeSimple_t *writer_simple_process_buf(int thread, int closing)
         // Set what we are going to write
         info->bufpos = writeSize;
 
-        switch (compressionMode) {
+        switch (mode) {
         case ARKIME_COMPRESSION_GZIP:
             info->file->pos += info->bufpos;
             break;
@@ -261,7 +383,7 @@ LOCAL ArkimeSimple_t *writer_simple_process_buf(int thread, int closing)
         }
 
     } else {
-        switch (compressionMode) {
+        switch (mode) {
         case ARKIME_COMPRESSION_GZIP:
             deflate(&info->file->z_strm, Z_FINISH);
             info->bufpos = (uint8_t *)info->file->z_strm.next_out - info->buf;
@@ -280,15 +402,16 @@ LOCAL ArkimeSimple_t *writer_simple_process_buf(int thread, int closing)
         simpleThreadData[thread].currentInfo = NULL; // This will cause a new file to be allocated on next packet
     }
 
-    // Send to write q to actually write to disk
+    // Send to the file's writer q to actually write to disk
     gettimeofday(&simpleThreadData[thread].lastSave, NULL);
-    ARKIME_LOCK(simpleQ);
-    DLL_PUSH_TAIL(simple_, &simpleQ, info);
-    if (DLL_COUNT(simple_, &simpleQ) > 100) {
-        LOG_RATE(60, "WARNING - Disk Q of %d is too large, check the Arkime FAQ about (https://arkime.com/faq#why-am-i-dropping-packets) testing disk speed", DLL_COUNT(simple_, &simpleQ));
+    ArkimeSimpleWriter_t *writer = &simpleWriters[info->file->writer];
+    ARKIME_LOCK(writer->lock);
+    DLL_PUSH_TAIL(simple_, writer, info);
+    if (DLL_COUNT(simple_, writer) > 100) {
+        LOG_RATE(60, "WARNING - Disk Q of %d for %s is too large, check the Arkime FAQ about (https://arkime.com/faq#why-am-i-dropping-packets) testing disk speed", DLL_COUNT(simple_, writer), writer->dirs);
     }
-    ARKIME_COND_SIGNAL(simpleQ);
-    ARKIME_UNLOCK(simpleQ);
+    ARKIME_COND_SIGNAL(writer->lock);
+    ARKIME_UNLOCK(writer->lock);
 
     return simpleThreadData[thread].currentInfo;
 }
@@ -438,6 +561,15 @@ LOCAL void writer_simple_write_output(int thread, const uint8_t *data, int len)
 {
     ArkimeSimple_t *info = simpleThreadData[thread].currentInfo;
 
+    if (simpleCompressThreads) {
+        const SimpleThreadData_t *td = &simpleThreadData[thread];
+        ArkimeSimpleJob_t *job = &td->jobs[(td->jobFirst + td->jobCnt) % ARKIME_SIMPLE_JOBS];
+        memcpy(job->in + info->file->posInBlock, data, len);
+        info->file->posInBlock += len;
+        info->file->packetBytesWritten += len;
+        return;
+    }
+
     switch (compressionMode) {
     case ARKIME_COMPRESSION_NONE:
         memcpy(info->buf + info->bufpos, data, len);
@@ -511,17 +643,293 @@ LOCAL void writer_simple_zstd_make_new_block(int thread)
 #endif
 }
 /******************************************************************************/
-LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacket_t *const packet)
+/* Copy already compressed data to the output buffers */
+LOCAL void writer_simple_compress_append(int thread, const uint8_t *data, uint32_t len)
 {
-    if (DLL_COUNT(simple_, &simpleQ) > simpleMaxQ) {
-        static uint32_t notSaved;
-        notSaved++;
-        LOG_RATE(60, "WARNING - Disk Q of %d is too large and exceeds simpleMaxQ setting so not saving %u packets. Check the Arkime FAQ about (https://arkime.com/faq#why-am-i-dropping-packets) testing disk speed", DLL_COUNT(simple_, &simpleQ), notSaved);
+    while (len > 0) {
+        ArkimeSimple_t *info = simpleThreadData[thread].currentInfo;
+        uint32_t copy = MIN(len, ARKIME_SIMPLE_BUFSIZE - info->bufpos);
+
+        memcpy(info->buf + info->bufpos, data, copy);
+        info->bufpos += copy;
+        info->file->pos += copy;
+        data += copy;
+        len -= copy;
+
+        if (info->bufpos > config.pcapWriteSize) {
+            writer_simple_process_buf(thread, 0);
+        }
+    }
+}
+/******************************************************************************/
+/* Copy the finished blocks to the output oldest first and add the packet
+ * positions that are now known to their sessions.  Waits while more than
+ * maxJobs blocks are still being compressed.
+ */
+LOCAL void writer_simple_compress_collect(int thread, uint32_t maxJobs)
+{
+    SimpleThreadData_t *td = &simpleThreadData[thread];
+
+    while (td->jobCnt > 0) {
+        ArkimeSimpleJob_t *job = &td->jobs[td->jobFirst];
+
+        if (!ARKIME_THREAD_ATOMIC_LOAD(job->done)) {
+            if (td->jobCnt <= maxJobs)
+                return;
+            ARKIME_LOCK(td->jobs);
+            while (!ARKIME_THREAD_ATOMIC_LOAD(job->done)) {
+                ARKIME_COND_WAIT(td->jobs);
+            }
+            ARKIME_UNLOCK(td->jobs);
+        }
+
+        writer_simple_compress_append(thread, job->out, job->outLen);
+
+        ArkimeSimpleFile_t *file = td->currentInfo->file;
+        if (compressionMode == ARKIME_COMPRESSION_GZIP) {
+            file->gzipCrc = crc32_combine(file->gzipCrc, job->crc, job->inLen);
+            file->gzipLen += job->inLen;
+        }
+
+        // The next block starts where this one ended
+        file->blockStart = file->pos;
+        const uint64_t nextSeq = job->seq + 1;
+
+        job->done = 0;
+        td->jobFirst = (td->jobFirst + 1) % ARKIME_SIMPLE_JOBS;
+        td->jobCnt--;
+
+        while (td->pendingCnt > 0 && td->pending[td->pendingFirst].seq <= nextSeq) {
+            ArkimeSimplePending_t *pending = &td->pending[td->pendingFirst];
+            arkime_packet_add_file_pos(pending->session, pending->fileNum, (file->blockStart << uncompressedBits) + pending->posInBlock, pending->len);
+            pending->session->pendingFilePos--;
+            td->pendingFirst = (td->pendingFirst + 1) % td->pendingSize;
+            td->pendingCnt--;
+        }
+    }
+}
+/******************************************************************************/
+/* Hand the block being filled to the compression threads */
+LOCAL void writer_simple_compress_submit(int thread)
+{
+    SimpleThreadData_t *td = &simpleThreadData[thread];
+    ArkimeSimpleFile_t *file = td->currentInfo->file;
+    ArkimeSimpleJob_t  *job = &td->jobs[(td->jobFirst + td->jobCnt) % ARKIME_SIMPLE_JOBS];
+
+    job->inLen = file->posInBlock;
+    job->seq = td->blockSeq++;
+    job->thread = thread;
+    td->jobCnt++;
+    file->posInBlock = 0;
+
+    ARKIME_LOCK(compressQ.lock);
+    DLL_PUSH_TAIL(job_, &compressQ, job);
+    ARKIME_COND_SIGNAL(compressQ.lock);
+    ARKIME_UNLOCK(compressQ.lock);
+
+    // Always need a free job for the next block
+    writer_simple_compress_collect(thread, ARKIME_SIMPLE_JOBS - 1);
+}
+/******************************************************************************/
+/* Last block of the file, wait for everything and add the gzip trailer */
+LOCAL void writer_simple_compress_finish(int thread)
+{
+    if (simpleThreadData[thread].currentInfo->file->posInBlock > 0) {
+        writer_simple_compress_submit(thread);
+    }
+    writer_simple_compress_collect(thread, 0);
+
+    if (compressionMode == ARKIME_COMPRESSION_GZIP) {
+        const ArkimeSimpleFile_t *file = simpleThreadData[thread].currentInfo->file;
+        uint8_t trailer[10];
+
+        // Empty final fixed huffman block, then the crc and length little endian
+        trailer[0] = 0x03;
+        trailer[1] = 0x00;
+        for (int i = 0; i < 4; i++) {
+            trailer[2 + i] = (file->gzipCrc >> (8 * i)) & 0xff;
+            trailer[6 + i] = (file->gzipLen >> (8 * i)) & 0xff;
+        }
+        writer_simple_compress_append(thread, trailer, sizeof(trailer));
+    }
+}
+/******************************************************************************/
+/* Remember a packet position that isn't known yet.  The pending list is a
+ * ring, it only grows when every entry is still waiting for its block.
+ */
+LOCAL void writer_simple_compress_pending(int thread, ArkimeSession_t *session, const ArkimePacket_t *packet)
+{
+    SimpleThreadData_t *td = &simpleThreadData[thread];
+    const ArkimeSimpleFile_t *file = td->currentInfo->file;
+
+    if (td->pendingCnt == td->pendingSize) {
+        const uint32_t oldSize = td->pendingSize;
+        td->pendingSize = oldSize ? oldSize * 2 : 1024;
+        ARKIME_SIZE_REALLOC("simple pending", td->pending, td->pendingSize * sizeof(ArkimeSimplePending_t));
+
+        // Unwrap, the entries before pendingFirst follow the old end
+        if (td->pendingFirst > 0) {
+            memcpy(td->pending + oldSize, td->pending, td->pendingFirst * sizeof(ArkimeSimplePending_t));
+        }
+    }
+
+    ArkimeSimplePending_t *pending = &td->pending[(td->pendingFirst + td->pendingCnt) % td->pendingSize];
+    pending->session = session;
+    pending->seq = td->blockSeq;
+    pending->posInBlock = file->posInBlock;
+    pending->fileNum = session->lastFileNum != file->id ? file->id : 0;
+    pending->len = 16 + packet->pktlen;
+    td->pendingCnt++;
+    session->pendingFilePos++;
+}
+/******************************************************************************/
+/* Called before a session with pending positions is saved, only waits for
+ * the blocks before the session's newest pending packet.
+ */
+LOCAL void writer_simple_flush(ArkimeSession_t *session)
+{
+    SimpleThreadData_t *td = &simpleThreadData[session->thread];
+
+    if (!td->currentInfo)
         return;
+
+    for (uint32_t i = td->pendingCnt; i > 0; i--) {
+        const ArkimeSimplePending_t *pending = &td->pending[(td->pendingFirst + i - 1) % td->pendingSize];
+        if (pending->session == session) {
+            // Positions in block seq are known once every block before it is collected
+            writer_simple_compress_collect(session->thread, td->blockSeq - pending->seq);
+            return;
+        }
+    }
+}
+/******************************************************************************/
+LOCAL void writer_simple_compress_jobs_alloc(int thread)
+{
+    SimpleThreadData_t *td = &simpleThreadData[thread];
+    const uint32_t inSize = simpleCompressionBlockSize + ARKIME_PACKET_MAX_LEN + 16;
+    uint32_t outSize;
+
+#ifdef HAVE_ZSTD
+    if (compressionMode == ARKIME_COMPRESSION_ZSTD)
+        outSize = ZSTD_compressBound(inSize);
+    else
+#endif
+        outSize = compressBound(inSize) + 64;
+
+    td->jobs = ARKIME_SIZE_ALLOC0("simple jobs", sizeof(ArkimeSimpleJob_t) * ARKIME_SIMPLE_JOBS);
+    for (int j = 0; j < ARKIME_SIMPLE_JOBS; j++) {
+        td->jobs[j].in = ARKIME_SIZE_ALLOC("simple job in", inSize);
+        td->jobs[j].out = ARKIME_SIZE_ALLOC("simple job out", outSize);
+        td->jobs[j].outSize = outSize;
+    }
+}
+/******************************************************************************/
+LOCAL void *writer_simple_compress_thread(void *UNUSED(arg))
+{
+    ArkimeSimpleJob_t *job;
+    z_stream           z_strm;
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx         *cctx = NULL;
+#endif
+
+    if (config.debug)
+        LOG("THREAD %p compress", (gpointer)pthread_self());
+
+    memset(&z_strm, 0, sizeof(z_strm));
+    if (compressionMode == ARKIME_COMPRESSION_GZIP) {
+        // Raw deflate, the packet thread writes the gzip header and trailer
+        deflateInit2(&z_strm, simpleGzipLevel, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+    }
+#ifdef HAVE_ZSTD
+    else {
+        cctx = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, simpleZstdLevel);
+    }
+#endif
+
+    while (1) {
+        ARKIME_LOCK(compressQ.lock);
+        while (DLL_COUNT(job_, &compressQ) == 0) {
+            ARKIME_COND_WAIT(compressQ.lock);
+        }
+        DLL_POP_HEAD(job_, &compressQ, job);
+        ARKIME_UNLOCK(compressQ.lock);
+
+        if (compressionMode == ARKIME_COMPRESSION_GZIP) {
+            deflateReset(&z_strm);
+            z_strm.next_in = job->in;
+            z_strm.avail_in = job->inLen;
+            z_strm.next_out = job->out;
+            z_strm.avail_out = job->outSize;
+            while (1) {
+                deflate(&z_strm, Z_FULL_FLUSH);
+                if (z_strm.avail_out != 0)
+                    break;
+                job->outSize *= 2;
+                ARKIME_SIZE_REALLOC("simple job out", job->out, job->outSize);
+                z_strm.next_out = job->out + z_strm.total_out;
+                z_strm.avail_out = job->outSize - z_strm.total_out;
+            }
+            job->outLen = z_strm.total_out;
+            job->crc = crc32(0, job->in, job->inLen);
+        }
+#ifdef HAVE_ZSTD
+        else {
+            size_t rc = ZSTD_compress2(cctx, job->out, job->outSize, job->in, job->inLen);
+            if (ZSTD_isError(rc)) {
+                LOGEXIT("ERROR - zstd compression failed: %s", ZSTD_getErrorName(rc));
+            }
+            job->outLen = rc;
+        }
+#endif
+
+        SimpleThreadData_t *td = &simpleThreadData[job->thread];
+        ARKIME_LOCK(td->jobs);
+        ARKIME_THREAD_ATOMIC_STORE(job->done, 1);
+        ARKIME_COND_SIGNAL(td->jobs);
+        ARKIME_UNLOCK(td->jobs);
+    }
+    return NULL;
+}
+/******************************************************************************/
+/* Pick the writer for a newly opened file from the device it is on, round
+ * robin between the writers of that device.  Files on a device that isn't
+ * one of the pcapDirs (pcapDirTemplate) go round robin between all writers.
+ */
+LOCAL int writer_simple_pick_writer(int fd)
+{
+    struct stat sb;
+    int         first = -1, count = 0;
+
+    if (fstat(fd, &sb) == 0) {
+        for (int w = 0; w < numSimpleWriters; w++) {
+            if (simpleWriters[w].dev == sb.st_dev) {
+                if (first == -1)
+                    first = w;
+                count++;
+            }
+        }
     }
 
+    const uint32_t next = ARKIME_THREAD_INCROLD(simpleWriterNext);
+    if (count == 0)
+        return next % numSimpleWriters;
+    return first + next % count;
+}
+/******************************************************************************/
+LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacket_t *const packet)
+{
     int thread = session->thread;
 
+    if (simpleThreadData[thread].currentInfo) {
+        ArkimeSimpleWriter_t *writer = &simpleWriters[simpleThreadData[thread].currentInfo->file->writer];
+        if (DLL_COUNT(simple_, writer) > simpleMaxQ) {
+            const uint32_t notSaved = ARKIME_THREAD_INCRNEW(writer->notSaved);
+            LOG_RATE(60, "WARNING - Disk Q of %d for %s is too large and exceeds simpleMaxQ setting so not saving %u packets. Check the Arkime FAQ about (https://arkime.com/faq#why-am-i-dropping-packets) testing disk speed", DLL_COUNT(simple_, writer), writer->dirs, notSaved);
+            return;
+        }
+    }
+
     // Need to open a new file
     if (!simpleThreadData[thread].currentInfo) {
         char  dekhex[1024];
@@ -545,10 +953,16 @@ LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacke
         info->file = ARKIME_TYPE_ALLOC0(ArkimeSimpleFile_t);
         info->file->thread = thread;
 
+        if (simpleCompressThreads && !simpleThreadData[thread].jobs) {
+            writer_simple_compress_jobs_alloc(thread);
+        }
+
         switch (compressionMode) {
         case ARKIME_COMPRESSION_GZIP:
             uncompressedBitsArg = (gpointer)(long)uncompressedBits;
             compressionArg = "gzip";
+            if (simpleCompressThreads)
+                break;
 
             info->file->z_strm.next_out = (Bytef *) info->buf;
             info->file->z_strm.avail_out = ARKIME_SIMPLE_BUFSIZE;
@@ -556,10 +970,13 @@ LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacke
             break;
 #ifdef HAVE_ZSTD
         case ARKIME_COMPRESSION_ZSTD:
-            info->file->zstd_strm = ZSTD_createCStream();
-            ZSTD_CCtx_setParameter(info->file->zstd_strm, ZSTD_c_compressionLevel, simpleZstdLevel);
             uncompressedBitsArg = (gpointer)(long)uncompressedBits;
             compressionArg = "zstd";
+            if (simpleCompressThreads)
+                break;
+
+            info->file->zstd_strm = ZSTD_createCStream();
+            ZSTD_CCtx_setParameter(info->file->zstd_strm, ZSTD_c_compressionLevel, simpleZstdLevel);
 
             info->file->zstd_out.dst = info->buf;
             info->file->zstd_out.size = ARKIME_SIMPLE_BUFSIZE;
@@ -659,6 +1076,14 @@ LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacke
         if (simpleThreadData[thread].currentInfo->file->fd < 0) {
             LOGEXIT("ERROR - pcap open failed - Couldn't open file: '%s' with %s (%d) -- You may need to check directory permissions or set pcapWriteMethod=simple-nodirect in config.ini file.  See https://arkime.com/settings#pcapwritemethod", name, strerror(errno), errno);
         }
+        info->file->writer = writer_simple_pick_writer(info->file->fd);
+
+        if (simpleCompressThreads && compressionMode == ARKIME_COMPRESSION_GZIP) {
+            // What deflateInit2 writes for the inline compression
+            static const uint8_t gzipHeader[10] = {0x1f, 0x8b, 0x08, 0, 0, 0, 0, 0, 0, 0x03};
+            writer_simple_compress_append(thread, gzipHeader, sizeof(gzipHeader));
+            info->file->gzipCrc = crc32(0, NULL, 0);
+        }
 
         if (simpleShortHeader) {
             simpleThreadData[thread].firstPacket = packet->ts.tv_sec - 60; // Allow slightly out of sync clocks
@@ -678,7 +1103,9 @@ LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacke
         g_free(name);
 
         // Make a new block for start of packets
-        if (compressionMode == ARKIME_COMPRESSION_GZIP)
+        if (simpleCompressThreads)
+            writer_simple_compress_submit(thread);
+        else if (compressionMode == ARKIME_COMPRESSION_GZIP)
             writer_simple_gzip_make_new_block(thread);
         else if (compressionMode == ARKIME_COMPRESSION_ZSTD)
             writer_simple_zstd_make_new_block(thread);
@@ -693,7 +1120,19 @@ LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacke
         simpleThreadData[thread].currentInfo->file->sessionsPresent++;
     }
 
-    if (compressionMode == ARKIME_COMPRESSION_GZIP) {
+    if (simpleCompressThreads) {
+        writer_simple_compress_collect(thread, ARKIME_SIMPLE_JOBS);
+        if (simpleThreadData[thread].currentInfo->file->posInBlock >= simpleCompressionBlockSize) {
+            writer_simple_compress_submit(thread);
+        }
+
+        if (simpleThreadData[thread].jobCnt == 0) {
+            packet->writerFilePos = (simpleThreadData[thread].currentInfo->file->blockStart << uncompressedBits) + simpleThreadData[thread].currentInfo->file->posInBlock;
+        } else {
+            writer_simple_compress_pending(thread, (ArkimeSession_t *)session, packet);
+            packet->writerFilePos = ARKIME_WRITER_FILE_POS_PENDING;
+        }
+    } else if (compressionMode == ARKIME_COMPRESSION_GZIP) {
         if (simpleThreadData[thread].currentInfo->file->posInBlock >= simpleCompressionBlockSize) {
             writer_simple_gzip_make_new_block(thread);
         }
@@ -747,46 +1186,64 @@ LOCAL void writer_simple_write(const ArkimeSession_t *const session, ArkimePacke
     }
 }
 /******************************************************************************/
-LOCAL void *writer_simple_thread(void *UNUSED(arg))
+/* Encrypt the buffer if needed and return how much of it to write, the last
+ * buffer of a file is padded to a page for O_DIRECT and truncated on close.
+ */
+LOCAL uint32_t writer_simple_prepare(ArkimeSimple_t *info)
 {
-    ArkimeSimple_t *info;
+    uint32_t total = info->bufpos;
+    if (info->closing) {
+        // Round up to next page size
+        if (total % pageSize != 0)
+            total = ((total / pageSize) + 1) * pageSize;
+    }
+
+    switch (simpleMode) {
+    case ARKIME_SIMPLE_NORMAL:
+        break;
+    case ARKIME_SIMPLE_XOR2048: {
+        for (uint32_t i = 0; i < total; i++)
+            info->buf[i] ^= info->file->dek[i % 256];
+        break;
+    }
+    case ARKIME_SIMPLE_AES256CTR: {
+        int outl;
+        if (!EVP_EncryptUpdate(info->file->cipher_ctx, (uint8_t *)info->buf, &outl, (uint8_t *)info->buf, total))
+            LOGEXIT("ERROR - Encrypting data failed");
+        if ((int)total != outl)
+            LOGEXIT("ERROR - Encryption in (%u) and out (%d) didn't match", total, outl);
+        break;
+    }
+    }
+    return total;
+}
+/******************************************************************************/
+LOCAL void writer_simple_file_close(const ArkimeSimpleFile_t *file)
+{
+    if (ftruncate(file->fd, file->pos) < 0 && config.debug)
+        LOG("Truncate failed");
+    close(file->fd);
+    arkime_db_update_file(file->id, file->pos, file->packetBytesWritten, file->packets, &file->lastPacketTime, file->sessionsStarted, file->sessionsPresent);
+}
+/******************************************************************************/
+LOCAL void *writer_simple_thread(void *arg)
+{
+    ArkimeSimpleWriter_t *writer = arg;
+    ArkimeSimple_t       *info;
 
     if (config.debug)
-        LOG("THREAD %p", (gpointer)pthread_self());
+        LOG("THREAD %p writer %d for %s", (gpointer)pthread_self(), writer->num, writer->dirs);
 
     while (1) {
-        ARKIME_LOCK(simpleQ);
-        while (DLL_COUNT(simple_, &simpleQ) == 0) {
-            ARKIME_COND_WAIT(simpleQ);
+        ARKIME_LOCK(writer->lock);
+        while (DLL_COUNT(simple_, writer) == 0) {
+            ARKIME_COND_WAIT(writer->lock);
         }
-        DLL_POP_HEAD(simple_, &simpleQ, info);
-        ARKIME_UNLOCK(simpleQ);
+        DLL_POP_HEAD(simple_, writer, info);
+        ARKIME_UNLOCK(writer->lock);
 
         uint32_t pos = 0;
-        uint32_t total = info->bufpos;
-        if (info->closing) {
-            // Round up to next page size
-            if (total % pageSize != 0)
-                total = ((total / pageSize) + 1) * pageSize;
-        }
-
-        switch (simpleMode) {
-        case ARKIME_SIMPLE_NORMAL:
-            break;
-        case ARKIME_SIMPLE_XOR2048: {
-            for (uint32_t i = 0; i < total; i++)
-                info->buf[i] ^= info->file->dek[i % 256];
-            break;
-        }
-        case ARKIME_SIMPLE_AES256CTR: {
-            int outl;
-            if (!EVP_EncryptUpdate(info->file->cipher_ctx, (uint8_t *)info->buf, &outl, (uint8_t *)info->buf, total))
-                LOGEXIT("ERROR - Encrypting data failed");
-            if ((int)total != outl)
-                LOGEXIT("ERROR - Encryption in (%u) and out (%d) didn't match", total, outl);
-            break;
-        }
-        }
+        uint32_t total = writer_simple_prepare(info);
 
         while (pos < total) {
             int len = write(info->file->fd, info->buf + pos, total - pos);
@@ -796,17 +1253,182 @@ LOCAL void *writer_simple_thread(void *UNUSED(arg))
                 LOGEXIT("ERROR - writing %d %s", len, strerror(errno));
             }
         }
+        writer->bytesWritten += total;
         if (info->closing) {
-            if (ftruncate(info->file->fd, info->file->pos) < 0 && config.debug)
-                LOG("Truncate failed");
-            close(info->file->fd);
-            arkime_db_update_file(info->file->id, info->file->pos, info->file->packetBytesWritten, info->file->packets, &info->file->lastPacketTime, info->file->sessionsStarted, info->file->sessionsPresent);
+            writer_simple_file_close(info->file);
+        }
+
+        writer_simple_free(info);
+    }
+    return NULL;
+}
+#ifdef HAVE_LINUX_IO_URING_H
+/******************************************************************************/
+LOCAL ArkimeSimpleUring_t *writer_simple_uring_create(uint32_t depth)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = syscall(__NR_io_uring_setup, depth, &params);
+    if (fd < 0) {
+        LOG("WARNING - io_uring not available (%s), using write", strerror(errno));
+        return NULL;
+    }
+
+    // IORING_OP_WRITE showed up with IORING_FEAT_RW_CUR_POS in 5.6
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        LOG("WARNING - io_uring is too old, using write");
+        close(fd);
+        return NULL;
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqSize = cqSize = MAX(sqSize, cqSize);
+    }
+
+    uint8_t *sq = mmap(0, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    uint8_t *cq = sq;
+    if (sq != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        cq = mmap(0, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    struct io_uring_sqe *sqes = mmap(0, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+        LOGEXIT("ERROR - Couldn't mmap io_uring: %s", strerror(errno));
+    }
+
+    ArkimeSimpleUring_t *ring = ARKIME_TYPE_ALLOC0(ArkimeSimpleUring_t);
+    ring->fd = fd;
+    ring->entries = MIN(params.sq_entries, ARKIME_SIMPLE_URING_MAX);
+    ring->sqTail = (uint32_t *)(sq + params.sq_off.tail);
+    ring->sqMask = (uint32_t *)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (uint32_t *)(sq + params.sq_off.array);
+    ring->sqes = sqes;
+    ring->cqHead = (uint32_t *)(cq + params.cq_off.head);
+    ring->cqTail = (uint32_t *)(cq + params.cq_off.tail);
+    ring->cqMask = (uint32_t *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return ring;
+}
+/******************************************************************************/
+/* Writes have explicit offsets so several buffers of the same file can be in
+ * flight at once, they are still encrypted in queue order.
+ */
+LOCAL void writer_simple_uring_submit(ArkimeSimpleUring_t *ring, ArkimeSimple_t *info)
+{
+    ArkimeSimpleFile_t *file = info->file;
+
+    info->total = writer_simple_prepare(info);
+    info->offset = file->writeOffset;
+    file->writeOffset += info->total;
+    file->inflight++;
+
+    // Only this thread adds to the sq
+    const uint32_t tail = *ring->sqTail;
+    const uint32_t idx = tail & *ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = file->fd;
+    sqe->addr = (uint64_t)(uintptr_t)info->buf;
+    sqe->len = info->total;
+    sqe->off = info->offset;
+    sqe->user_data = (uint64_t)(uintptr_t)info;
+    ring->sqArray[idx] = idx;
+    ARKIME_THREAD_ATOMIC_STORE(*ring->sqTail, tail + 1);
+}
+/******************************************************************************/
+LOCAL void writer_simple_uring_done(ArkimeSimpleWriter_t *writer, ArkimeSimple_t *info, int res)
+{
+    ArkimeSimpleFile_t *file = info->file;
+
+    if (res < 0) {
+        LOGEXIT("ERROR - writing %d %s", res, strerror(-res));
+    }
+
+    // Finish a short write the slow way
+    for (uint32_t pos = res; pos < info->total;) {
+        ssize_t len = pwrite(file->fd, info->buf + pos, info->total - pos, info->offset + pos);
+        if (len < 0) {
+            LOGEXIT("ERROR - writing %zd %s", len, strerror(errno));
         }
+        pos += len;
+    }
+    writer->bytesWritten += info->total;
+    file->inflight--;
 
+    // The closing buffer can finish before the others, it owns the file so it is freed last
+    if (info->closing) {
+        file->closingInfo = info;
+    } else {
         writer_simple_free(info);
     }
+
+    if (file->closingInfo && file->inflight == 0) {
+        writer_simple_file_close(file);
+        writer_simple_free(file->closingInfo);
+    }
+}
+/******************************************************************************/
+LOCAL void *writer_simple_uring_thread(void *arg)
+{
+    ArkimeSimpleWriter_t *writer = arg;
+    ArkimeSimpleUring_t  *ring = writer->ring;
+    ArkimeSimple_t       *infos[ARKIME_SIMPLE_URING_MAX];
+    uint32_t              unsubmitted = 0; // In the sq but not taken by the kernel yet, counted in inflight
+
+    if (config.debug)
+        LOG("THREAD %p io_uring writer %d depth %u for %s", (gpointer)pthread_self(), writer->num, ring->entries, writer->dirs);
+
+    while (1) {
+        uint32_t cnt = 0;
+
+        ARKIME_LOCK(writer->lock);
+        while (writer->inflight == 0 && DLL_COUNT(simple_, writer) == 0) {
+            ARKIME_COND_WAIT(writer->lock);
+        }
+        while (writer->inflight + cnt < ring->entries && DLL_POP_HEAD(simple_, writer, infos[cnt])) {
+            cnt++;
+        }
+        // Counted as queued until written so writer_simple_exit waits for them
+        ARKIME_THREAD_ATOMIC_STORE_RELAXED(writer->inflight, writer->inflight + cnt);
+        ARKIME_UNLOCK(writer->lock);
+
+        for (uint32_t i = 0; i < cnt; i++) {
+            writer_simple_uring_submit(ring, infos[i]);
+        }
+        unsubmitted += cnt;
+
+        // Submit everything the kernel hasn't taken yet, if nothing new was queued wait for a write to finish.
+        // The kernel can take fewer than asked, the rest stay in the sq and are passed again next time.
+        const uint32_t wait = cnt == 0 ? 1 : 0;
+        long rc;
+        while ((rc = syscall(__NR_io_uring_enter, ring->fd, unsubmitted, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0)) < 0 && errno == EINTR);
+        if (rc >= 0) {
+            unsubmitted -= rc;
+        } else if (errno == EAGAIN) {
+            // Kernel is short on memory, back off and retry
+            usleep(1000);
+        } else if (errno != EBUSY) {
+            // EBUSY is a full cq, reaping below makes room
+            LOGEXIT("ERROR - io_uring_enter failed %s", strerror(errno));
+        }
+
+        uint32_t head = *ring->cqHead;
+        while (head != ARKIME_THREAD_ATOMIC_LOAD(*ring->cqTail)) {
+            const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+            ArkimeSimple_t *info = (ArkimeSimple_t *)(uintptr_t)cqe->user_data;
+            const int res = cqe->res;
+            head++;
+            ARKIME_THREAD_ATOMIC_STORE(*ring->cqHead, head);
+            writer_simple_uring_done(writer, info, res);
+            ARKIME_THREAD_ATOMIC_STORE_RELAXED(writer->inflight, writer->inflight - 1);
+        }
+    }
     return NULL;
 }
+#endif
 /******************************************************************************/
 LOCAL void writer_simple_exit()
 {
@@ -839,6 +1461,11 @@ LOCAL void writer_simple_check(ArkimeSession_t *UNUSED(session), gpointer uw1, g
 
     const int thread = GPOINTER_TO_INT(uw1);
 
+    // Copy any blocks finished since the last packet
+    if (simpleCompressThreads && simpleThreadData[thread].currentInfo) {
+        writer_simple_compress_collect(thread, ARKIME_SIMPLE_JOBS);
+    }
+
     // No data or not enough bytes, reset the time
     if (!simpleThreadData[thread].currentInfo || simpleThreadData[thread].currentInfo->bufpos < (uint32_t)pageSize) {
         simpleThreadData[thread].lastSave = now;
@@ -921,8 +1548,9 @@ LOCAL void writer_simple_index(ArkimeSession_t *session)
     FILE *fp = 0;
     uint64_t last = 0;
     uint64_t lastgap = 0;
-    for (guint i = 0; i < session->filePosArray->len; i++) {
-        int64_t packetPos = (int64_t)g_array_index(session->filePosArray, int64_t, i);
+    uint32_t off = 0;
+    int64_t  packetPos = 0;
+    while (arkime_varint_next(&session->filePosArray, &off, &packetPos)) {
         if (packetPos < 0) {
             if (files >= 340) {
                 LOG("WARNING - session has too many file rotations (%d), truncating index", files);
@@ -1002,8 +1630,86 @@ LOCAL void writer_simple_index(ArkimeSession_t *session)
         fwrite(buf, BSB_LENGTH(bsb), 1, fp);
     }
 
-    g_array_set_size(session->filePosArray, 0);
-    g_array_append_vals(session->filePosArray, filePos, files * 3);
+    arkime_varint_clear(&session->filePosArray);
+    for (int i = 0; i < files * 3; i++) {
+        arkime_varint_append(&session->filePosArray, filePos[i]);
+    }
+}
+/******************************************************************************/
+LOCAL void writer_simple_cmd_stats(int UNUSED(argc), char **UNUSED(argv), gpointer cc)
+{
+    BSB bsb;
+    char *output = g_malloc(2000 + numSimpleWriters * 300);
+    BSB_INIT(bsb, output, 2000 + numSimpleWriters * 300);
+
+    BSB_EXPORT_sprintf(bsb, "%-6s %8s %12s %16s  %s\n", "Writer", "Queue", "Not Saved", "Bytes Written", "Dirs");
+    for (int w = 0; w < numSimpleWriters; w++) {
+        const ArkimeSimpleWriter_t *writer = &simpleWriters[w];
+        BSB_EXPORT_sprintf(bsb, "%-6d %8d %12u %16" PRIu64 "  %.200s\n",
+                           w, DLL_COUNT(simple_, writer), writer->notSaved, writer->bytesWritten, writer->dirs);
+    }
+    if (simpleCompressThreads) {
+        BSB_EXPORT_sprintf(bsb, "\nCompress Threads: %d Queue: %d\n", simpleCompressThreads, DLL_COUNT(job_, &compressQ));
+    }
+
+    arkime_command_respond(cc, output, BSB_LENGTH(bsb));
+    g_free(output);
+}
+/******************************************************************************/
+/* One group of simpleWriterThreads writers per distinct pcapDir device */
+LOCAL void writer_simple_writers_init()
+{
+    int threadsPerDevice = arkime_config_int(NULL, "simpleWriterThreads", 1, 1, 16);
+
+    for (int i = 0; config.pcapDir[i]; i++) {
+        struct stat sb;
+        if (stat(config.pcapDir[i], &sb) != 0) {
+            sb.st_dev = 0;
+        }
+
+        int found = 0;
+        for (int w = 0; w < numSimpleWriters; w++) {
+            if (simpleWriters[w].dev == sb.st_dev) {
+                char *dirs = g_strconcat(simpleWriters[w].dirs, ",", config.pcapDir[i], NULL);
+                g_free(simpleWriters[w].dirs);
+                simpleWriters[w].dirs = dirs;
+                found = 1;
+            }
+        }
+        if (found)
+            continue;
+
+        if (numSimpleWriters + threadsPerDevice > ARKIME_SIMPLE_MAX_WRITERS) {
+            LOG("WARNING - Too many pcapDir devices, %s will share writers", config.pcapDir[i]);
+            continue;
+        }
+
+        for (int t = 0; t < threadsPerDevice; t++) {
+            ArkimeSimpleWriter_t *writer = &simpleWriters[numSimpleWriters];
+            DLL_INIT(simple_, writer);
+            ARKIME_LOCK_INIT(writer->lock);
+            ARKIME_COND_INIT(writer->lock);
+            writer->dirs = g_strdup(config.pcapDir[i]);
+            writer->dev = sb.st_dev;
+            writer->num = numSimpleWriters;
+            numSimpleWriters++;
+        }
+    }
+
+    for (int w = 0; w < numSimpleWriters; w++) {
+        char name[100];
+        snprintf(name, sizeof(name), "arkime-simple%d", w);
+#ifdef HAVE_LINUX_IO_URING_H
+        if (simpleUring && (simpleWriters[w].ring = writer_simple_uring_create(simpleUringDepth))) {
+            g_thread_unref(g_thread_new(name, &writer_simple_uring_thread, &simpleWriters[w]));
+            continue;
+        }
+#endif
+        g_thread_unref(g_thread_new(name, &writer_simple_thread, &simpleWriters[w]));
+    }
+
+    if (config.debug)
+        LOG("Using %d simple writer threads", numSimpleWriters);
 }
 /******************************************************************************/
 void writer_simple_init(const char *name)
@@ -1012,7 +1718,7 @@ void writer_simple_init(const char *name)
     arkime_writer_exit         = writer_simple_exit;
     arkime_writer_write        = writer_simple_write;
 
-    arkime_config_check("simple", "simpleKEKId", "simpleMaxQ", "simpleEncoding", "simpleDEKEncoding", "simpleCompression", "simpleGzipLevel", "simpleZstdLevel", "simpleCompressionBlockSize", "simpleShortHeader", "simpleFreeOutputBuffers", NULL);
+    arkime_config_check("simple", "simpleKEKId", "simpleMaxQ", "simpleEncoding", "simpleDEKEncoding", "simpleCompression", "simpleGzipLevel", "simpleZstdLevel", "simpleCompressionBlockSize", "simpleShortHeader", "simpleFreeOutputBuffers", "simpleWriterThreads", "simpleUringDepth", "simpleCompressThreads", NULL);
 
     simpleMaxQ = arkime_config_int(NULL, "simpleMaxQ", 2000, 50, 0xffff);
     char *mode = arkime_config_str(NULL, "simpleEncoding", NULL);
@@ -1050,8 +1756,10 @@ void writer_simple_init(const char *name)
             LOG("INFO: Resetting pcapWriteSize to %u, so it is larger than simpleCompressionBlockSize", config.pcapWriteSize);
         }
 
+        simpleCompressThreads = arkime_config_int(NULL, "simpleCompressThreads", 0, 0, 64);
+
         if (config.debug)
-            LOG("Will compress - blocksize: %u bits: %d", simpleCompressionBlockSize, uncompressedBits);
+            LOG("Will compress - blocksize: %u bits: %d threads: %d", simpleCompressionBlockSize, uncompressedBits, simpleCompressThreads);
     }
 
     if (mode == NULL || !mode[0]) {
@@ -1096,7 +1804,17 @@ void writer_simple_init(const char *name)
 #ifdef O_EXCL
     openOptions |= O_EXCL;
 #endif
-    if (strcmp(name, "simple") == 0) {
+
+    if (strcmp(name, "simple-uring") == 0) {
+#ifdef HAVE_LINUX_IO_URING_H
+        simpleUring = TRUE;
+        simpleUringDepth = arkime_config_int(NULL, "simpleUringDepth", 8, 2, ARKIME_SIMPLE_URING_MAX);
+#else
+        LOG("WARNING - Arkime capture was not compiled with io_uring support, using simple");
+#endif
+    }
+
+    if (strcmp(name, "simple") == 0 || strcmp(name, "simple-uring") == 0) {
 #ifdef O_DIRECT
         openOptions |= O_DIRECT;
 #else
@@ -1130,18 +1848,34 @@ void writer_simple_init(const char *name)
 
     simpleFreeOutputBuffers  = arkime_config_int(NULL, "simpleFreeOutputBuffers", 16, 0, 0xffff);
 
-    DLL_INIT(simple_, &simpleQ);
     DLL_INIT(simple_, &freeList);
 
+    simpleThreadData = arkime_numa_alloc0("simpleThreadData", sizeof(SimpleThreadData_t), config.packetThreads);
+
     struct timeval now;
     gettimeofday(&now, NULL);
 
     for (int thread = 0; thread < config.packetThreads; thread++) {
         simpleThreadData[thread].lastSave = now;
         simpleThreadData[thread].fileAge = now;
+        ARKIME_LOCK_INIT(simpleThreadData[thread].jobs);
+        ARKIME_COND_INIT(simpleThreadData[thread].jobs);
+    }
+
+    if (simpleCompressThreads) {
+        DLL_INIT(job_, &compressQ);
+        ARKIME_LOCK_INIT(compressQ.lock);
+        ARKIME_COND_INIT(compressQ.lock);
+        for (int t = 0; t < simpleCompressThreads; t++) {
+            char name[100];
+            snprintf(name, sizeof(name), "arkime-compress%d", t);
+            g_thread_unref(g_thread_new(name, &writer_simple_compress_thread, NULL));
+        }
+        arkime_writer_flush = writer_simple_flush;
     }
 
-    g_thread_unref(g_thread_new("arkime-simple", &writer_simple_thread, NULL));
+    writer_simple_writers_init();
+    arkime_command_register("simple-stats", writer_simple_cmd_stats, "Simple pcap writer queues per pcapDir device");
 
     g_timeout_add_seconds(1, writer_simple_check_gfunc, 0);
 }
@@ -13,6 +13,7 @@ ArkimeWriterQueueLength arkime_writer_queue_length;
 ArkimeWriterWrite arkime_writer_write;
 ArkimeWriterExit arkime_writer_exit;
 ArkimeWriterIndex arkime_writer_index;
+ArkimeWriterFlush arkime_writer_flush;
 
 /******************************************************************************/
 extern ArkimeConfig_t        config;
@@ -56,4 +57,5 @@ void arkime_writers_init()
     arkime_writers_add("inplace", writer_inplace_init);
     arkime_writers_add("simple", writer_simple_init);
     arkime_writers_add("simple-nodirect", writer_simple_init);
+    arkime_writers_add("simple-uring", writer_simple_init);
 }